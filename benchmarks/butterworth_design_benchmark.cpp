@@ -0,0 +1,80 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+// Butterworth design time: expansion of the poles into the denominator, complex Vieta against conjugate pairs in real arithmetic.
+
+#include "benchmark_helper.h"
+#include "difi"
+#include <complex>
+#include <cstdio>
+
+namespace {
+
+constexpr const int NR_DESIGNS = 10000;
+
+// Butterworth-like digital poles: conjugate pairs and a real pole for odd orders
+difi::vectXc_t<double> poles(int order)
+{
+    difi::vectXc_t<double> p(order);
+    for (int k = 0; k < order; ++k) {
+        const double theta = difi::pi<double> * (2. * k + order + 1.) / (2. * order);
+        const std::complex<double> s = 0.3 * std::polar(1., theta);
+        p(k) = (1. + s) / (1. - s);
+    }
+    if (order % 2 == 1)
+        p(order / 2) = p(order / 2).real();
+    return p;
+}
+
+} // namespace
+
+int main()
+{
+    std::printf("Denominator of a Butterworth filter, %d designs\n", NR_DESIGNS);
+    std::printf("%-8s %20s %20s %20s\n", "order", "complex Vieta", "conjugate pairs", "Butterworth(order)");
+    for (int order : { 4, 8, 16, 32, 64 }) {
+        const difi::vectXc_t<double> p = poles(order);
+        const double complexVieta = bench::medianTimeNs([&]() {
+            for (int i = 0; i < NR_DESIGNS; ++i) {
+                const difi::vectXc_t<double> c = difi::VietaAlgo<std::complex<double>>::polyCoeffFromRoot(p);
+                difi::vectX_t<double> a(c.size());
+                for (Eigen::Index k = 0; k < c.size(); ++k)
+                    a(k) = c(k).real();
+                bench::doNotOptimize(a(order));
+            }
+        });
+        const double conjugatePairs = bench::medianTimeNs([&]() {
+            for (int i = 0; i < NR_DESIGNS; ++i)
+                bench::doNotOptimize(difi::polyCoeffFromConjugateRoots(p)(order));
+        });
+        const double design = bench::medianTimeNs([&]() {
+            for (int i = 0; i < NR_DESIGNS; ++i)
+                bench::doNotOptimize(difi::Butterworthd(order, 10, 1000).aCoeff()(order));
+        });
+        std::printf("%-8d %17.1f ns %17.1f ns %17.1f ns\n", order, complexVieta / NR_DESIGNS, conjugatePairs / NR_DESIGNS, design / NR_DESIGNS);
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+// Moving average -> Butterworth -> centered differentiator, stage by stage or fused in a Cascade.
+
+#include "benchmark_helper.h"
+#include "difi"
+#include <cstdio>
+
+namespace {
+
+constexpr const int NR_SAMPLES = 200000;
+
+} // namespace
+
+int main()
+{
+    difi::MovingAveraged ma(5);
+    difi::Butterworthd bf(4, 50, 1000);
+    difi::CenteredDiffNoiseRobust2d<9> cd;
+    auto chain = ma | bf | cd;
+    const Eigen::VectorXd signal = Eigen::VectorXd::Random(NR_SAMPLES);
+
+    const double separateSteps = bench::medianTimeNs([&]() {
+        for (Eigen::Index i = 0; i < signal.size(); ++i)
+            bench::doNotOptimize(cd.stepFilter(bf.stepFilter(ma.stepFilter(signal(i)))));
+    });
+    const double fusedSteps = bench::medianTimeNs([&]() {
+        for (Eigen::Index i = 0; i < signal.size(); ++i)
+            bench::doNotOptimize(chain.stepFilter(signal(i)));
+    });
+    const double separateBlocks = bench::medianTimeNs([&]() {
+        bench::doNotOptimize(cd.filter(bf.filter(ma.filter(signal))));
+    });
+    const double fusedBlock = bench::medianTimeNs([&]() {
+        bench::doNotOptimize(chain.filter(signal));
+    });
+
+    std::printf("MovingAverage(5) | Butterworth(4) | CenteredDiffNoiseRobust2<9>, %d samples\n", NR_SAMPLES);
+    std::printf("%-28s %8.2f ns/sample\n", "3 x stepFilter", separateSteps / NR_SAMPLES);
+    std::printf("%-28s %8.2f ns/sample\n", "Cascade::stepFilter", fusedSteps / NR_SAMPLES);
+    std::printf("%-28s %8.2f ns/sample\n", "3 x filter", separateBlocks / NR_SAMPLES);
+    std::printf("%-28s %8.2f ns/sample\n", "Cascade::filter", fusedBlock / NR_SAMPLES);
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+// Anti-alias filtering followed by keeping one sample out of 10, against the fused Decimator.
+
+#include "benchmark_helper.h"
+#include "difi"
+#include <cstdio>
+
+namespace {
+
+constexpr const int NR_SAMPLES = 200000;
+constexpr const int FACTOR = 10;
+
+template <typename Filter>
+void compare(const char* name, Filter& filter, const Eigen::VectorXd& signal)
+{
+    difi::Decimatord decimator(filter, FACTOR);
+    const double separate = bench::medianTimeNs([&]() {
+        for (Eigen::Index i = 0; i < signal.size(); ++i) {
+            const double y = filter.stepFilter(signal(i));
+            if (i % FACTOR == 0)
+                bench::doNotOptimize(y);
+        }
+    });
+    const double fused = bench::medianTimeNs([&]() {
+        double y;
+        for (Eigen::Index i = 0; i < signal.size(); ++i) {
+            if (decimator.stepFilter(signal(i), y))
+                bench::doNotOptimize(y);
+        }
+    });
+    std::printf("%-20s %10.2f ns/sample %10.2f ns/sample\n", name, separate / NR_SAMPLES, fused / NR_SAMPLES);
+}
+
+} // namespace
+
+int main()
+{
+    const Eigen::VectorXd signal = Eigen::VectorXd::Random(NR_SAMPLES);
+    difi::Butterworthd bf(6, 40, 1000);
+    difi::MovingAveraged ma(50);
+
+    std::printf("Downsampling by %d, %d samples\n", FACTOR, NR_SAMPLES);
+    std::printf("%-20s %20s %20s\n", "anti-alias filter", "filter + drop", "Decimator");
+    compare("Butterworth(6)", bf, signal);
+    compare("MovingAverage(50)", ma, signal);
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+// Latency of a Butterworth filter whose input goes silent.
+// Without protection, the filter state decays into denormal numbers and each step becomes much slower.
+
+#include "benchmark_helper.h"
+#include "difi"
+#include <cstdio>
+#include <string>
+
+namespace {
+
+constexpr const int NR_SAMPLES = 200000;
+constexpr const int ORDER = 8;
+
+template <typename T>
+double silentStepNs(bool flush)
+{
+    difi::Butterworth<T> bf(ORDER, T(10), T(1000));
+    bf.setFlushDenormals(flush);
+    return bench::medianTimeNs([&]() {
+        bf.resetFilter();
+        bf.stepFilter(T(1));
+        // Let the impulse response decay into the denormal range before measuring
+        for (int i = 0; i < 20000; ++i)
+            bench::doNotOptimize(bf.stepFilter(T(0)));
+        for (int i = 0; i < NR_SAMPLES; ++i)
+            bench::doNotOptimize(bf.stepFilter(T(0)));
+    }) / (NR_SAMPLES + 20001);
+}
+
+template <typename T>
+double silentBatchNs()
+{
+    difi::Butterworth<T> bf(ORDER, T(10), T(1000));
+    difi::vectX_t<T> signal = difi::vectX_t<T>::Zero(NR_SAMPLES);
+    signal(0) = T(1);
+    return bench::medianTimeNs([&]() {
+        bf.resetFilter();
+        bench::doNotOptimize(bf.filter(signal));
+    }) / NR_SAMPLES;
+}
+
+template <typename T>
+void run(const std::string& name)
+{
+    std::printf("%-8s %-24s %10.2f ns/sample\n", name.c_str(), "stepFilter", silentStepNs<T>(false));
+    std::printf("%-8s %-24s %10.2f ns/sample\n", name.c_str(), "stepFilter + flush", silentStepNs<T>(true));
+    std::printf("%-8s %-24s %10.2f ns/sample\n", name.c_str(), "filter (FTZ/DAZ guard)", silentBatchNs<T>());
+}
+
+} // namespace
+
+int main()
+{
+    std::printf("Butterworth low-pass order %d, impulse followed by silence\n", ORDER);
+    std::printf("FTZ/DAZ supported: %s\n", difi::ScopedDenormalGuard::isSupported() ? "yes" : "no");
+    run<float>("float");
+    run<double>("double");
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+// Time of a tick of a bank of 200k independent filters, sequential and on a thread pool.
+
+#include "benchmark_helper.h"
+#include "difi"
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr const int NR_FILTERS = 200000;
+constexpr const int NR_TICKS = 100;
+
+double tickUs(std::size_t nrThreads)
+{
+    difi::Butterworthd bf(4, 10, 1000);
+    std::vector<difi::DigitalFilterd> filters(NR_FILTERS, difi::DigitalFilterd(bf.coefficients(), bf.type()));
+    difi::FilterBankOptions options;
+    options.nrThreads = nrThreads;
+    difi::FilterBankd bank(filters, options);
+    Eigen::VectorXd inputs = Eigen::VectorXd::Random(NR_FILTERS);
+    Eigen::VectorXd outputs(NR_FILTERS);
+    return bench::medianTimeNs([&]() {
+        for (int i = 0; i < NR_TICKS; ++i)
+            bank.step(inputs, outputs);
+        bench::doNotOptimize(outputs(0));
+    }) / NR_TICKS / 1000;
+}
+
+} // namespace
+
+int main()
+{
+    std::printf("%d Butterworth filters of order 4, one sample each per tick\n", NR_FILTERS);
+    const std::size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t nrThreads = 1; nrThreads <= hardwareThreads; nrThreads *= 2)
+        std::printf("%2zu thread(s) %10.1f us/tick\n", nrThreads, tickUs(nrThreads));
+    return 0;
+}
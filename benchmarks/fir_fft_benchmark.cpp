@@ -0,0 +1,62 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+// Long FIR filters: per-sample direct form, FFT overlap-save block filter and zero-latency partitioned convolution.
+
+#include "benchmark_helper.h"
+#include "difi"
+#include <cstdio>
+
+namespace {
+
+constexpr const int NR_SAMPLES = 200000;
+
+} // namespace
+
+int main()
+{
+    const Eigen::VectorXd signal = Eigen::VectorXd::Random(NR_SAMPLES);
+
+    std::printf("FIR filter, %d samples\n", NR_SAMPLES);
+    std::printf("%-8s %20s %20s %20s\n", "taps", "direct", "overlap-save", "partitioned");
+    for (int taps : { 32, 64, 128, 500, 1000, 5000 }) {
+        difi::DigitalFilterd fir(Eigen::VectorXd::Ones(1), Eigen::VectorXd::Random(taps));
+        const double direct = bench::medianTimeNs([&]() {
+            for (Eigen::Index i = 0; i < signal.size(); ++i)
+                bench::doNotOptimize(fir.stepFilter(signal(i)));
+        });
+        const double block = bench::medianTimeNs([&]() {
+            bench::doNotOptimize(fir.filter(signal));
+        });
+        difi::PartitionedConvolverd convolver(fir);
+        const double partitioned = bench::medianTimeNs([&]() {
+            for (Eigen::Index i = 0; i < signal.size(); ++i)
+                bench::doNotOptimize(convolver.stepFilter(signal(i)));
+        });
+        std::printf("%-8d %10.2f ns/sample %10.2f ns/sample %10.2f ns/sample\n", taps, direct / NR_SAMPLES, block / NR_SAMPLES, partitioned / NR_SAMPLES);
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+// Frequency responses of many filters on a dense grid: scalar loops against the vectorized freqz.
+
+#include "benchmark_helper.h"
+#include "difi"
+#include <complex>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+constexpr const int NR_FILTERS = 1000;
+constexpr const int NR_POINTS = 512;
+
+} // namespace
+
+int main()
+{
+    std::vector<difi::Butterworthd> filters;
+    for (int i = 0; i < NR_FILTERS; ++i)
+        filters.emplace_back(2 + i % 7, 1. + static_cast<double>(i % 40), 100.);
+    const Eigen::VectorXd w = Eigen::VectorXd::LinSpaced(NR_POINTS, 0., difi::pi<double> * (NR_POINTS - 1) / NR_POINTS);
+    Eigen::MatrixXcd h(NR_POINTS, NR_FILTERS);
+
+    const double scalar = bench::medianTimeNs([&]() {
+        for (int f = 0; f < NR_FILTERS; ++f) {
+            const auto a = filters[f].aCoeff();
+            const auto b = filters[f].bCoeff();
+            for (int i = 0; i < NR_POINTS; ++i) {
+                std::complex<double> num(0);
+                std::complex<double> den(0);
+                for (Eigen::Index k = 0; k < b.size(); ++k)
+                    num += b(k) * std::polar(1., -w(i) * static_cast<double>(k));
+                for (Eigen::Index k = 0; k < a.size(); ++k)
+                    den += a(k) * std::polar(1., -w(i) * static_cast<double>(k));
+                h(i, f) = num / den;
+            }
+        }
+        bench::doNotOptimize(h(0, 0));
+    });
+    const double batched = bench::medianTimeNs([&]() {
+        difi::freqz(filters.data(), NR_FILTERS, w, h);
+        bench::doNotOptimize(h(0, 0));
+    });
+    Eigen::VectorXcd column(NR_POINTS);
+    const double uniform = bench::medianTimeNs([&]() {
+        for (int f = 0; f < NR_FILTERS; ++f) {
+            difi::freqz(filters[f], column);
+            bench::doNotOptimize(column(0));
+        }
+    });
+
+    std::printf("%d Butterworth filters, %d frequencies\n", NR_FILTERS, NR_POINTS);
+    std::printf("%-24s %10.2f ns/point\n", "scalar loops", scalar / (NR_FILTERS * NR_POINTS));
+    std::printf("%-24s %10.2f ns/point\n", "batched freqz (Horner)", batched / (NR_FILTERS * NR_POINTS));
+    std::printf("%-24s %10.2f ns/point\n", "uniform freqz", uniform / (NR_FILTERS * NR_POINTS));
+    return 0;
+}
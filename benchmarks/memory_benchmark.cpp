@@ -0,0 +1,90 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+// Memory footprint of the filters: size of the object and heap usage, including the allocator overhead.
+// The heap usage is only available with glibc.
+
+#include "benchmark_helper.h"
+#include "difi"
+#include <cstdio>
+#include <string>
+#include <vector>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+
+long long heapBytes()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return static_cast<long long>(mallinfo2().uordblks);
+#else
+    return -1;
+#endif
+}
+
+template <typename Filter, typename Factory>
+void report(const std::string& name, Factory&& makeFilter)
+{
+    constexpr const int NR_FILTERS = 10000;
+    std::vector<Filter> filters;
+    filters.reserve(NR_FILTERS);
+
+    const long long start = heapBytes();
+    for (int i = 0; i < NR_FILTERS; ++i)
+        filters.push_back(makeFilter());
+    const long long end = heapBytes();
+
+    // Stepping must not touch the heap
+    for (auto& f : filters)
+        bench::doNotOptimize(f.stepFilter(1.));
+    const long long afterStep = heapBytes();
+
+    if (start < 0) {
+        std::printf("%-32s %8zu %14s %14s %12s\n", name.c_str(), sizeof(Filter), "n/a", "n/a", "n/a");
+        return;
+    }
+
+    const double bytesPerFilter = static_cast<double>(end - start) / NR_FILTERS;
+    std::printf("%-32s %8zu %14.1f %14.1f %12lld\n", name.c_str(), sizeof(Filter), bytesPerFilter, sizeof(Filter) + bytesPerFilter, afterStep - end);
+}
+
+} // namespace
+
+int main()
+{
+    std::printf("%-32s %8s %14s %14s %12s\n", "filter", "sizeof", "heap bytes", "total bytes", "step heap");
+    report<difi::DigitalFilterd>("DigitalFilterd (order 2)", []() { return difi::DigitalFilterd(Eigen::VectorXd::Ones(3), Eigen::VectorXd::Ones(3)); });
+    report<difi::MovingAveraged>("MovingAveraged (window 8)", []() { return difi::MovingAveraged(8); });
+    report<difi::Butterworthd>("Butterworthd (order 4)", []() { return difi::Butterworthd(4, 10, 100); });
+    // Copies of a designed filter share its coefficients and only own their history
+    const difi::Butterworthd design(4, 10, 100);
+    report<difi::Butterworthd>("Butterworthd (order 4, shared)", [&design]() { return design; });
+    report<difi::CenteredDiffNoiseRobust2d<7>>("CenteredDiffNoiseRobust2d<7>", []() { return difi::CenteredDiffNoiseRobust2d<7>(); });
+    return 0;
+}
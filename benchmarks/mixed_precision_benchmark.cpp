@@ -0,0 +1,92 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+// Accuracy/throughput of the accumulator policy of the filters.
+// The accuracy is measured against the Matlab-validated results of the unit tests and against a double precision filter on a long signal.
+
+#include "benchmark_helper.h"
+#include "difi"
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+constexpr const int NR_SAMPLES = 1000000;
+constexpr const int ORDER = 5;
+constexpr const double FC = 10.;
+constexpr const double FS = 100.;
+
+// The signal is generated in float so that every filter sees the exact same input
+difi::vectX_t<float> generateSignal()
+{
+    difi::vectX_t<float> signal(NR_SAMPLES);
+    for (int i = 0; i < NR_SAMPLES; ++i)
+        signal(i) = static_cast<float>(std::sin(0.05 * i) + 0.3 * std::sin(1.3 * i));
+    return signal;
+}
+
+// Low-pass results from the unit tests (Matlab)
+const difi::vectX_t<double> matlabData = (difi::vectX_t<double>(8) << 1, 2, 3, 4, 5, 6, 7, 8).finished();
+const difi::vectX_t<double> matlabResults = (difi::vectX_t<double>(8) << 0.001282581078961, 0.012794287652606, 0.062686244350084, 0.203933712825708, 0.502244959135609, 1.010304217144175, 1.744652693589064, 2.678087381460197).finished();
+
+template <typename T, typename Accumulator>
+void run(const std::string& name, const difi::vectX_t<double>& reference)
+{
+    difi::Butterworth<T, Accumulator> bf(ORDER, static_cast<T>(FC), static_cast<T>(FS));
+
+    difi::vectX_t<T> data = matlabData.cast<T>();
+    difi::vectX_t<T> results = bf.filter(data);
+    const double matlabError = (results.template cast<double>() - matlabResults).cwiseAbs().maxCoeff();
+
+    const difi::vectX_t<T> signal = generateSignal().cast<T>();
+    difi::vectX_t<T> filtered;
+    const double ns = bench::medianTimeNs([&]() {
+        bf.resetFilter();
+        filtered = bf.filter(signal);
+        bench::doNotOptimize(filtered);
+    });
+    const double longError = (filtered.template cast<double>() - reference).cwiseAbs().maxCoeff();
+
+    std::printf("%-28s %10.2f ns/sample %14.3e %14.3e\n", name.c_str(), ns / NR_SAMPLES, matlabError, longError);
+}
+
+} // namespace
+
+int main()
+{
+    difi::Butterworthd ref(ORDER, FC, FS);
+    const difi::vectX_t<double> reference = ref.filter(generateSignal().cast<double>());
+
+    std::printf("Butterworth low-pass order %d, %d samples\n", ORDER, NR_SAMPLES);
+    std::printf("%-28s %21s %14s %14s\n", "storage/accumulator", "throughput", "matlab error", "long error");
+    run<double, double>("double/double", reference);
+    run<float, float>("float/float", reference);
+    run<float, double>("float/double", reference);
+    run<float, difi::CompensatedSum>("float/compensated", reference);
+    return 0;
+}
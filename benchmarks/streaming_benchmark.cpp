@@ -0,0 +1,170 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+// Hand-over of samples from an acquisition thread to a filtering thread, and of the results to a consumer thread.
+// A mutex-protected queue with one stepFilter call per sample is compared to a StreamingFilterStage.
+
+#include "benchmark_helper.h"
+#include "difi"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr const int NR_SAMPLES = 1000000;
+constexpr const int NR_ROUND_TRIPS = 10000;
+
+class MutexPipe {
+public:
+    explicit MutexPipe(const difi::DigitalFilterd& filter)
+        : m_filter(filter)
+    {}
+
+    bool push(double sample)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_input.push_back(sample);
+        return true;
+    }
+
+    std::size_t process()
+    {
+        double sample;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_input.empty())
+                return 0;
+            sample = m_input.front();
+            m_input.pop_front();
+        }
+        const double result = m_filter.stepFilter(sample);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_output.push_back(result);
+        return 1;
+    }
+
+    bool pop(double& result)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_output.empty())
+            return false;
+        result = m_output.front();
+        m_output.pop_front();
+        return true;
+    }
+
+private:
+    difi::DigitalFilterd m_filter;
+    std::mutex m_mutex;
+    std::deque<double> m_input;
+    std::deque<double> m_output;
+};
+
+// Run the filtering thread while f is running
+template <typename Pipe, typename Function>
+void withFilteringThread(Pipe& pipe, Function&& f)
+{
+    std::atomic<bool> running{ true };
+    std::thread filtering([&]() {
+        while (running.load(std::memory_order_relaxed))
+            if (pipe.process() == 0)
+                std::this_thread::yield();
+    });
+    f();
+    running = false;
+    filtering.join();
+}
+
+template <typename Pipe>
+double throughputNs(Pipe& pipe)
+{
+    double elapsed = 0;
+    withFilteringThread(pipe, [&]() {
+        elapsed = bench::medianTimeNs([&]() {
+            std::thread producer([&]() {
+                for (int i = 0; i < NR_SAMPLES;) {
+                    if (pipe.push(static_cast<double>(i % 100)))
+                        ++i;
+                    else
+                        std::this_thread::yield();
+                }
+            });
+            double result;
+            for (int i = 0; i < NR_SAMPLES;) {
+                if (pipe.pop(result))
+                    ++i;
+                else
+                    std::this_thread::yield();
+            }
+            producer.join();
+            bench::doNotOptimize(result);
+        }, 3);
+    });
+    return elapsed / NR_SAMPLES;
+}
+
+template <typename Pipe>
+double latencyNs(Pipe& pipe)
+{
+    std::vector<double> times;
+    times.reserve(NR_ROUND_TRIPS);
+    withFilteringThread(pipe, [&]() {
+        double result;
+        for (int i = 0; i < NR_ROUND_TRIPS; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            pipe.push(1.);
+            while (!pipe.pop(result))
+                std::this_thread::yield();
+            times.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+        }
+    });
+    std::nth_element(times.begin(), times.begin() + NR_ROUND_TRIPS / 2, times.end());
+    return times[NR_ROUND_TRIPS / 2];
+}
+
+} // namespace
+
+int main()
+{
+    difi::Butterworthd bf(4, 10, 1000);
+    const difi::DigitalFilterd filter(bf.coefficients(), bf.type());
+    std::printf("Butterworth low-pass order 4, %d samples, %u hardware thread(s)\n", NR_SAMPLES, std::thread::hardware_concurrency());
+    {
+        MutexPipe pipe(filter);
+        std::printf("%-36s %10.1f ns/sample %10.1f ns/round trip\n", "mutex queue + stepFilter", throughputNs(pipe), latencyNs(pipe));
+    }
+    {
+        difi::StreamingFilterStaged stage(filter);
+        std::printf("%-36s %10.1f ns/sample %10.1f ns/round trip\n", "StreamingFilterStage (SPSC, batches)", throughputNs(stage), latencyNs(stage));
+    }
+    return 0;
+}
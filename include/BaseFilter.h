@@ -27,17 +27,20 @@
 
 #pragma once
 
+#include "FilterCoefficients.h"
+#include "buffer.h"
+#include "denormals.h"
 #include "gsl/gsl_assert.h"
 #include "type_checks.h"
 #include "typedefs.h"
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 namespace difi {
 
-// TODO: noexcept(Function of gsl variable)
-// TODO: constructor with universal refs
-// TODO: setCoeffs with universal refs
-
 /*! \brief Low-level filter.
  * 
  * It creates the basic and common functions of all linear filter that can written as a digital filter.
@@ -45,6 +48,12 @@ namespace difi {
  * 
  * \warning In Debug mode, all functions may throw if a filter is badly initialized.
  * This not the case in Realese mode.
+ * The contracts are checked when the filter is designed and at the entry of stepFilter and filter.
+ * Each filter also provides a noexcept stepFilterUnchecked for hot loops that already know the filter is ready.
+ *
+ * The coefficients and the data history are allocated from the memory resource given to the constructor of the filter,
+ * the default std::pmr memory resource by default (see ScopedMemoryResource). Once the filter is designed, stepping and resetting it never allocate.
+ * The coefficients are held in a shared FilterCoefficients: copies of a filter share them and only own their data history.
  * 
  * \tparam T Floating type.
  */
@@ -64,7 +73,7 @@ public:
      * \f$\Delta T\f$ is your sampling time. 
      * \note For FilterType::Backward filter, the function returns 0.
      */
-    Eigen::Index center() const noexcept { return (m_type == FilterType::Backward ? 0 : ((m_bCoeff.size() - 1) / 2)); }
+    Eigen::Index center() const noexcept { return (m_type == FilterType::Backward ? 0 : ((bOrder() - 1) / 2)); }
     /*! \brief Get digital filter coefficients.
      * 
      * It will automatically resize the given vectors.
@@ -73,15 +82,30 @@ public:
      */
     void getCoeffs(vectX_t<T>& aCoeff, vectX_t<T>& bCoeff) const noexcept;
     /*! \brief Return coefficients of the denominator polynome. */
-    const vectX_t<T>& aCoeff() const noexcept { return m_aCoeff; }
+    Eigen::Map<const vectX_t<T>> aCoeff() const noexcept { return m_coeffs ? m_coeffs->aCoeff() : Eigen::Map<const vectX_t<T>>(nullptr, 0); }
     /*! \brief Return coefficients of the numerator polynome. */
-    const vectX_t<T>& bCoeff() const noexcept { return m_bCoeff; }
+    Eigen::Map<const vectX_t<T>> bCoeff() const noexcept { return m_coeffs ? m_coeffs->bCoeff() : Eigen::Map<const vectX_t<T>>(nullptr, 0); }
     /*! \brief Return the order the denominator polynome order of the filter. */
-    Eigen::Index aOrder() const noexcept { return m_aCoeff.size(); }
+    Eigen::Index aOrder() const noexcept { return m_coeffs ? m_coeffs->aOrder() : 0; }
     /*! \brief Return the order the numerator polynome order of the filter. */
-    Eigen::Index bOrder() const noexcept { return m_bCoeff.size(); }
+    Eigen::Index bOrder() const noexcept { return m_coeffs ? m_coeffs->bOrder() : 0; }
+    /*! \brief Return the shared coefficients of the filter (null if the filter is not initialized). */
+    const std::shared_ptr<const FilterCoefficients<T>>& coefficients() const noexcept { return m_coeffs; }
+    /*! \brief Return the memory resource of the data history and of the coefficients created by the filter. */
+    std::pmr::memory_resource* memoryResource() const noexcept { return m_state.resource(); }
     /*! \brief Return the initialization state of the filter0 */
     bool isInitialized() const noexcept { return m_isInitialized; }
+    /*! \brief Return true if the denormal outputs are flushed to zero in stepFilter. */
+    bool flushDenormals() const noexcept { return m_flushDenormals; }
+    /*! \brief Flush to zero the denormal outputs of stepFilter.
+     *
+     * A recursive filter that receives a silent input keeps its output decaying toward zero and
+     * soon computes with denormal numbers which are very slow on some processors.
+     * Flushing the newest output keeps the whole filter state normal. Default is false.
+     * \note Batch filter() calls are always protected by a ScopedDenormalGuard.
+     * \param flush True to enable the flush.
+     */
+    void setFlushDenormals(bool flush) noexcept { m_flushDenormals = flush; }
     /*! \brief Set type of filter (one-sided or centered)
      * 
      * \param type The filter type.
@@ -90,48 +114,148 @@ public:
     void setType(FilterType type);
     /*! \brief Set the new coefficients of the filters.
      *
-     * It awaits a universal reference.
+     * Eigen expressions are evaluated directly into the filter storage.
+     * The coefficients are written in place if the filter is their only owner, the filter size is unchanged and they come from the same memory resource,
+     * otherwise new coefficients are created so that the other filters sharing the previous ones are not modified.
+     * The data history keeps its storage if the filter size is unchanged.
      * \param aCoeff Denominator coefficients of the filter in decreasing order.
      * \param bCoeff Numerator coefficients of the filter in decreasing order.
+     * \param resource Memory resource of the coefficients, null for the memoryResource() of the filter.
      */
-    void setCoeffs(const vectX_t<T>& aCoeff, const vectX_t<T>& bCoeff);
+    template <typename AVector, typename BVector>
+    void setCoeffs(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff, std::pmr::memory_resource* resource = nullptr);
+    /*! \brief Set the new coefficients of the filters, moving the vectors.
+     *
+     * Same as the overload taking expressions, except that new coefficients adopt the storage of the vectors instead of copying them
+     * if the memory resource of the filter is the heap, see FilterCoefficients. The vectors are left empty if they are adopted.
+     * \param aCoeff Denominator coefficients of the filter in decreasing order.
+     * \param bCoeff Numerator coefficients of the filter in decreasing order.
+     * \param resource Memory resource of the coefficients, null for the memoryResource() of the filter.
+     */
+    template <typename Vector, typename = internal::enable_if_rvalue_t<Vector, vectX_t<T>>>
+    void setCoeffs(Vector&& aCoeff, Vector&& bCoeff, std::pmr::memory_resource* resource = nullptr);
+    /*! \brief Share existing coefficients.
+     * \param coeffs Coefficients of the filter.
+     */
+    void setCoeffs(std::shared_ptr<const FilterCoefficients<T>> coeffs);
+    /*! \brief Replace the coefficients by coefficients of the same size, keeping the data history.
+     *
+     * Unlike setCoeffs, it neither allocates nor resets the filter, so that it can be called between two samples of a real-time loop.
+     * The previous coefficients are released, and destroyed if the filter was their last owner.
+     * \see CoefficientSlot
+     * \param coeffs Coefficients with the same aOrder() and bOrder() as the filter.
+     */
+    void swapCoeffs(std::shared_ptr<const FilterCoefficients<T>> coeffs);
+    /*! \brief Save or restore the filter through a snapshot archive.
+     * \see saveSnapshot, restoreSnapshot
+     */
+    template <typename Archive>
+    void serialize(Archive& ar);
 
 protected:
-    /*! \brief Normalized the filter coefficients such that aCoeff(0) = 1. */
-    void normalizeCoeffs();
     /*! \brief Check for bad coefficients.
      * 
      * Set the filter status to ready is everything is fine.
      * \param aCoeff Denominator coefficients of the filter.
      * \param bCoeff Numerator coefficients of the filter.
      * \return True if the filter status is set on READY.
+     * Filters accepting fewer coefficients hide it.
+     */
+    template <typename AVector, typename BVector>
+    bool checkCoeffs(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff) const;
+    /*! \brief Return the last set of filtered data, the newest first. */
+    Eigen::Map<vectX_t<T>> filteredData() noexcept { return m_state.segment(0, aOrder()); }
+    /*! \brief Return the last set of filtered data, the newest first. */
+    Eigen::Map<const vectX_t<T>> filteredData() const noexcept { return m_state.segment(0, aOrder()); }
+    /*! \brief Return the last set of non-filtered data, the newest first. */
+    Eigen::Map<vectX_t<T>> rawData() noexcept { return m_state.segment(aOrder(), bOrder()); }
+    /*! \brief Return the last set of non-filtered data, the newest first. */
+    Eigen::Map<const vectX_t<T>> rawData() const noexcept { return m_state.segment(aOrder(), bOrder()); }
+    /*! \brief Set the data and filtered data to zero.
+     *
+     * The storage is kept if the size of the filter is unchanged.
+     */
+    void resetState() noexcept { m_state.setZero(aOrder() + bOrder()); }
+    /*! \brief Return the size of the data history of the base filter for coefficients of the given sizes.
+     *
+     * Filters keeping their own history hide it.
+     */
+    static constexpr Eigen::Index stateSize(Eigen::Index aSize, Eigen::Index bSize) noexcept { return aSize + bSize; }
+    /*! \brief Called when new coefficients are installed, before the filter is reset.
+     *
+     * Filters caching data computed from the coefficients hide it.
+     * It must not allocate if the sizes of the coefficients are unchanged, so that swapCoeffs does not allocate.
      */
-    bool checkCoeffs(const vectX_t<T>& aCoeff, const vectX_t<T>& bCoeff);
+    void coeffsChanged() {}
+
+    /*! \brief Fields of the base filter read from a snapshot archive, validated but not assigned yet. */
+    struct SavedFields {
+        FilterType type;
+        bool flushDenormals;
+        Eigen::Map<const vectX_t<T>> aCoeff;
+        Eigen::Map<const vectX_t<T>> bCoeff;
+        Eigen::Map<const vectX_t<T>> state;
+    };
+    /*! \brief Read and validate the fields of the base filter from a loading archive, without modifying the filter.
+     *
+     * Filters with fields of their own read and validate them too before calling assignFields, so that a rejected snapshot leaves them unchanged.
+     */
+    template <typename Archive>
+    SavedFields readFields(Archive& ar) const;
+    /*! \brief Assign the fields returned by readFields.
+     * \return True if the coefficients changed, coeffsChanged() was then called.
+     */
+    bool assignFields(const SavedFields& fields);
 
 private:
     /*! \brief Default uninitialized constructor. */
     BaseFilter() = default;
-    /*! \brief Constructor.
-     * \param aCoeff Denominator coefficients of the filter in decreasing order.
-     * \param bCoeff Numerator coefficients of the filter in decreasing order.
-     * \param type Type of the filter.
+    /*! \brief Uninitialized constructor allocating the data history and the coefficients from the given memory resource. */
+    explicit BaseFilter(std::pmr::memory_resource* resource) noexcept
+        : m_state(resource)
+    {}
+    /*! \brief Default destructor.
+     *
+     * It is not virtual, so filters carry no vtable pointer.
+     * It is private so that a filter can't be deleted through a pointer to its base.
      */
-    BaseFilter(const vectX_t<T>& aCoeff, const vectX_t<T>& bCoeff, FilterType type = FilterType::Backward);
-    /*! \brief Default destructor. */
-    virtual ~BaseFilter() = default;
+    ~BaseFilter() = default;
+
+    /*! \brief Install checked coefficients, in place if the filter is their only owner and the size and the resource are unchanged. */
+    template <typename AVector, typename BVector>
+    void assignCoeffs(AVector&& aCoeff, BVector&& bCoeff, std::pmr::memory_resource* resource);
 
     Derived& derived() noexcept { return *static_cast<Derived*>(this); }
     const Derived& derived() const noexcept { return *static_cast<const Derived*>(this); }
 
 private:
-    FilterType m_type; /*!< Type of filter. Default is FilterType::Backward. */
+    FilterType m_type = FilterType::Backward; /*!< Type of filter. Default is FilterType::Backward. */
     bool m_isInitialized = false; /*!< Initialization state of the filter. Default is false */
-    vectX_t<T> m_aCoeff; /*!< Denominator coefficients of the filter */
-    vectX_t<T> m_bCoeff; /*!< Numerator coefficients of the filter */
-    vectX_t<T> m_filteredData; /*!< Last set of filtered data */
-    vectX_t<T> m_rawData; /*!< Last set of non-filtered data */
+    bool m_flushDenormals = false; /*!< Flush denormal outputs to zero. Default is false */
+    bool m_ownsCoeffs = false; /*!< The coefficients were created by the filter (or one of its copies) and may be written in place */
+    std::shared_ptr<const FilterCoefficients<T>> m_coeffs; /*!< Shared coefficients of the filter */
+    details::Buffer<T> m_state; /*!< Last set of filtered data followed by the last set of non-filtered data */
 };
 
+namespace details {
+
+template <typename T, typename Derived>
+T filterScalar(const BaseFilter<T, Derived>*);
+
+/*! \brief Floating type of a filter deriving from BaseFilter. */
+template <typename Filter>
+using filter_scalar_t = decltype(filterScalar(std::declval<const Filter*>()));
+
+template <typename Filter, typename = void>
+struct is_filter : std::false_type {
+};
+
+template <typename Filter>
+struct is_filter<Filter, std::void_t<filter_scalar_t<Filter>>> : std::true_type {
+};
+
+} // namespace details
+
 } // namespace difi
 
 #include "BaseFilter.tpp"
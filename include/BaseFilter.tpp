@@ -26,6 +26,7 @@
 // either expressed or implied, of the FreeBSD Project.
 
 #include <limits>
+#include <utility>
 
 namespace difi {
 
@@ -34,60 +35,136 @@ namespace difi {
 template <typename T, typename Derived>
 void BaseFilter<T, Derived>::setType(FilterType type)
 {
-    Expects(type == FilterType::Centered ? m_bCoeff.size() > 2 && m_bCoeff.size() % 2 == 1 : true);
+    Expects(type == FilterType::Centered ? bOrder() > 2 && bOrder() % 2 == 1 : true);
     m_type = type;
 }
 
 template <typename T, typename Derived>
-void BaseFilter<T, Derived>::setCoeffs(const vectX_t<T>& aCoeff, const vectX_t<T>& bCoeff)
+template <typename AVector, typename BVector>
+void BaseFilter<T, Derived>::setCoeffs(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff, std::pmr::memory_resource* resource)
 {
-    Expects(checkCoeffs(aCoeff, bCoeff));
-    m_aCoeff = aCoeff;
-    m_bCoeff = bCoeff;
-    normalizeCoeffs();
+    // The filter is left unchanged if the coefficients are wrong
+    Expects(derived().checkCoeffs(aCoeff, bCoeff));
+    assignCoeffs(aCoeff, bCoeff, resource ? resource : m_state.resource());
+    derived().coeffsChanged();
     resetFilter();
     m_isInitialized = true;
 }
 
 template <typename T, typename Derived>
-void BaseFilter<T, Derived>::getCoeffs(vectX_t<T>& aCoeff, vectX_t<T>& bCoeff) const noexcept
+template <typename Vector, typename>
+void BaseFilter<T, Derived>::setCoeffs(Vector&& aCoeff, Vector&& bCoeff, std::pmr::memory_resource* resource)
 {
-    aCoeff = m_aCoeff;
-    bCoeff = m_bCoeff;
+    Expects(derived().checkCoeffs(aCoeff, bCoeff));
+    assignCoeffs(std::move(aCoeff), std::move(bCoeff), resource ? resource : m_state.resource());
+    derived().coeffsChanged();
+    resetFilter();
+    m_isInitialized = true;
 }
 
-// Protected functions
-
 template <typename T, typename Derived>
-BaseFilter<T, Derived>::BaseFilter(const vectX_t<T>& aCoeff, const vectX_t<T>& bCoeff, FilterType type)
-    : m_type(type)
-    , m_aCoeff(aCoeff)
-    , m_bCoeff(bCoeff)
-    , m_filteredData(aCoeff.size())
-    , m_rawData(bCoeff.size())
+void BaseFilter<T, Derived>::setCoeffs(std::shared_ptr<const FilterCoefficients<T>> coeffs)
 {
-    Expects(checkCoeffs(aCoeff, bCoeff));
-    normalizeCoeffs();
+    Expects(coeffs != nullptr);
+    Expects(derived().checkCoeffs(coeffs->aCoeff(), coeffs->bCoeff()));
+    m_coeffs = std::move(coeffs);
+    m_ownsCoeffs = false;
+    derived().coeffsChanged();
     resetFilter();
     m_isInitialized = true;
 }
 
 template <typename T, typename Derived>
-void BaseFilter<T, Derived>::normalizeCoeffs()
+void BaseFilter<T, Derived>::swapCoeffs(std::shared_ptr<const FilterCoefficients<T>> coeffs)
 {
-    T a0 = m_aCoeff(0);
-    if (std::abs(a0 - T(1)) < std::numeric_limits<T>::epsilon())
-        return;
+    Expects(m_isInitialized);
+    Expects(coeffs != nullptr);
+    Expects(coeffs->aOrder() == aOrder() && coeffs->bOrder() == bOrder());
+    m_coeffs = std::move(coeffs);
+    m_ownsCoeffs = false;
+    derived().coeffsChanged();
+}
 
-    m_aCoeff /= a0;
-    m_bCoeff /= a0;
+template <typename T, typename Derived>
+template <typename Archive>
+void BaseFilter<T, Derived>::serialize(Archive& ar)
+{
+    if constexpr (Archive::IsLoading) {
+        assignFields(readFields(ar));
+    } else {
+        ar(m_type);
+        ar(m_flushDenormals);
+        ar(aCoeff());
+        ar(bCoeff());
+        ar(m_state);
+    }
 }
 
 template <typename T, typename Derived>
-bool BaseFilter<T, Derived>::checkCoeffs(const vectX_t<T>& aCoeff, const vectX_t<T>& bCoeff)
+template <typename Archive>
+auto BaseFilter<T, Derived>::readFields(Archive& ar) const -> SavedFields
+{
+    FilterType type;
+    bool flushDenormals;
+    ar(type);
+    ar(flushDenormals);
+    const auto aCoeff = ar.template array<T>();
+    const auto bCoeff = ar.template array<T>();
+    const auto state = ar.template array<T>();
+    Expects(FilterCoefficients<T>::isValid(aCoeff, bCoeff));
+    Expects(type != FilterType::Centered || bCoeff.size() % 2 == 1);
+    Expects(state.size() == Derived::stateSize(aCoeff.size(), bCoeff.size()));
+    return { type, flushDenormals, aCoeff, bCoeff, state };
+}
+
+template <typename T, typename Derived>
+bool BaseFilter<T, Derived>::assignFields(const SavedFields& fields)
+{
+    m_type = fields.type;
+    m_flushDenormals = fields.flushDenormals;
+    // Filters sharing the same design keep sharing it
+    const bool isNewDesign = fields.aCoeff.size() != aOrder() || fields.bCoeff.size() != bOrder() || fields.aCoeff != aCoeff() || fields.bCoeff != bCoeff();
+    if (isNewDesign) {
+        assignCoeffs(fields.aCoeff, fields.bCoeff, m_state.resource());
+        derived().coeffsChanged();
+    }
+    m_state.resize(fields.state.size());
+    m_state.vector() = fields.state;
+    m_isInitialized = true;
+    return isNewDesign;
+}
+
+template <typename T, typename Derived>
+void BaseFilter<T, Derived>::getCoeffs(vectX_t<T>& aCoeff, vectX_t<T>& bCoeff) const noexcept
+{
+    aCoeff = this->aCoeff();
+    bCoeff = this->bCoeff();
+}
+
+// Protected functions
+
+template <typename T, typename Derived>
+template <typename AVector, typename BVector>
+bool BaseFilter<T, Derived>::checkCoeffs(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff) const
 {
     bool centering = (m_type == FilterType::Centered ? (bCoeff.size() % 2 == 1) : true);
-    return aCoeff.size() > 0 && std::abs(aCoeff[0]) > std::numeric_limits<T>::epsilon() && bCoeff.size() > 0 && centering;
+    return FilterCoefficients<T>::isValid(aCoeff, bCoeff) && centering;
+}
+
+// Private functions
+
+template <typename T, typename Derived>
+template <typename AVector, typename BVector>
+void BaseFilter<T, Derived>::assignCoeffs(AVector&& aCoeff, BVector&& bCoeff, std::pmr::memory_resource* resource)
+{
+    if (m_ownsCoeffs && m_coeffs.use_count() == 1 && aCoeff.size() == aOrder() && bCoeff.size() == bOrder() && *m_coeffs->memoryResource() == *resource) {
+        // The coefficients were created non-const by this filter and no other filter sees them
+        const_cast<FilterCoefficients<T>&>(*m_coeffs).assign(aCoeff, bCoeff);
+    } else {
+        // Rvalue vectors are adopted without copy
+        m_coeffs = FilterCoefficients<T>::create(std::forward<AVector>(aCoeff), std::forward<BVector>(bCoeff), resource);
+        m_ownsCoeffs = true;
+    }
 }
 
-} // namespace difi
\ No newline at end of file
+} // namespace difi
@@ -27,9 +27,10 @@
 
 #pragma once
 
-#include "DigitalFilter.h"
+#include "GenericFilter.h"
 #include "typedefs.h"
 #include <complex>
+#include <memory_resource>
 
 namespace difi {
 
@@ -41,13 +42,14 @@ namespace difi {
  * \see https://www.dsprelated.com/showarticle/1128.php
  * \see https://www.dsprelated.com/showarticle/1131.php
  * \see https://www.mathworks.com/help/signal/ref/butter.html
- * \tparam Floating type.
+ * \tparam T Floating type.
+ * \tparam Accumulator Floating type used to compute the output, or CompensatedSum.
  */
-template <typename T>
-class Butterworth : public DigitalFilter<T> {
+template <typename T, typename Accumulator = T>
+class Butterworth final : public GenericFilter<T, Accumulator> {
 public:
     /*! \brief Type of butterworth filter0 */
-    enum class Type {
+    enum class Type : std::uint8_t {
         LowPass, /*!< Define a low-pass filter */
         HighPass, /*!< Define a high-pass filter */
         BandPass, /*!< Define a band-pass filter */
@@ -74,23 +76,26 @@ public:
 public:
     /*! \brief Uninitialized constructor. 
      * \param type Filter type. Default is LowPass.
+     * \param resource Memory resource of the data history and of the coefficients.
      */
-    Butterworth(Type type = Type::LowPass);
+    Butterworth(Type type = Type::LowPass, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
     /*! \brief Constructor for both low-pass and high-pass filters.
      * \param order Order of the filter.
      * \param fc Cut-off frequency.
      * \param fs Sampling frequency.
      * \param type Filter type. Default is LowPass.
+     * \param resource Memory resource of the data history and of the coefficients.
      */
-    Butterworth(int order, T fc, T fs, Type type = Type::LowPass);
+    Butterworth(int order, T fc, T fs, Type type = Type::LowPass, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
     /*! \brief Constructor for both band-pass and band-reject filters.
      * \param order Order of the filter.
      * \param fLower Lower bound frequency.
      * \param fUpper Upper bound frequency.
      * \param fs Sampling frequency.
      * \param type Filter type. Default is BandPass.
+     * \param resource Memory resource of the data history and of the coefficients.
      */
-    Butterworth(int order, T fLower, T fUpper, T fs, Type type = Type::BandPass);
+    Butterworth(int order, T fLower, T fUpper, T fs, Type type = Type::BandPass, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
     /*! \brief Set filter set of parameters.
      * \param order Order of the filter.
      * \param fc Cut-off frequency.
@@ -104,6 +109,19 @@ public:
      * \param fs Sampling frequency.
      */
     void setFilterParameters(int order, T fLower, T fUpper, T fs);
+    /*! \brief Return the filter as a cascade of second-order sections.
+     *
+     * The sections are built from the designed poles and zeros, so no root finding is involved.
+     * It is the preferred representation for high order filters and fixed-point arithmetic.
+     * \return Matrix of size \f$L\times 6\f$ where each row is a section \f$[b_0, b_1, b_2, 1, a_1, a_2]\f$.
+     * \see zpkToSOS
+     */
+    matX_t<T> secondOrderSections() const;
+    /*! \brief Save or restore the filter through a snapshot archive.
+     * \see saveSnapshot, restoreSnapshot
+     */
+    template <typename Archive>
+    void serialize(Archive& ar);
 
 private:
     /*! \brief Initialize the filter.
@@ -113,6 +131,20 @@ private:
      * \param fs Sampling frequency.
      */
     void initialize(int order, T f1, T f2, T fs);
+    /*! \brief Compute the digital poles for low-pass and high-pass.
+     * \param fc Cut-off frequency.
+     */
+    vectXc_t<T> digitalPoles(T fc) const;
+    /*! \brief Compute the digital poles for band-pass and band-reject.
+     * \param fLower Lower bound frequency.
+     * \param fUpper Upper bound frequency.
+     */
+    vectXc_t<T> digitalBandPoles(T fLower, T fUpper) const;
+    /*! \brief Continuous pre-warp frequency at geometric center of a band.
+     * \param fLower Lower bound frequency.
+     * \param fUpper Upper bound frequency.
+     */
+    T prewarpedCenter(T fLower, T fUpper) const;
     /*! \brief Compute the digital filter representation for low-pass and high-pass.
      * \param fc Cut-off frequency.
      */
@@ -127,19 +159,19 @@ private:
      * \param fpw Continuous pre-warp cut-off frequency.
      * \return Generated pole.
      */
-    std::complex<T> generateAnalogPole(int k, T fpw);
+    std::complex<T> generateAnalogPole(int k, T fpw) const;
     /*! \brief Generate an analog pole on the unit circle for band-pass and band-reject.
      * \param k Step on the unit circle.
      * \param fpw0 Continuous pre-warp frequency at geometric center.
      * \param bw Bandwith.
      * \return Pair of generated pole.
      */
-    std::pair<std::complex<T>, std::complex<T>> generateBandAnalogPole(int k, T fpw0, T bw);
+    std::pair<std::complex<T>, std::complex<T>> generateBandAnalogPole(int k, T fpw0, T bw) const;
     /*! \brief Generate all analog zeros.
      * \param fpw0 Continuous pre-warp frequency at geometric center (Only use by the band-reject).
      * \return Set of generated zeros.
      */
-    vectXc_t<T> generateAnalogZeros(T fpw0 = T());
+    vectXc_t<T> generateAnalogZeros(T fpw0 = T()) const;
     /*! \brief Scale coefficients.
      * \param aCoeff Unscaled poles.
      * \param bCoeff Unscaled zeros. 
@@ -151,6 +183,8 @@ private:
     Type m_type; /*!< Filter type */
     int m_order; /*!< Filter order */
     T m_fs; /*!< Filter sampling frequency */
+    T m_f1; /*!< Cut-off frequency or lower bound frequency */
+    T m_f2; /*!< Upper bound frequency (band filters only) */
 };
 
 } // namespace difi
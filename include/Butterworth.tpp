@@ -30,8 +30,8 @@
 
 namespace difi {
 
-template <typename T>
-std::pair<int, T> Butterworth<T>::findMinimumButter(T wPass, T wStop, T APass, T AStop)
+template <typename T, typename Accumulator>
+std::pair<int, T> Butterworth<T, Accumulator>::findMinimumButter(T wPass, T wStop, T APass, T AStop)
 {
     Expects(wPass > T(0) && wPass < T(1));
     Expects(wStop > T(0) && wPass < T(1));
@@ -56,42 +56,68 @@ std::pair<int, T> Butterworth<T>::findMinimumButter(T wPass, T wStop, T APass, T
     return std::pair<int, T>(order, T(2) * std::atan(ctf) / pi<T>);
 }
 
-template <typename T>
-Butterworth<T>::Butterworth(Type type)
-    : m_type(type)
+template <typename T, typename Accumulator>
+Butterworth<T, Accumulator>::Butterworth(Type type, std::pmr::memory_resource* resource)
+    : GenericFilter<T, Accumulator>(resource)
+    , m_type(type)
 {
 }
 
-template <typename T>
-Butterworth<T>::Butterworth(int order, T fc, T fs, Type type)
-    : m_type(type)
+template <typename T, typename Accumulator>
+Butterworth<T, Accumulator>::Butterworth(int order, T fc, T fs, Type type, std::pmr::memory_resource* resource)
+    : GenericFilter<T, Accumulator>(resource)
+    , m_type(type)
 {
     setFilterParameters(order, fc, fs);
 }
 
-template <typename T>
-Butterworth<T>::Butterworth(int order, T fLower, T fUpper, T fs, Type type)
-    : m_type(type)
+template <typename T, typename Accumulator>
+Butterworth<T, Accumulator>::Butterworth(int order, T fLower, T fUpper, T fs, Type type, std::pmr::memory_resource* resource)
+    : GenericFilter<T, Accumulator>(resource)
+    , m_type(type)
 {
     setFilterParameters(order, fLower, fUpper, fs);
 }
 
-template <typename T>
-void Butterworth<T>::setFilterParameters(int order, T fc, T fs)
+template <typename T, typename Accumulator>
+void Butterworth<T, Accumulator>::setFilterParameters(int order, T fc, T fs)
 {
     Expects(fc < fs / T(2));
     initialize(order, fc, 0, fs);
 }
 
-template <typename T>
-void Butterworth<T>::setFilterParameters(int order, T fLower, T fUpper, T fs)
+template <typename T, typename Accumulator>
+void Butterworth<T, Accumulator>::setFilterParameters(int order, T fLower, T fUpper, T fs)
 {
     Expects(fLower < fUpper);
     initialize(order, fLower, fUpper, fs);
 }
 
-template <typename T>
-void Butterworth<T>::initialize(int order, T f1, T f2, T fs)
+template <typename T, typename Accumulator>
+template <typename Archive>
+void Butterworth<T, Accumulator>::serialize(Archive& ar)
+{
+    GenericFilter<T, Accumulator>::serialize(ar);
+    ar(m_type);
+    ar(m_order);
+    ar(m_fs);
+    ar(m_f1);
+    ar(m_f2);
+}
+
+template <typename T, typename Accumulator>
+matX_t<T> Butterworth<T, Accumulator>::secondOrderSections() const
+{
+    Expects(this->isInitialized());
+    // Vieta's polynomes are monic so the gain is the first numerator coefficient
+    if (m_type == Type::LowPass || m_type == Type::HighPass)
+        return zpkToSOS(generateAnalogZeros(), digitalPoles(m_f1), this->bCoeff()(0));
+    else
+        return zpkToSOS(generateAnalogZeros(prewarpedCenter(m_f1, m_f2)), digitalBandPoles(m_f1, m_f2), this->bCoeff()(0));
+}
+
+template <typename T, typename Accumulator>
+void Butterworth<T, Accumulator>::initialize(int order, T f1, T f2, T fs)
 {
     // f1 = fc for LowPass/HighPass filter
     // f1 = fLower, f2 = fUpper for BandPass/BandReject filter
@@ -100,42 +126,39 @@ void Butterworth<T>::initialize(int order, T f1, T f2, T fs)
 
     m_order = order;
     m_fs = fs;
+    m_f1 = f1;
+    m_f2 = f2;
     if (m_type == Type::LowPass || m_type == Type::HighPass)
         computeDigitalRep(f1);
     else
         computeBandDigitalRep(f1, f2); // For band-like filters
 }
 
-template <typename T>
-void Butterworth<T>::computeDigitalRep(T fc)
+template <typename T, typename Accumulator>
+vectXc_t<T> Butterworth<T, Accumulator>::digitalPoles(T fc) const
 {
     // Continuous pre-warped frequency
     T fpw = (m_fs / pi<T>)*std::tan(pi<T> * fc / m_fs);
 
-    // Compute poles
     vectXc_t<T> poles(m_order);
     std::complex<T> analogPole;
     for (int k = 0; k < m_order; ++k) {
         analogPole = generateAnalogPole(k + 1, fpw);
         BilinearTransform<std::complex<T>>::SToZ(m_fs, analogPole, poles(k));
     }
+    return poles;
+}
 
-    vectXc_t<T> zeros = generateAnalogZeros();
-    vectXc_t<T> a = VietaAlgo<std::complex<T>>::polyCoeffFromRoot(poles);
-    vectXc_t<T> b = VietaAlgo<std::complex<T>>::polyCoeffFromRoot(zeros);
-    vectX_t<T> aCoeff(m_order + 1);
-    vectX_t<T> bCoeff(m_order + 1);
-    for (int i = 0; i < m_order + 1; ++i) {
-        aCoeff(i) = a(i).real();
-        bCoeff(i) = b(i).real();
-    }
-
-    scaleAmplitude(aCoeff, bCoeff);
-    this->setCoeffs(std::move(aCoeff), std::move(bCoeff));
+template <typename T, typename Accumulator>
+T Butterworth<T, Accumulator>::prewarpedCenter(T fLower, T fUpper) const
+{
+    T fpw1 = (m_fs / pi<T>)*std::tan(pi<T> * fLower / m_fs);
+    T fpw2 = (m_fs / pi<T>)*std::tan(pi<T> * fUpper / m_fs);
+    return std::sqrt(fpw1 * fpw2);
 }
 
-template <typename T>
-void Butterworth<T>::computeBandDigitalRep(T fLower, T fUpper)
+template <typename T, typename Accumulator>
+vectXc_t<T> Butterworth<T, Accumulator>::digitalBandPoles(T fLower, T fUpper) const
 {
     T fpw1 = (m_fs / pi<T>)*std::tan(pi<T> * fLower / m_fs);
     T fpw2 = (m_fs / pi<T>)*std::tan(pi<T> * fUpper / m_fs);
@@ -148,16 +171,28 @@ void Butterworth<T>::computeBandDigitalRep(T fLower, T fUpper)
         BilinearTransform<std::complex<T>>::SToZ(m_fs, analogPoles.first, poles(k));
         BilinearTransform<std::complex<T>>::SToZ(m_fs, analogPoles.second, poles(m_order + k));
     }
+    return poles;
+}
 
-    vectXc_t<T> zeros = generateAnalogZeros(fpw0);
-    vectXc_t<T> a = VietaAlgo<std::complex<T>>::polyCoeffFromRoot(poles);
-    vectXc_t<T> b = VietaAlgo<std::complex<T>>::polyCoeffFromRoot(zeros);
-    vectX_t<T> aCoeff(2 * m_order + 1);
-    vectX_t<T> bCoeff(2 * m_order + 1);
-    for (int i = 0; i < 2 * m_order + 1; ++i) {
-        aCoeff(i) = a(i).real();
-        bCoeff(i) = b(i).real();
-    }
+template <typename T, typename Accumulator>
+void Butterworth<T, Accumulator>::computeDigitalRep(T fc)
+{
+    vectXc_t<T> poles = digitalPoles(fc);
+    vectXc_t<T> zeros = generateAnalogZeros();
+    vectX_t<T> aCoeff = polyCoeffFromConjugateRoots(poles);
+    vectX_t<T> bCoeff = polyCoeffFromConjugateRoots(zeros);
+
+    scaleAmplitude(aCoeff, bCoeff);
+    this->setCoeffs(std::move(aCoeff), std::move(bCoeff));
+}
+
+template <typename T, typename Accumulator>
+void Butterworth<T, Accumulator>::computeBandDigitalRep(T fLower, T fUpper)
+{
+    vectXc_t<T> poles = digitalBandPoles(fLower, fUpper);
+    vectXc_t<T> zeros = generateAnalogZeros(prewarpedCenter(fLower, fUpper));
+    vectX_t<T> aCoeff = polyCoeffFromConjugateRoots(poles);
+    vectX_t<T> bCoeff = polyCoeffFromConjugateRoots(zeros);
 
     if (m_type == Type::BandPass)
         scaleAmplitude(aCoeff, bCoeff, std::exp(std::complex<T>(T(0), T(2) * pi<T> * std::sqrt(fLower * fUpper) / m_fs)));
@@ -167,8 +202,8 @@ void Butterworth<T>::computeBandDigitalRep(T fLower, T fUpper)
     this->setCoeffs(std::move(aCoeff), std::move(bCoeff));
 }
 
-template <typename T>
-std::complex<T> Butterworth<T>::generateAnalogPole(int k, T fpw1)
+template <typename T, typename Accumulator>
+std::complex<T> Butterworth<T, Accumulator>::generateAnalogPole(int k, T fpw1) const
 {
     auto thetaK = [pi = pi<T>, order = m_order](int k) -> T {
         return static_cast<float>(2 * k - 1) * pi / static_cast<float>(2 * order);
@@ -185,8 +220,8 @@ std::complex<T> Butterworth<T>::generateAnalogPole(int k, T fpw1)
     }
 }
 
-template <typename T>
-std::pair<std::complex<T>, std::complex<T>> Butterworth<T>::generateBandAnalogPole(int k, T fpw0, T bw)
+template <typename T, typename Accumulator>
+std::pair<std::complex<T>, std::complex<T>> Butterworth<T, Accumulator>::generateBandAnalogPole(int k, T fpw0, T bw) const
 {
     auto thetaK = [pi = pi<T>, order = m_order](int k) -> T {
         return static_cast<float>(2 * k - 1) * pi / static_cast<float>(2 * order);
@@ -212,8 +247,8 @@ std::pair<std::complex<T>, std::complex<T>> Butterworth<T>::generateBandAnalogPo
     }
 }
 
-template <typename T>
-vectXc_t<T> Butterworth<T>::generateAnalogZeros(T fpw0)
+template <typename T, typename Accumulator>
+vectXc_t<T> Butterworth<T, Accumulator>::generateAnalogZeros(T fpw0) const
 {
     switch (m_type) {
     case Type::HighPass:
@@ -230,8 +265,8 @@ vectXc_t<T> Butterworth<T>::generateAnalogZeros(T fpw0)
     }
 }
 
-template <typename T>
-void Butterworth<T>::scaleAmplitude(const vectX_t<T>& aCoeff, Eigen::Ref<vectX_t<T>> bCoeff, const std::complex<T>& bpS)
+template <typename T, typename Accumulator>
+void Butterworth<T, Accumulator>::scaleAmplitude(const vectX_t<T>& aCoeff, Eigen::Ref<vectX_t<T>> bCoeff, const std::complex<T>& bpS)
 {
     T num = 0;
     T denum = 0;
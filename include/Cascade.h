@@ -0,0 +1,208 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+#pragma once
+
+#include "BaseFilter.h"
+#include "denormals.h"
+#include "gsl/gsl_assert.h"
+#include "typedefs.h"
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace difi {
+
+/*! \brief Scalar filters applied one after the other, fused into one kernel.
+ *
+ * Each sample goes through all the stages in one inlined call, and the intermediate values stay in registers.
+ * The block filter() runs a single loop over the samples instead of one loop per stage.
+ * The stages are copies of the given filters, they share their coefficients.
+ * A cascade is built by difi::cascade(f1, f2, f3) or f1 | f2 | f3.
+ * \code
+ * auto chain = difi::MovingAveraged(5) | difi::Butterworthd(4, 50, 1000) | difi::CenteredDiffNoiseRobust2d<9>();
+ * double y = chain.stepFilter(x);
+ * \endcode
+ * \tparam T Floating type.
+ * \tparam Filters Scalar filters with a noexcept stepFilterUnchecked(T) member, e.g. a DigitalFilter, a Butterworth filter or a differentiator.
+ */
+template <typename T, typename... Filters>
+class Cascade {
+    static_assert(sizeof...(Filters) > 0, "A cascade needs at least one filter.");
+    static_assert((std::is_same<details::filter_scalar_t<Filters>, T>::value && ...), "All the filters of a cascade must have the same floating type.");
+
+public:
+    /*! \brief Constructor.
+     * \param filters Stages, in the order they are applied.
+     */
+    explicit Cascade(const Filters&... filters)
+        : m_stages(filters...)
+    {}
+    /*! \brief Constructor.
+     * \param stages Stages, in the order they are applied.
+     */
+    explicit Cascade(std::tuple<Filters...> stages)
+        : m_stages(std::move(stages))
+    {}
+
+    /*! \brief Filter a new data through all the stages.
+     * \param data New data to filter.
+     * \return Filtered data.
+     */
+    T stepFilter(const T& data)
+    {
+        Expects(isInitialized());
+        return stepFilterUnchecked(data);
+    }
+    /*! \brief Filter a new data without checking the stages.
+     * \warning All the stages must be initialized.
+     * \param data New data to filter.
+     * \return Filtered data.
+     */
+    T stepFilterUnchecked(const T& data) noexcept
+    {
+        return std::apply([&data](Filters&... stages) {
+            T value = data;
+            ((value = stages.stepFilterUnchecked(value)), ...);
+            return value;
+        },
+            m_stages);
+    }
+    /*! \brief Filter a signal, in one loop over the samples.
+     * \param data Signal.
+     * \return Filtered signal.
+     */
+    vectX_t<T> filter(const vectX_t<T>& data)
+    {
+        vectX_t<T> results(data.size());
+        filter(data.data(), results.data(), data.size());
+        return results;
+    }
+    /*! \brief Filter a strided signal given by raw pointers.
+     * \param data Pointer to the first sample.
+     * \param results Pointer to the first filtered sample. It can be equal to data to filter in place.
+     * \param size Number of samples.
+     * \param dataStride Number of elements between two samples of data.
+     * \param resultsStride Number of elements between two samples of results.
+     */
+    void filter(const T* data, T* results, Eigen::Index size, Eigen::Index dataStride = 1, Eigen::Index resultsStride = 1)
+    {
+        Expects(isInitialized());
+        Expects(size >= 0);
+        Expects(size == 0 || (data != nullptr && results != nullptr));
+        Expects(dataStride > 0 && resultsStride > 0);
+        ScopedDenormalGuard guard;
+        for (Eigen::Index i = 0; i < size; ++i)
+            results[i * resultsStride] = stepFilterUnchecked(data[i * dataStride]);
+    }
+
+    /*! \brief Reset all the stages. */
+    void resetFilter() noexcept
+    {
+        std::apply([](Filters&... stages) { (stages.resetFilter(), ...); }, m_stages);
+    }
+    /*! \brief Return true if all the stages are initialized. */
+    bool isInitialized() const noexcept
+    {
+        return std::apply([](const Filters&... stages) { return (stages.isInitialized() && ...); }, m_stages);
+    }
+    /*! \brief Return the delay of the cascade in samples, the sum of the centers of the stages.
+     * \see BaseFilter::center
+     */
+    Eigen::Index center() const noexcept
+    {
+        return std::apply([](const Filters&... stages) { return (stages.center() + ...); }, m_stages);
+    }
+
+    /*! \brief Save or restore the stages through a snapshot archive, in the order they are applied.
+     *
+     * restoreSnapshot checks the layout and the sizes of all the stages before any of them is restored,
+     * but a stage rejecting the values of its fields leaves the stages before it restored.
+     * \see saveSnapshot, restoreSnapshot
+     */
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        std::apply([&ar](Filters&... stages) { (stages.serialize(ar), ...); }, m_stages);
+    }
+
+    /*! \brief Return the number of stages. */
+    static constexpr std::size_t size() noexcept { return sizeof...(Filters); }
+    /*! \brief Return the stage I. */
+    template <std::size_t I>
+    auto& stage() noexcept { return std::get<I>(m_stages); }
+    /*! \brief Return the stage I. */
+    template <std::size_t I>
+    const auto& stage() const noexcept { return std::get<I>(m_stages); }
+    /*! \brief Return all the stages. */
+    const std::tuple<Filters...>& stages() const noexcept { return m_stages; }
+
+private:
+    std::tuple<Filters...> m_stages;
+};
+
+/*! \brief Chain two filters. */
+template <typename F1, typename F2, typename = std::enable_if_t<details::is_filter<F1>::value && details::is_filter<F2>::value>>
+Cascade<details::filter_scalar_t<F1>, F1, F2> operator|(const F1& lhs, const F2& rhs)
+{
+    return Cascade<details::filter_scalar_t<F1>, F1, F2>(lhs, rhs);
+}
+
+/*! \brief Append a filter to a cascade. */
+template <typename T, typename... Filters, typename F, typename = std::enable_if_t<details::is_filter<F>::value>>
+Cascade<T, Filters..., F> operator|(const Cascade<T, Filters...>& lhs, const F& rhs)
+{
+    return Cascade<T, Filters..., F>(std::tuple_cat(lhs.stages(), std::tuple<F>(rhs)));
+}
+
+/*! \brief Prepend a filter to a cascade. */
+template <typename F, typename T, typename... Filters, typename = std::enable_if_t<details::is_filter<F>::value>>
+Cascade<T, F, Filters...> operator|(const F& lhs, const Cascade<T, Filters...>& rhs)
+{
+    return Cascade<T, F, Filters...>(std::tuple_cat(std::tuple<F>(lhs), rhs.stages()));
+}
+
+/*! \brief Chain two cascades. */
+template <typename T, typename... Filters1, typename... Filters2>
+Cascade<T, Filters1..., Filters2...> operator|(const Cascade<T, Filters1...>& lhs, const Cascade<T, Filters2...>& rhs)
+{
+    return Cascade<T, Filters1..., Filters2...>(std::tuple_cat(lhs.stages(), rhs.stages()));
+}
+
+/*! \brief Chain filters, in the order they are applied.
+ * \see Cascade
+ */
+template <typename First, typename... Others>
+auto cascade(const First& first, const Others&... others)
+{
+    if constexpr (sizeof...(Others) == 0)
+        return Cascade<details::filter_scalar_t<First>, First>(first);
+    else
+        return (first | ... | others);
+}
+
+} // namespace difi
@@ -0,0 +1,230 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include "BaseFilter.h"
+#include "FilterCoefficients.h"
+#include "gsl/gsl_assert.h"
+#include "mapped_file.h"
+#include "snapshot.h"
+#include "typedefs.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace difi {
+
+/*! \brief Version of the coefficient bank format. */
+constexpr const std::uint16_t COEFFICIENT_BANK_VERSION = 1;
+
+/*! \brief Representation of a design in a coefficient bank. */
+enum class BankEntryKind : std::uint8_t {
+    TransferFunction, /*!< Normalized \f$[a | b]\f$ coefficients */
+    SecondOrderSections /*!< Row-major \f$L\times 6\f$ sections \f$[b_0, b_1, b_2, 1, a_1, a_2]\f$ */
+};
+
+/*! \brief Header of a coefficient bank file.
+ *
+ * The header is followed by one BankDescriptor per design and by the payload.
+ * The descriptors and each design of the payload start on a 64-byte boundary.
+ * The data are stored in the byte order of the machine that wrote the bank, which is recorded in the header.
+ */
+struct BankHeader {
+    char magic[8]; /*!< "DIFIBANK" */
+    std::uint16_t version; /*!< Version of the format */
+    std::uint8_t scalarSize; /*!< Size of the floating type of the coefficients */
+    std::uint8_t littleEndian; /*!< 1 if the data are little-endian */
+    std::uint32_t reserved; /*!< Zero */
+    std::uint64_t count; /*!< Number of designs */
+    std::uint64_t descriptorOffset; /*!< Offset of the descriptors from the start of the file */
+    std::uint64_t payloadOffset; /*!< Offset of the payload from the start of the file */
+    std::uint64_t payloadSize; /*!< Size of the payload in bytes */
+    std::uint64_t checksum; /*!< FNV-1a hash of the descriptors and of the payload */
+    std::uint64_t reserved2; /*!< Zero */
+};
+
+/*! \brief Description of a design of a coefficient bank. */
+struct BankDescriptor {
+    std::uint64_t offset; /*!< Offset of the coefficients from the start of the payload */
+    std::uint32_t aSize; /*!< Number of denominator coefficients, or number of sections */
+    std::uint32_t bSize; /*!< Number of numerator coefficients, or 0 for sections */
+    BankEntryKind kind; /*!< Representation of the design */
+    FilterType type; /*!< Type of the filter */
+    std::uint8_t reserved[6]; /*!< Zero */
+};
+
+static_assert(sizeof(BankHeader) == 64 && std::is_trivially_copyable<BankHeader>::value, "The bank header must be packed.");
+static_assert(sizeof(BankDescriptor) == 24 && std::is_trivially_copyable<BankDescriptor>::value, "The bank descriptors must be packed.");
+
+/*! \brief Bank of filter designs referenced in place.
+ *
+ * A bank is produced offline by CoefficientBankWriter and memory-mapped at startup.
+ * Opening a bank only reads its header and its descriptors. The filters then point directly to the mapped coefficients:
+ * nothing is parsed nor copied, and a design is paged in when a filter first uses it.
+ * The coefficients returned by a bank keep the bank alive.
+ * \code
+ * auto bank = difi::CoefficientBank<double>::open("designs.bank");
+ * difi::DigitalFilterd filter(bank->coefficients(42), bank->type(42));
+ * \endcode
+ * \tparam T Floating type of the coefficients.
+ */
+template <typename T>
+class CoefficientBank : public std::enable_shared_from_this<CoefficientBank<T>> {
+    static_assert(std::is_floating_point<T>::value && !std::is_const<T>::value, "Only accept non-complex floating point types.");
+    struct Token {
+    };
+
+public:
+    using sections_t = Eigen::Matrix<T, Eigen::Dynamic, 6, Eigen::RowMajor>;
+
+    /*! \brief Map a bank file.
+     * \param path Path of the bank.
+     */
+    static std::shared_ptr<const CoefficientBank> open(const std::string& path)
+    {
+        details::MappedFile file(path);
+        const std::byte* data = file.data();
+        const std::size_t size = file.size();
+        return std::make_shared<const CoefficientBank>(Token{}, std::move(file), data, size);
+    }
+    /*! \brief Use a bank already in memory, without copy.
+     * \param data Bank, aligned at least on T. It must outlive the bank and all the filters that use it.
+     * \param size Size of the bank.
+     */
+    static std::shared_ptr<const CoefficientBank> view(const void* data, std::size_t size)
+    {
+        return std::make_shared<const CoefficientBank>(Token{}, details::MappedFile{}, static_cast<const std::byte*>(data), size);
+    }
+
+    /*! \brief Constructor. Use open or view. */
+    CoefficientBank(Token, details::MappedFile&& file, const std::byte* data, std::size_t size);
+
+    /*! \brief Return the number of designs. */
+    std::size_t size() const noexcept { return m_entries.size(); }
+    /*! \brief Return the representation of a design. */
+    BankEntryKind kind(std::size_t i) const
+    {
+        Expects(i < size());
+        return m_entries[i].kind;
+    }
+    /*! \brief Return the filter type of a design. */
+    FilterType type(std::size_t i) const
+    {
+        Expects(i < size());
+        return m_entries[i].type;
+    }
+    /*! \brief Return the coefficients of a transfer function design, in place.
+     *
+     * The returned pointer shares the ownership of the bank.
+     * \param i Index of the design.
+     */
+    std::shared_ptr<const FilterCoefficients<T>> coefficients(std::size_t i) const;
+    /*! \brief Return the sections of a second-order sections design, in place.
+     * \param i Index of the design.
+     */
+    Eigen::Map<const sections_t> secondOrderSections(std::size_t i) const;
+    /*! \brief Check the checksum of the whole bank.
+     *
+     * It reads all the designs, so it is not done by open.
+     */
+    bool verify() const noexcept;
+
+private:
+    struct Entry {
+        BankEntryKind kind;
+        FilterType type;
+        FilterCoefficients<T> coeffs; /*!< View on a transfer function */
+    };
+
+    details::MappedFile m_file; /*!< Owner of the mapping (empty for a view) */
+    const std::byte* m_data; /*!< Start of the bank */
+    std::size_t m_size; /*!< Size of the bank */
+    std::vector<Entry> m_entries; /*!< Designs */
+};
+
+/*! \brief Builder of coefficient bank files.
+ * \tparam T Floating type of the coefficients.
+ */
+template <typename T>
+class CoefficientBankWriter {
+    static_assert(std::is_floating_point<T>::value && !std::is_const<T>::value, "Only accept non-complex floating point types.");
+
+public:
+    /*! \brief Add a transfer function design.
+     * \param aCoeff Denominator coefficients of the filter in decreasing order. They are normalized.
+     * \param bCoeff Numerator coefficients of the filter in decreasing order.
+     * \param type Type of the filter.
+     * \return Index of the design in the bank.
+     */
+    template <typename AVector, typename BVector>
+    std::size_t add(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff, FilterType type = FilterType::Backward);
+    /*! \brief Add the design of a filter.
+     * \param filter Initialized filter.
+     * \return Index of the design in the bank.
+     */
+    template <typename Derived>
+    std::size_t add(const BaseFilter<T, Derived>& filter)
+    {
+        Expects(filter.isInitialized());
+        return add(filter.aCoeff(), filter.bCoeff(), filter.type());
+    }
+    /*! \brief Add a second-order sections design.
+     * \param sos Sections as rows \f$[b_0, b_1, b_2, a_0, a_1, a_2]\f$. They are normalized.
+     * \return Index of the design in the bank.
+     * \see Butterworth::secondOrderSections
+     */
+    std::size_t addSections(const matX_t<T>& sos);
+
+    /*! \brief Return the number of designs. */
+    std::size_t size() const noexcept { return m_entries.size(); }
+    /*! \brief Return the bank. */
+    std::vector<std::byte> bytes() const;
+    /*! \brief Write the bank into a file.
+     * \param path Path of the file.
+     */
+    void write(const std::string& path) const;
+
+private:
+    struct Entry {
+        BankEntryKind kind;
+        FilterType type;
+        std::uint32_t aSize;
+        std::uint32_t bSize;
+        vectX_t<T> data;
+    };
+
+    std::vector<Entry> m_entries;
+};
+
+} // namespace difi
+
+#include "CoefficientBank.tpp"
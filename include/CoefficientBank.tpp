@@ -0,0 +1,184 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#include <limits>
+
+namespace difi {
+
+namespace details {
+
+constexpr std::size_t alignedSize(std::size_t size, std::size_t alignment = 64) noexcept { return (size + alignment - 1) / alignment * alignment; }
+
+} // namespace details
+
+/*
+ * CoefficientBank
+ */
+
+template <typename T>
+CoefficientBank<T>::CoefficientBank(Token, details::MappedFile&& file, const std::byte* data, std::size_t size)
+    : m_file(std::move(file))
+    , m_data(data)
+    , m_size(size)
+{
+    Expects(reinterpret_cast<std::uintptr_t>(m_data) % alignof(T) == 0);
+    Expects(m_size >= sizeof(BankHeader));
+    BankHeader header;
+    std::memcpy(&header, m_data, sizeof(header));
+    Expects(std::memcmp(header.magic, "DIFIBANK", 8) == 0);
+    Expects(header.version == COEFFICIENT_BANK_VERSION);
+    Expects(header.scalarSize == sizeof(T));
+    Expects(header.littleEndian == static_cast<std::uint8_t>(details::isLittleEndian()));
+    Expects(header.descriptorOffset % 64 == 0 && header.payloadOffset % 64 == 0);
+    Expects(header.payloadOffset <= m_size && header.payloadSize <= m_size - header.payloadOffset);
+    Expects(header.descriptorOffset <= header.payloadOffset && header.count <= (header.payloadOffset - header.descriptorOffset) / sizeof(BankDescriptor));
+
+    // The only work done at startup: one view per design, and the spectrum of the long FIR filters
+    const std::byte* payload = m_data + header.payloadOffset;
+    m_entries.reserve(header.count);
+    for (std::uint64_t i = 0; i < header.count; ++i) {
+        BankDescriptor d;
+        std::memcpy(&d, m_data + header.descriptorOffset + i * sizeof(BankDescriptor), sizeof(d));
+        Expects(d.kind == BankEntryKind::TransferFunction || d.kind == BankEntryKind::SecondOrderSections);
+        Expects(d.type == FilterType::Backward || d.type == FilterType::Centered);
+        Expects(d.offset % 64 == 0 && d.aSize > 0);
+        const std::uint64_t nrCoeffs = d.kind == BankEntryKind::TransferFunction ? std::uint64_t(d.aSize) + d.bSize : std::uint64_t(6) * d.aSize;
+        Expects(d.kind == BankEntryKind::TransferFunction ? d.bSize > 0 : d.bSize == 0);
+        Expects(d.offset <= header.payloadSize && nrCoeffs <= (header.payloadSize - d.offset) / sizeof(T));
+
+        const T* coeffs = reinterpret_cast<const T*>(payload + d.offset);
+        m_entries.push_back({ d.kind, d.type, FilterCoefficients<T>(coeffs, d.aSize, static_cast<Eigen::Index>(nrCoeffs)) });
+        if (d.kind == BankEntryKind::TransferFunction)
+            m_entries.back().coeffs.computeSpectrum();
+    }
+}
+
+template <typename T>
+std::shared_ptr<const FilterCoefficients<T>> CoefficientBank<T>::coefficients(std::size_t i) const
+{
+    Expects(i < size() && m_entries[i].kind == BankEntryKind::TransferFunction);
+    const FilterCoefficients<T>& coeffs = m_entries[i].coeffs;
+    Expects(coeffs.aCoeff()(0) == T(1));
+    return std::shared_ptr<const FilterCoefficients<T>>(this->shared_from_this(), &coeffs);
+}
+
+template <typename T>
+Eigen::Map<const typename CoefficientBank<T>::sections_t> CoefficientBank<T>::secondOrderSections(std::size_t i) const
+{
+    Expects(i < size() && m_entries[i].kind == BankEntryKind::SecondOrderSections);
+    const FilterCoefficients<T>& coeffs = m_entries[i].coeffs;
+    return { coeffs.aCoeff().data(), coeffs.aOrder(), 6 };
+}
+
+template <typename T>
+bool CoefficientBank<T>::verify() const noexcept
+{
+    BankHeader header;
+    std::memcpy(&header, m_data, sizeof(header));
+    const std::uint64_t hash = details::fnv1a(m_data + header.descriptorOffset, header.count * sizeof(BankDescriptor));
+    return header.checksum == details::fnv1a(m_data + header.payloadOffset, header.payloadSize, hash);
+}
+
+/*
+ * CoefficientBankWriter
+ */
+
+template <typename T>
+template <typename AVector, typename BVector>
+std::size_t CoefficientBankWriter<T>::add(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff, FilterType type)
+{
+    // Normalized as a filter would do it, so that the bank is used in place
+    const FilterCoefficients<T> coeffs(aCoeff, bCoeff);
+    Expects(type == FilterType::Centered ? coeffs.bOrder() % 2 == 1 : true);
+    Expects(coeffs.aOrder() <= std::numeric_limits<std::uint32_t>::max() && coeffs.bOrder() <= std::numeric_limits<std::uint32_t>::max());
+    vectX_t<T> data(coeffs.aOrder() + coeffs.bOrder());
+    data << coeffs.aCoeff(), coeffs.bCoeff();
+    m_entries.push_back({ BankEntryKind::TransferFunction, type, static_cast<std::uint32_t>(coeffs.aOrder()), static_cast<std::uint32_t>(coeffs.bOrder()), std::move(data) });
+    return m_entries.size() - 1;
+}
+
+template <typename T>
+std::size_t CoefficientBankWriter<T>::addSections(const matX_t<T>& sos)
+{
+    Expects(sos.rows() > 0 && sos.cols() == 6);
+    Expects((sos.col(3).array().abs() > std::numeric_limits<T>::epsilon()).all());
+    Expects(sos.rows() <= std::numeric_limits<std::uint32_t>::max());
+    vectX_t<T> data(6 * sos.rows());
+    for (Eigen::Index i = 0; i < sos.rows(); ++i)
+        data.segment(6 * i, 6) = sos.row(i).transpose() / sos(i, 3);
+    m_entries.push_back({ BankEntryKind::SecondOrderSections, FilterType::Backward, static_cast<std::uint32_t>(sos.rows()), 0, std::move(data) });
+    return m_entries.size() - 1;
+}
+
+template <typename T>
+std::vector<std::byte> CoefficientBankWriter<T>::bytes() const
+{
+    BankHeader header = {};
+    std::memcpy(header.magic, "DIFIBANK", 8);
+    header.version = COEFFICIENT_BANK_VERSION;
+    header.scalarSize = sizeof(T);
+    header.littleEndian = static_cast<std::uint8_t>(details::isLittleEndian());
+    header.count = m_entries.size();
+    header.descriptorOffset = details::alignedSize(sizeof(BankHeader));
+    header.payloadOffset = details::alignedSize(header.descriptorOffset + m_entries.size() * sizeof(BankDescriptor));
+
+    std::vector<BankDescriptor> descriptors(m_entries.size());
+    std::uint64_t offset = 0;
+    for (std::size_t i = 0; i < m_entries.size(); ++i) {
+        descriptors[i] = {};
+        descriptors[i].offset = offset;
+        descriptors[i].aSize = m_entries[i].aSize;
+        descriptors[i].bSize = m_entries[i].bSize;
+        descriptors[i].kind = m_entries[i].kind;
+        descriptors[i].type = m_entries[i].type;
+        offset += details::alignedSize(static_cast<std::size_t>(m_entries[i].data.size()) * sizeof(T));
+    }
+    header.payloadSize = offset;
+
+    std::vector<std::byte> bank(header.payloadOffset + header.payloadSize);
+    std::byte* payload = bank.data() + header.payloadOffset;
+    if (!descriptors.empty())
+        std::memcpy(bank.data() + header.descriptorOffset, descriptors.data(), descriptors.size() * sizeof(BankDescriptor));
+    for (std::size_t i = 0; i < m_entries.size(); ++i)
+        std::memcpy(payload + descriptors[i].offset, m_entries[i].data.data(), static_cast<std::size_t>(m_entries[i].data.size()) * sizeof(T));
+
+    const std::uint64_t hash = details::fnv1a(bank.data() + header.descriptorOffset, descriptors.size() * sizeof(BankDescriptor));
+    header.checksum = details::fnv1a(payload, header.payloadSize, hash);
+    std::memcpy(bank.data(), &header, sizeof(header));
+    return bank;
+}
+
+template <typename T>
+void CoefficientBankWriter<T>::write(const std::string& path) const
+{
+    const std::vector<std::byte> bank = bytes();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bank.data()), static_cast<std::streamsize>(bank.size()));
+    Expects(file.good());
+}
+
+} // namespace difi
@@ -0,0 +1,275 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+#pragma once
+
+#include "DigitalFilter.h"
+#include "FilterCoefficients.h"
+#include "gsl/gsl_assert.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace difi {
+
+/*! \brief Hand-over of new coefficients from a tuning thread to a real-time thread.
+ *
+ * The slot is double-buffered, in the manner of RCU: the tuning thread prepares the new coefficients off-line (e.g. a new Butterworth design)
+ * and publishes them in the buffer that the real-time thread does not read.
+ * The real-time thread picks them up at its next sample boundary with update(), without lock, allocation nor reset of the filter state.
+ * The slot keeps a reference on the last two designs. A design is thus never destroyed by the real-time thread:
+ * it is released by the tuning thread when a later publication overwrites it.
+ * The orders of the filter can't change, so that its data history stays meaningful.
+ * \code
+ * difi::Butterworthd bf(4, 10, 1000);
+ * difi::CoefficientSlotd slot(bf.coefficients());
+ * // Tuning thread
+ * slot.publish(difi::Butterworthd(4, 20, 1000).coefficients());
+ * // Real-time thread
+ * slot.update(bf);
+ * y = bf.stepFilter(x);
+ * \endcode
+ * \tparam T Floating type.
+ */
+template <typename T>
+class CoefficientSlot {
+public:
+    /*! \brief Constructor.
+     * \param initial Coefficients used by the filter when the slot is created.
+     */
+    explicit CoefficientSlot(std::shared_ptr<const FilterCoefficients<T>> initial)
+    {
+        Expects(initial != nullptr);
+        m_aOrder = initial->aOrder();
+        m_bOrder = initial->bOrder();
+        m_buffers[0] = std::move(initial);
+    }
+    CoefficientSlot(const CoefficientSlot&) = delete;
+    CoefficientSlot& operator=(const CoefficientSlot&) = delete;
+
+    /*! \brief Publish new coefficients if the real-time thread picked up the previous ones (tuning thread).
+     * \param coeffs Coefficients of the same orders as the initial ones.
+     * \return False if the previous coefficients are still pending.
+     */
+    bool tryPublish(std::shared_ptr<const FilterCoefficients<T>> coeffs)
+    {
+        Expects(coeffs != nullptr);
+        Expects(coeffs->aOrder() == m_aOrder && coeffs->bOrder() == m_bOrder);
+        std::lock_guard<std::mutex> lock(m_publishMutex);
+        const std::uint64_t published = m_published.load(std::memory_order_relaxed);
+        if (m_acknowledged.load(std::memory_order_acquire) != published)
+            return false;
+        // The real-time thread reads the other buffer, or nothing
+        m_buffers[(published + 1) & 1] = std::move(coeffs);
+        m_published.store(published + 1, std::memory_order_release);
+        return true;
+    }
+    /*! \brief Publish new coefficients, waiting for the real-time thread to pick up the previous ones (tuning thread).
+     * \param coeffs Coefficients of the same orders as the initial ones.
+     */
+    void publish(const std::shared_ptr<const FilterCoefficients<T>>& coeffs)
+    {
+        while (!tryPublish(coeffs))
+            std::this_thread::yield();
+    }
+
+    /*! \brief Give the coefficients published since the last call to the filter (real-time thread).
+     *
+     * The filter keeps its data history. It neither locks nor allocates.
+     * \param filter Filter using the coefficients of the slot.
+     * \return True if the coefficients changed.
+     */
+    template <typename Filter>
+    bool update(Filter& filter)
+    {
+        const auto* coeffs = pending();
+        if (!coeffs)
+            return false;
+        filter.swapCoeffs(*coeffs);
+        acknowledge();
+        return true;
+    }
+
+    /*! \brief Return the coefficients published and not acknowledged yet, or null (real-time thread).
+     *
+     * They stay valid until acknowledge() is called.
+     */
+    const std::shared_ptr<const FilterCoefficients<T>>* pending() const noexcept
+    {
+        const std::uint64_t published = m_published.load(std::memory_order_acquire);
+        return published == m_acknowledged.load(std::memory_order_relaxed) ? nullptr : &m_buffers[published & 1];
+    }
+    /*! \brief Acknowledge the pending coefficients, so that the tuning thread can publish again (real-time thread).
+     * \warning The real-time thread must not hold the coefficients published before the pending ones anymore,
+     * they may be destroyed by the next publication.
+     */
+    void acknowledge() noexcept { m_acknowledged.store(m_published.load(std::memory_order_relaxed), std::memory_order_release); }
+
+    /*! \brief Return the order of the denominator of the coefficients. */
+    Eigen::Index aOrder() const noexcept { return m_aOrder; }
+    /*! \brief Return the order of the numerator of the coefficients. */
+    Eigen::Index bOrder() const noexcept { return m_bOrder; }
+
+private:
+    Eigen::Index m_aOrder;
+    Eigen::Index m_bOrder;
+    std::shared_ptr<const FilterCoefficients<T>> m_buffers[2];
+    std::mutex m_publishMutex; /*!< Serializes the tuning threads, never taken by the real-time thread */
+    alignas(64) std::atomic<std::uint64_t> m_published{ 0 }; /*!< Number of publications, written by the tuning thread */
+    alignas(64) std::atomic<std::uint64_t> m_acknowledged{ 0 }; /*!< Number of publications picked up, written by the real-time thread */
+};
+
+/*! \brief Scalar filter whose coefficients can be changed from another thread while it is running.
+ *
+ * The new coefficients are picked up at a sample boundary through a CoefficientSlot.
+ * Without cross-fade, the filter continues from its current data history with the new coefficients.
+ * With a cross-fade of N samples, a copy of the filter with the new coefficients starts from the same history,
+ * and the output moves linearly from the old filter to the new one over N samples, hiding the transient of the switch.
+ * The copy is made when the filter is constructed, so the switch never allocates.
+ * \tparam T Floating type.
+ * \tparam Filter Scalar filter, e.g. a DigitalFilter or a Butterworth filter.
+ */
+template <typename T, typename Filter = DigitalFilter<T>>
+class HotSwapFilter {
+public:
+    /*! \brief Constructor.
+     * \param filter Initialized filter.
+     * \param fadeLength Number of samples of the cross-fade, 0 to switch at once.
+     */
+    explicit HotSwapFilter(const Filter& filter, std::size_t fadeLength = 0)
+        : m_filters{ filter, filter }
+        , m_slot(filter.coefficients())
+        , m_fadeLength(fadeLength)
+    {}
+
+    /*! \brief Publish new coefficients if the previous ones were picked up (tuning thread).
+     * \see CoefficientSlot::tryPublish
+     */
+    bool tryPublish(std::shared_ptr<const FilterCoefficients<T>> coeffs) { return m_slot.tryPublish(std::move(coeffs)); }
+    /*! \brief Publish new coefficients (tuning thread).
+     * \see CoefficientSlot::publish
+     */
+    void publish(const std::shared_ptr<const FilterCoefficients<T>>& coeffs) { m_slot.publish(coeffs); }
+
+    /*! \brief Filter a new data, with the last published coefficients (real-time thread).
+     * \param data New data to filter.
+     * \return Filtered data.
+     */
+    T stepFilter(const T& data)
+    {
+        if (m_fadePosition == 0)
+            pickUp();
+        const T result = m_filters[m_active].stepFilter(data);
+        if (m_fadePosition == 0)
+            return result;
+
+        const T old = m_filters[1 - m_active].stepFilter(data);
+        const T weight = static_cast<T>(m_fadePosition) / static_cast<T>(m_fadeLength + 1);
+        if (--m_fadePosition == 0) {
+            // Release the old coefficients while the slot still holds them
+            m_filters[1 - m_active] = m_filters[m_active];
+            m_slot.acknowledge();
+        }
+        return result + weight * (old - result);
+    }
+    /*! \brief Reset the filter and stop the cross-fade (real-time thread). */
+    void resetFilter()
+    {
+        if (m_fadePosition > 0) {
+            m_fadePosition = 0;
+            m_filters[1 - m_active] = m_filters[m_active];
+            m_slot.acknowledge();
+        }
+        m_filters[m_active].resetFilter();
+    }
+
+    /*! \brief Save or restore the filter with the newest coefficients through a snapshot archive (real-time thread).
+     *
+     * A cross-fade is not saved, restoring ends it.
+     * The filter not in use is restored and then becomes the active one, so that a rejected snapshot leaves the running filter unchanged.
+     * The restored coefficients, of the orders of the slot, are used until the next publication.
+     * \see saveSnapshot, restoreSnapshot
+     */
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        if constexpr (Archive::IsLoading) {
+            const int restored = 1 - m_active;
+            m_filters[restored].serialize(ar);
+            Expects(m_filters[restored].aOrder() == m_slot.aOrder() && m_filters[restored].bOrder() == m_slot.bOrder());
+            m_active = restored;
+            // The history is copied without allocation, the filters have the same size
+            m_filters[1 - m_active] = m_filters[m_active];
+            if (m_fadePosition > 0) {
+                m_fadePosition = 0;
+                m_slot.acknowledge();
+            }
+        } else {
+            m_filters[m_active].serialize(ar);
+        }
+    }
+
+    /*! \brief Return true if the filter is initialized. */
+    bool isInitialized() const noexcept { return m_filters[m_active].isInitialized(); }
+    /*! \brief Return the filter with the newest coefficients. */
+    const Filter& filter() const noexcept { return m_filters[m_active]; }
+    /*! \brief Return true during a cross-fade. */
+    bool isFading() const noexcept { return m_fadePosition > 0; }
+    /*! \brief Return the number of samples of the cross-fade. */
+    std::size_t fadeLength() const noexcept { return m_fadeLength; }
+
+private:
+    void pickUp()
+    {
+        const auto* coeffs = m_slot.pending();
+        if (!coeffs)
+            return;
+        if (m_fadeLength == 0) {
+            m_filters[m_active].swapCoeffs(*coeffs);
+            m_slot.acknowledge();
+            return;
+        }
+        // The history is copied without allocation, the filters have the same size
+        const int next = 1 - m_active;
+        m_filters[next] = m_filters[m_active];
+        m_filters[next].swapCoeffs(*coeffs);
+        m_active = next;
+        m_fadePosition = m_fadeLength;
+        // The old filter still uses the previous coefficients, they are acknowledged at the end of the fade
+    }
+
+private:
+    Filter m_filters[2];
+    CoefficientSlot<T> m_slot;
+    std::size_t m_fadeLength;
+    std::size_t m_fadePosition = 0; /*!< Remaining samples of the cross-fade */
+    int m_active = 0;
+};
+
+} // namespace difi
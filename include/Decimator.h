@@ -0,0 +1,248 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include "BaseFilter.h"
+#include "FilterCoefficients.h"
+#include "buffer.h"
+#include "denormals.h"
+#include "gsl/gsl_assert.h"
+#include "typedefs.h"
+#include <algorithm>
+#include <memory>
+
+namespace difi {
+
+/*! \brief Anti-alias filter fused with a downsampling.
+ *
+ * Only one output out of factor() is kept, starting with the first one, and only the kept outputs are computed.
+ * The filter runs in direct form II: the recursive part \f$w_n = x_n - \sum_{k\geq1} a_k w_{n-k}\f$ advances at every sample,
+ * and the numerator \f$y_n = \sum_k b_k w_{n-k}\f$ is only evaluated for the kept outputs.
+ * For a FIR anti-alias filter (e.g. a MovingAverage), the recursive part vanishes and a sample costs a single write
+ * until an output is due, which is the cost of a polyphase decimator.
+ * \code
+ * difi::Decimatord decimator(difi::Butterworthd(4, 40, 1000), 10);
+ * double y;
+ * if (decimator.stepFilter(x, y))
+ *     process(y); // at 100Hz
+ * \endcode
+ * The coefficients and the history are allocated at construction from the default std::pmr memory resource.
+ * \tparam T Floating type.
+ */
+template <typename T>
+class Decimator {
+    static_assert(std::is_floating_point<T>::value, "Only accept floating point types.");
+
+public:
+    /*! \brief Constructor.
+     * \param coeffs Coefficients of the anti-alias filter.
+     * \param factor Downsampling factor.
+     */
+    Decimator(std::shared_ptr<const FilterCoefficients<T>> coeffs, int factor);
+    /*! \brief Constructor from an existing design, sharing its coefficients.
+     * \param antiAlias Initialized anti-alias filter, e.g. a Butterworth or a MovingAverage filter.
+     * \param factor Downsampling factor.
+     */
+    template <typename Derived>
+    Decimator(const BaseFilter<T, Derived>& antiAlias, int factor)
+        : Decimator(antiAlias.coefficients(), factor)
+    {}
+
+    /*! \brief Filter a new data.
+     * \param data New data to filter.
+     * \param[out] output Filtered and downsampled data, only written if the function returns true.
+     * \return True if an output is produced, once every factor() samples.
+     */
+    bool stepFilter(const T& data, T& output) noexcept;
+    /*! \brief Filter and downsample a signal.
+     * \param data Signal.
+     * \return Kept outputs.
+     */
+    vectX_t<T> filter(const vectX_t<T>& data);
+    /*! \brief Filter and downsample a strided signal given by raw pointers.
+     * \param data Pointer to the first sample.
+     * \param results Pointer to the first output. It can be equal to data to decimate in place if resultsStride <= dataStride.
+     * \param size Number of samples.
+     * \param dataStride Number of elements between two samples of data.
+     * \param resultsStride Number of elements between two outputs.
+     * \return Number of outputs written.
+     */
+    Eigen::Index filter(const T* data, T* results, Eigen::Index size, Eigen::Index dataStride = 1, Eigen::Index resultsStride = 1);
+    /*! \brief Reset the history, the next sample gives an output. */
+    void resetFilter() noexcept;
+    /*! \brief Save or restore the decimator through a snapshot archive.
+     * \see saveSnapshot, restoreSnapshot
+     */
+    template <typename Archive>
+    void serialize(Archive& ar);
+
+    /*! \brief Return true, the decimator is initialized at construction. */
+    bool isInitialized() const noexcept { return true; }
+    /*! \brief Return the downsampling factor. */
+    int factor() const noexcept { return m_factor; }
+    /*! \brief Return the number of samples before the next output. */
+    int samplesBeforeOutput() const noexcept { return m_phase == 0 ? 0 : m_factor - m_phase; }
+    /*! \brief Return the shared coefficients of the anti-alias filter. */
+    const std::shared_ptr<const FilterCoefficients<T>>& coefficients() const noexcept { return m_coeffs; }
+
+private:
+    /*! \brief Lay out the coefficients for the kernel and size the history. */
+    void coeffsChanged();
+
+private:
+    std::shared_ptr<const FilterCoefficients<T>> m_coeffs;
+    int m_factor;
+    Eigen::Index m_size = 0; /*!< Length of the history */
+    details::Buffer<T> m_aCoeff; /*!< Recursive coefficients a_1..a_n, the oldest sample first */
+    details::Buffer<T> m_bCoeff; /*!< Numerator coefficients, the oldest sample first */
+    details::Buffer<T> m_history; /*!< Ring of the last states, written twice so that the last m_size ones are contiguous */
+    Eigen::Index m_position = 0; /*!< Position of the oldest state */
+    int m_phase = 0; /*!< Number of samples since the last output */
+};
+
+template <typename T>
+Decimator<T>::Decimator(std::shared_ptr<const FilterCoefficients<T>> coeffs, int factor)
+    : m_coeffs(std::move(coeffs))
+    , m_factor(factor)
+{
+    Expects(m_coeffs != nullptr);
+    Expects(factor > 0);
+    coeffsChanged();
+    resetFilter();
+}
+
+template <typename T>
+bool Decimator<T>::stepFilter(const T& data, T& output) noexcept
+{
+    const Eigen::Index nrRecursive = m_aCoeff.size();
+    const Eigen::Index nrTaps = m_bCoeff.size();
+    T state = data;
+    if (nrRecursive > 0)
+        state -= m_aCoeff.vector().dot(m_history.segment(m_position + m_size - nrRecursive, nrRecursive));
+
+    m_history.data()[m_position] = state;
+    m_history.data()[m_position + m_size] = state;
+    if (++m_position == m_size)
+        m_position = 0;
+
+    const bool isKept = m_phase == 0;
+    if (isKept)
+        output = m_bCoeff.vector().dot(m_history.segment(m_position + m_size - nrTaps, nrTaps));
+    if (++m_phase == m_factor)
+        m_phase = 0;
+    return isKept;
+}
+
+template <typename T>
+vectX_t<T> Decimator<T>::filter(const vectX_t<T>& data)
+{
+    const Eigen::Index first = samplesBeforeOutput();
+    vectX_t<T> results(data.size() > first ? (data.size() - first - 1) / m_factor + 1 : 0);
+    filter(data.data(), results.data(), data.size());
+    return results;
+}
+
+template <typename T>
+Eigen::Index Decimator<T>::filter(const T* data, T* results, Eigen::Index size, Eigen::Index dataStride, Eigen::Index resultsStride)
+{
+    Expects(size >= 0);
+    Expects(size == 0 || (data != nullptr && results != nullptr));
+    Expects(dataStride > 0 && resultsStride > 0);
+    ScopedDenormalGuard guard;
+    // Outputs are written behind the samples already read, so data and results can alias
+    Eigen::Index nrOutputs = 0;
+    for (Eigen::Index i = 0; i < size; ++i) {
+        T output;
+        if (stepFilter(data[i * dataStride], output))
+            results[nrOutputs++ * resultsStride] = output;
+    }
+    return nrOutputs;
+}
+
+template <typename T>
+void Decimator<T>::resetFilter() noexcept
+{
+    std::fill_n(m_history.data(), m_history.size(), T(0));
+    m_position = 0;
+    m_phase = 0;
+}
+
+template <typename T>
+template <typename Archive>
+void Decimator<T>::serialize(Archive& ar)
+{
+    if constexpr (Archive::IsLoading) {
+        // Everything is read and checked before the decimator is modified
+        int factor;
+        Eigen::Index position;
+        int phase;
+        ar(factor);
+        const auto aCoeff = ar.template array<T>();
+        const auto bCoeff = ar.template array<T>();
+        const auto history = ar.template array<T>();
+        ar(position);
+        ar(phase);
+        Expects(factor > 0);
+        Expects(FilterCoefficients<T>::isValid(aCoeff, bCoeff));
+        const Eigen::Index size = std::max(aCoeff.size() - 1, bCoeff.size());
+        Expects(history.size() == 2 * size);
+        Expects(position >= 0 && position < size && phase >= 0 && phase < factor);
+
+        // Decimators sharing the same design keep sharing it
+        if (aCoeff.size() != m_coeffs->aOrder() || bCoeff.size() != m_coeffs->bOrder() || aCoeff != m_coeffs->aCoeff() || bCoeff != m_coeffs->bCoeff()) {
+            m_coeffs = FilterCoefficients<T>::create(aCoeff, bCoeff);
+            coeffsChanged();
+        }
+        m_factor = factor;
+        m_history.vector() = history;
+        m_position = position;
+        m_phase = phase;
+    } else {
+        ar(m_factor);
+        ar(m_coeffs->aCoeff());
+        ar(m_coeffs->bCoeff());
+        ar(m_history);
+        ar(m_position);
+        ar(m_phase);
+    }
+}
+
+template <typename T>
+void Decimator<T>::coeffsChanged()
+{
+    const Eigen::Index aOrder = m_coeffs->aOrder();
+    const Eigen::Index bOrder = m_coeffs->bOrder();
+    m_size = std::max(aOrder - 1, bOrder);
+    m_aCoeff.resize(aOrder - 1);
+    m_aCoeff.vector() = m_coeffs->aCoeff().tail(aOrder - 1).reverse();
+    m_bCoeff.resize(bOrder);
+    m_bCoeff.vector() = m_coeffs->bCoeff().reverse();
+    m_history.resize(2 * m_size);
+}
+
+} // namespace difi
@@ -28,7 +28,10 @@
 #pragma once
 
 #include "GenericFilter.h"
+#include "VectorGenericFilter.h"
 #include "typedefs.h"
+#include <memory_resource>
+#include <utility>
 
 namespace difi {
 
@@ -36,19 +39,99 @@ namespace difi {
  * 
  * This filter allows you to set any digital filter based on its coefficients.
  * \tparam T Floating type.
+ * \tparam Accumulator Floating type used to compute the output, or CompensatedSum.
  */
-template <typename T>
-class DigitalFilter : public GenericFilter<T> {
+template <typename T, typename Accumulator = T>
+class DigitalFilter final : public GenericFilter<T, Accumulator> {
 public:
     /*! \brief Default uninitialized constructor. */
     DigitalFilter() = default;
+    /*! \brief Uninitialized constructor.
+     * \param resource Memory resource of the data history and of the coefficients set later.
+     */
+    explicit DigitalFilter(std::pmr::memory_resource* resource) noexcept
+        : GenericFilter<T, Accumulator>(resource)
+    {
+    }
+    /*! \brief Constructor.
+     * \param aCoeff Denominator coefficients of the filter in decreasing order.
+     * \param bCoeff Numerator coefficients of the filter in decreasing order.
+     * \param type Type of the filter.
+     * \param resource Memory resource of the data history and of the coefficients.
+     */
+    template <typename AVector, typename BVector>
+    DigitalFilter(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : GenericFilter<T, Accumulator>(aCoeff, bCoeff, type, resource)
+    {
+    }
+    /*! \brief Constructor adopting the storage of the coefficients.
+     * \param aCoeff Denominator coefficients of the filter in decreasing order.
+     * \param bCoeff Numerator coefficients of the filter in decreasing order.
+     * \param type Type of the filter.
+     * \param resource Memory resource of the data history and of the coefficients.
+     */
+    template <typename Vector, typename = internal::enable_if_rvalue_t<Vector, vectX_t<T>>>
+    DigitalFilter(Vector&& aCoeff, Vector&& bCoeff, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : GenericFilter<T, Accumulator>(std::move(aCoeff), std::move(bCoeff), type, resource)
+    {
+    }
+    /*! \brief Constructor sharing existing coefficients.
+     * \param coeffs Coefficients of the filter, e.g. the coefficients() of another filter.
+     * \param type Type of the filter.
+     * \param resource Memory resource of the data history and of the coefficients.
+     */
+    explicit DigitalFilter(std::shared_ptr<const FilterCoefficients<T>> coeffs, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : GenericFilter<T, Accumulator>(std::move(coeffs), type, resource)
+    {
+    }
+};
+
+/*! \brief Basic digital filter for vector-valued signals.
+ * 
+ * Vector-valued version of DigitalFilter.
+ * \tparam T Floating type.
+ */
+template <typename T>
+class VectorDigitalFilter final : public VectorGenericFilter<T> {
+public:
+    /*! \brief Default uninitialized constructor. */
+    VectorDigitalFilter() = default;
+    /*! \brief Uninitialized constructor.
+     * \param resource Memory resource of the data history and of the coefficients set later.
+     */
+    explicit VectorDigitalFilter(std::pmr::memory_resource* resource) noexcept
+        : VectorGenericFilter<T>(resource)
+    {
+    }
     /*! \brief Constructor.
      * \param aCoeff Denominator coefficients of the filter in decreasing order.
      * \param bCoeff Numerator coefficients of the filter in decreasing order.
      * \param type Type of the filter.
+     * \param resource Memory resource of the data history and of the coefficients.
+     */
+    template <typename AVector, typename BVector>
+    VectorDigitalFilter(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : VectorGenericFilter<T>(aCoeff, bCoeff, type, resource)
+    {
+    }
+    /*! \brief Constructor adopting the storage of the coefficients.
+     * \param aCoeff Denominator coefficients of the filter in decreasing order.
+     * \param bCoeff Numerator coefficients of the filter in decreasing order.
+     * \param type Type of the filter.
+     * \param resource Memory resource of the data history and of the coefficients.
+     */
+    template <typename Vector, typename = internal::enable_if_rvalue_t<Vector, vectX_t<T>>>
+    VectorDigitalFilter(Vector&& aCoeff, Vector&& bCoeff, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : VectorGenericFilter<T>(std::move(aCoeff), std::move(bCoeff), type, resource)
+    {
+    }
+    /*! \brief Constructor sharing existing coefficients.
+     * \param coeffs Coefficients of the filter, e.g. the coefficients() of another filter.
+     * \param type Type of the filter.
+     * \param resource Memory resource of the data history and of the coefficients.
      */
-    DigitalFilter(const vectX_t<T>& aCoeff, const vectX_t<T>& bCoeff, FilterType type = FilterType::Backward)
-        : GenericFilter<T>(aCoeff, bCoeff, type)
+    explicit VectorDigitalFilter(std::shared_ptr<const FilterCoefficients<T>> coeffs, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : VectorGenericFilter<T>(std::move(coeffs), type, resource)
     {
     }
 };
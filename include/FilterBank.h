@@ -0,0 +1,173 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+#pragma once
+
+#include "DigitalFilter.h"
+#include "denormals.h"
+#include "gsl/gsl_assert.h"
+#include "typedefs.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) && defined(_GNU_SOURCE)
+#define DIFI_HAS_THREAD_AFFINITY
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace difi {
+
+/*! \brief Options of a FilterBank. */
+struct FilterBankOptions {
+    std::size_t nrThreads = 0; /*!< Maximum number of threads, including the calling thread. 0 uses all the hardware threads */
+    std::size_t chunkBytes = 32 * 1024; /*!< Memory footprint of a chunk of filters, about the size of a L1 data cache */
+    std::size_t minFiltersPerThread = 2048; /*!< Minimum number of filters per thread, so that a small bank runs on the calling thread only */
+    bool pinThreads = false; /*!< Pin the workers to a CPU (Linux only), so that their chunks stay in the memory of their NUMA node */
+};
+
+/*! \brief Bank of independent scalar filters stepped in parallel.
+ *
+ * The filters are split into chunks of about options.chunkBytes bytes, and each thread owns a contiguous range of chunks.
+ * A thread first steps its own chunks, then steals the remaining chunks of the other threads.
+ * Each worker allocates its chunks itself, so that with the first-touch policy of the system
+ * the filter states are placed on the NUMA node of the worker that steps them most of the time.
+ *
+ * A call to step() is a barrier: it returns when all the filters have processed the tick.
+ * The output i is always the output of the filter i, whatever the thread that stepped it, so the results are deterministic.
+ * The calling thread takes part in the work. The workers wait for the next tick on a condition variable.
+ * Each thread copies its filters into a memory resource of its own, a pool over the heap owned by the bank,
+ * so the workers never allocate concurrently from the default memory resource (which may be an arena, see ScopedMemoryResource).
+ * \code
+ * std::vector<difi::DigitalFilterd> filters(200000, difi::DigitalFilterd(bf.coefficients(), bf.type()));
+ * difi::FilterBankd bank(filters);
+ * bank.step(inputs.data(), outputs.data());
+ * \endcode
+ * \tparam T Floating type.
+ * \tparam Filter Scalar filter with a noexcept stepFilterUnchecked(T) member, e.g. a DigitalFilter or a differentiator.
+ */
+template <typename T, typename Filter = DigitalFilter<T>>
+class FilterBank {
+public:
+    /*! \brief Distribute the filters between the threads.
+     * \param filters Initialized filters, copied in the chunks.
+     * \param options Threading options.
+     */
+    explicit FilterBank(const std::vector<Filter>& filters, const FilterBankOptions& options = FilterBankOptions{});
+    FilterBank(const FilterBank&) = delete;
+    FilterBank& operator=(const FilterBank&) = delete;
+    ~FilterBank() noexcept;
+
+    /*! \brief Filter one sample with each filter.
+     * \param inputs size() input samples.
+     * \param outputs size() filtered samples. It can be equal to inputs.
+     */
+    void step(const T* inputs, T* outputs);
+    /*! \brief Filter one sample with each filter.
+     * \param inputs Input samples.
+     * \param outputs Filtered samples, of the same size.
+     */
+    void step(const Eigen::Ref<const vectX_t<T>>& inputs, Eigen::Ref<vectX_t<T>> outputs);
+    /*! \brief Reset all the filters. */
+    void resetFilters() noexcept;
+    /*! \brief Save or restore all the filters through a snapshot archive, in the order of their indices.
+     *
+     * It must be called between two steps, by the thread calling step(): the workers are then parked and don't touch the chunks.
+     * A filter whose coefficients change allocates them on the calling thread.
+     * restoreSnapshot checks the layout and the sizes of all the filters before any of them is restored,
+     * but a filter rejecting the values of its fields leaves the filters before it restored.
+     * \see saveSnapshot, restoreSnapshot
+     */
+    template <typename Archive>
+    void serialize(Archive& ar);
+
+    /*! \brief Return the filter i.
+     * \warning It must not be used during a step.
+     */
+    Filter& filter(std::size_t i);
+    /*! \brief Return the filter i. */
+    const Filter& filter(std::size_t i) const;
+
+    /*! \brief Return true, the filters are initialized at construction. */
+    bool isInitialized() const noexcept { return true; }
+    /*! \brief Return the number of filters. */
+    std::size_t size() const noexcept { return m_size; }
+    /*! \brief Return the number of threads, including the calling thread. */
+    std::size_t nrThreads() const noexcept { return m_nrThreads; }
+    /*! \brief Return the number of chunks. */
+    std::size_t nrChunks() const noexcept { return m_chunks.size(); }
+    /*! \brief Return the number of filters in a chunk (the last one can be smaller). */
+    std::size_t chunkSize() const noexcept { return m_chunkSize; }
+
+private:
+    struct Chunk {
+        std::size_t first; /*!< Index of the first filter of the chunk */
+        std::vector<Filter> filters;
+    };
+
+    // One queue per thread, on its own cache line
+    struct alignas(64) Queue {
+        std::atomic<std::size_t> next{ 0 }; /*!< Next chunk to step */
+        std::size_t begin = 0; /*!< First chunk owned by the thread */
+        std::size_t end = 0; /*!< Past-the-end chunk owned by the thread */
+    };
+
+    void buildChunks(std::size_t thread, const std::vector<Filter>& filters);
+    void workerLoop(std::size_t thread, const std::vector<Filter>& filters, bool pin) noexcept;
+    void runTick(std::size_t thread) noexcept;
+    void stopWorkers() noexcept;
+
+private:
+    std::size_t m_size;
+    std::size_t m_chunkSize;
+    std::size_t m_nrThreads;
+    std::vector<std::unique_ptr<std::pmr::unsynchronized_pool_resource>> m_resources; /*!< Memory resource of the chunks of each thread, only used by one thread at a time */
+    std::vector<std::unique_ptr<Chunk>> m_chunks;
+    std::unique_ptr<Queue[]> m_queues;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_startCv;
+    std::condition_variable m_doneCv;
+    std::size_t m_tick = 0; /*!< Incremented to start a tick */
+    std::size_t m_pending = 0; /*!< Number of workers that did not finish the tick, or their chunks */
+    bool m_stop = false;
+    std::exception_ptr m_error; /*!< Error raised by a worker while building its chunks */
+    const T* m_inputs = nullptr;
+    T* m_outputs = nullptr;
+};
+
+} // namespace difi
+
+#include "FilterBank.tpp"
@@ -0,0 +1,248 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+#include <algorithm>
+
+namespace difi {
+
+template <typename T, typename Filter>
+FilterBank<T, Filter>::FilterBank(const std::vector<Filter>& filters, const FilterBankOptions& options)
+    : m_size(filters.size())
+{
+    Expects(options.chunkBytes > 0);
+    Expects(options.minFiltersPerThread > 0);
+
+    // The coefficients are shared, a filter only brings its object and its state to the cache
+    std::size_t bytes = 0;
+    for (const auto& f : filters) {
+        Expects(f.isInitialized());
+        bytes += sizeof(Filter) + static_cast<std::size_t>(f.aOrder() + f.bOrder()) * sizeof(T);
+    }
+    const std::size_t filterBytes = m_size > 0 ? (bytes + m_size - 1) / m_size : sizeof(Filter);
+    m_chunkSize = std::max<std::size_t>(1, options.chunkBytes / filterBytes);
+    const std::size_t nrChunks = (m_size + m_chunkSize - 1) / m_chunkSize;
+    m_chunks.resize(nrChunks);
+
+    const std::size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t maxThreads = options.nrThreads > 0 ? options.nrThreads : hardwareThreads;
+    m_nrThreads = std::min({ maxThreads, std::max<std::size_t>(1, m_size / options.minFiltersPerThread), std::max<std::size_t>(1, nrChunks) });
+    m_queues.reset(new Queue[m_nrThreads]);
+    m_resources.reserve(m_nrThreads);
+    for (std::size_t t = 0; t < m_nrThreads; ++t) {
+        m_queues[t].begin = t * nrChunks / m_nrThreads;
+        m_queues[t].end = (t + 1) * nrChunks / m_nrThreads;
+        m_resources.push_back(std::make_unique<std::pmr::unsynchronized_pool_resource>(std::pmr::new_delete_resource()));
+    }
+
+    m_pending = m_nrThreads - 1;
+    try {
+        m_workers.reserve(m_nrThreads - 1);
+        for (std::size_t t = 1; t < m_nrThreads; ++t)
+            m_workers.emplace_back([this, t, &filters, pin = options.pinThreads]() { workerLoop(t, filters, pin); });
+        buildChunks(0, filters);
+    } catch (...) {
+        stopWorkers();
+        throw;
+    }
+
+    // The workers copy the filters, they must be done before returning
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCv.wait(lock, [this]() { return m_pending == 0; });
+    }
+    if (m_error) {
+        stopWorkers();
+        std::rethrow_exception(m_error);
+    }
+}
+
+template <typename T, typename Filter>
+FilterBank<T, Filter>::~FilterBank() noexcept
+{
+    stopWorkers();
+}
+
+template <typename T, typename Filter>
+void FilterBank<T, Filter>::step(const T* inputs, T* outputs)
+{
+    Expects(m_size == 0 || (inputs != nullptr && outputs != nullptr));
+    ScopedDenormalGuard guard;
+    m_inputs = inputs;
+    m_outputs = outputs;
+    for (std::size_t t = 0; t < m_nrThreads; ++t)
+        m_queues[t].next.store(m_queues[t].begin, std::memory_order_relaxed);
+
+    if (m_nrThreads == 1) {
+        runTick(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending = m_nrThreads - 1;
+        ++m_tick;
+    }
+    m_startCv.notify_all();
+    runTick(0);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCv.wait(lock, [this]() { return m_pending == 0; });
+}
+
+template <typename T, typename Filter>
+void FilterBank<T, Filter>::step(const Eigen::Ref<const vectX_t<T>>& inputs, Eigen::Ref<vectX_t<T>> outputs)
+{
+    Expects(static_cast<std::size_t>(inputs.size()) == m_size);
+    Expects(static_cast<std::size_t>(outputs.size()) == m_size);
+    step(inputs.data(), outputs.data());
+}
+
+template <typename T, typename Filter>
+void FilterBank<T, Filter>::resetFilters() noexcept
+{
+    for (auto& chunk : m_chunks) {
+        for (auto& f : chunk->filters)
+            f.resetFilter();
+    }
+}
+
+template <typename T, typename Filter>
+template <typename Archive>
+void FilterBank<T, Filter>::serialize(Archive& ar)
+{
+    std::uint64_t size = m_size;
+    ar(size);
+    if constexpr (Archive::IsLoading)
+        Expects(size == m_size);
+    for (auto& chunk : m_chunks) {
+        for (auto& f : chunk->filters)
+            f.serialize(ar);
+    }
+}
+
+template <typename T, typename Filter>
+Filter& FilterBank<T, Filter>::filter(std::size_t i)
+{
+    Expects(i < m_size);
+    return m_chunks[i / m_chunkSize]->filters[i % m_chunkSize];
+}
+
+template <typename T, typename Filter>
+const Filter& FilterBank<T, Filter>::filter(std::size_t i) const
+{
+    Expects(i < m_size);
+    return m_chunks[i / m_chunkSize]->filters[i % m_chunkSize];
+}
+
+template <typename T, typename Filter>
+void FilterBank<T, Filter>::buildChunks(std::size_t thread, const std::vector<Filter>& filters)
+{
+    // The copies allocate their data history from the resource of the thread, not from the default resource shared by all the threads
+    details::ScopedThreadMemoryResource scope(m_resources[thread].get());
+    const Queue& queue = m_queues[thread];
+    for (std::size_t c = queue.begin; c < queue.end; ++c) {
+        const std::size_t first = c * m_chunkSize;
+        const std::size_t last = std::min(first + m_chunkSize, m_size);
+        m_chunks[c].reset(new Chunk{ first, std::vector<Filter>(filters.begin() + first, filters.begin() + last) });
+    }
+}
+
+template <typename T, typename Filter>
+void FilterBank<T, Filter>::workerLoop(std::size_t thread, const std::vector<Filter>& filters, bool pin) noexcept
+{
+#ifdef DIFI_HAS_THREAD_AFFINITY
+    // Pin before building the chunks, so that their memory is first touched on the right node
+    if (pin) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(static_cast<int>(thread % std::max(1u, std::thread::hardware_concurrency())), &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+#else
+    (void)pin;
+#endif
+
+    std::exception_ptr error;
+    try {
+        buildChunks(thread, filters);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (error && !m_error)
+            m_error = error;
+        if (--m_pending == 0)
+            m_doneCv.notify_one();
+    }
+
+    ScopedDenormalGuard guard;
+    std::size_t tick = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_startCv.wait(lock, [&]() { return m_stop || m_tick != tick; });
+            if (m_stop)
+                return;
+            tick = m_tick;
+        }
+        runTick(thread);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pending == 0)
+            m_doneCv.notify_one();
+    }
+}
+
+template <typename T, typename Filter>
+void FilterBank<T, Filter>::runTick(std::size_t thread) noexcept
+{
+    // Own chunks first, then steal from the next threads
+    for (std::size_t k = 0; k < m_nrThreads; ++k) {
+        Queue& queue = m_queues[(thread + k) % m_nrThreads];
+        for (std::size_t c = queue.next.fetch_add(1, std::memory_order_relaxed); c < queue.end; c = queue.next.fetch_add(1, std::memory_order_relaxed)) {
+            Chunk& chunk = *m_chunks[c];
+            const T* inputs = m_inputs + chunk.first;
+            T* outputs = m_outputs + chunk.first;
+            const std::size_t n = chunk.filters.size();
+            for (std::size_t i = 0; i < n; ++i)
+                outputs[i] = chunk.filters[i].stepFilterUnchecked(inputs[i]);
+        }
+    }
+}
+
+template <typename T, typename Filter>
+void FilterBank<T, Filter>::stopWorkers() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_startCv.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+}
+
+} // namespace difi
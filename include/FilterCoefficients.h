@@ -0,0 +1,303 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include "buffer.h"
+#include "fft.h"
+#include "gsl/gsl_assert.h"
+#include "type_checks.h"
+#include "typedefs.h"
+#include <complex>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+
+namespace difi {
+
+template <typename T, typename Derived>
+class BaseFilter;
+template <typename T>
+class CoefficientBank;
+
+/*! \brief Immutable coefficients of a digital filter.
+ *
+ * The denominator and the numerator are normalized such that \f$a_0 = 1\f$. They are stored in a single block,
+ * or in the two vectors they were moved from.
+ * Filters point to a shared FilterCoefficients and only own their data history,
+ * so that many filters of the same design use a single copy of the coefficients.
+ * Copying a filter shares its coefficients. Redesigning a filter never modifies coefficients seen by another filter.
+ *
+ * The coefficients are either owned or a view on external memory, e.g. a memory-mapped CoefficientBank.
+ *
+ * The coefficients of a long FIR filter also hold the spectrum used by the FFT convolution of the batch filter functions, see FFT_MIN_TAPS.
+ * It is computed once where the coefficients are created, e.g. on the thread publishing them to a CoefficientSlot, and shared with them.
+ * \tparam T Floating type.
+ */
+template <typename T>
+class FilterCoefficients {
+    static_assert(std::is_floating_point<T>::value && !std::is_const<T>::value, "Only accept non-complex floating point types.");
+    template <typename, typename>
+    friend class BaseFilter;
+    template <typename>
+    friend class CoefficientBank;
+
+public:
+    /*! \brief Minimal number of taps of a FIR filter for its coefficients to hold the spectrum of an FFT convolution.
+     *
+     * The transform is the power of two above 4 times the number of taps.
+     * The spectrum and the twiddle factors take 1.5 times this size in complex values, i.e. 6 KB for 64 taps in double.
+     */
+    static constexpr Eigen::Index FFT_MIN_TAPS = 64;
+
+    /*! \brief Empty coefficients. They can't be used by a filter. */
+    FilterCoefficients() = default;
+    /*! \brief Constructor.
+     * \param aCoeff Denominator coefficients of the filter in decreasing order.
+     * \param bCoeff Numerator coefficients of the filter in decreasing order.
+     * \param resource Memory resource of the coefficients.
+     */
+    template <typename AVector, typename BVector>
+    FilterCoefficients(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_storage(resource)
+        , m_fft(resource)
+    {
+        Expects(isValid(aCoeff, bCoeff));
+        assign(aCoeff, bCoeff);
+    }
+    /*! \brief Constructor adopting the storage of the coefficients.
+     *
+     * If the memory resource is the heap, i.e. std::pmr::new_delete_resource(), nothing is copied:
+     * the vectors are moved into the coefficients and normalized in place.
+     * Otherwise they are copied, so that all the coefficients stay in the memory resource.
+     * \param aCoeff Denominator coefficients of the filter in decreasing order.
+     * \param bCoeff Numerator coefficients of the filter in decreasing order.
+     * \param resource Memory resource of the coefficients.
+     */
+    template <typename Vector, typename = internal::enable_if_rvalue_t<Vector, vectX_t<T>>>
+    FilterCoefficients(Vector&& aCoeff, Vector&& bCoeff, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_storage(resource)
+        , m_fft(resource)
+    {
+        Expects(isValid(aCoeff, bCoeff));
+        if (!resource->is_equal(*std::pmr::new_delete_resource())) {
+            assign(aCoeff, bCoeff);
+            return;
+        }
+
+        const T a0 = aCoeff(0);
+        m_aAdopted = std::move(aCoeff);
+        m_bAdopted = std::move(bCoeff);
+        m_aSize = m_aAdopted.size();
+        m_size = m_aSize + m_bAdopted.size();
+        m_aData = m_aAdopted.data();
+        m_bData = m_bAdopted.data();
+        if (std::abs(a0 - T(1)) >= std::numeric_limits<T>::epsilon()) {
+            m_aAdopted /= a0;
+            m_bAdopted /= a0;
+        }
+        computeSpectrum();
+    }
+    /*! \brief Copy constructor. A view stays a view on the same memory. */
+    FilterCoefficients(const FilterCoefficients& other)
+        : m_aSize(other.m_aSize)
+        , m_size(other.m_size)
+        , m_aData(other.m_aData)
+        , m_bData(other.m_bData)
+        , m_storage(other.m_storage)
+        , m_aAdopted(other.m_aAdopted)
+        , m_bAdopted(other.m_bAdopted)
+        , m_fft(other.m_fft)
+    {
+        if (other.isAdopted()) {
+            m_aData = m_aAdopted.data();
+            m_bData = m_bAdopted.data();
+        } else if (!other.isView()) {
+            m_aData = m_storage.data();
+            m_bData = m_storage.data() + m_aSize;
+        }
+    }
+    /*! \brief Move constructor. */
+    FilterCoefficients(FilterCoefficients&& other) noexcept
+        : m_aSize(other.m_aSize)
+        , m_size(other.m_size)
+        , m_aData(other.m_aData)
+        , m_bData(other.m_bData)
+        , m_storage(std::move(other.m_storage))
+        , m_aAdopted(std::move(other.m_aAdopted))
+        , m_bAdopted(std::move(other.m_bAdopted))
+        , m_fft(std::move(other.m_fft))
+    {}
+    // Coefficients are immutable
+    FilterCoefficients& operator=(const FilterCoefficients&) = delete;
+    FilterCoefficients& operator=(FilterCoefficients&&) = delete;
+
+    /*! \brief Create shared coefficients.
+     *
+     * The coefficients and the reference counter are both allocated from the memory resource.
+     * \param aCoeff Denominator coefficients of the filter in decreasing order.
+     * \param bCoeff Numerator coefficients of the filter in decreasing order.
+     * \param resource Memory resource of the coefficients.
+     */
+    template <typename AVector, typename BVector>
+    static std::shared_ptr<const FilterCoefficients> create(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+    {
+        return std::allocate_shared<FilterCoefficients>(std::pmr::polymorphic_allocator<FilterCoefficients>(resource), aCoeff, bCoeff, resource);
+    }
+    /*! \brief Create shared coefficients adopting the storage of the vectors if the memory resource is the heap.
+     *
+     * The reference counter is allocated from the memory resource.
+     * \param aCoeff Denominator coefficients of the filter in decreasing order.
+     * \param bCoeff Numerator coefficients of the filter in decreasing order.
+     * \param resource Memory resource of the coefficients.
+     */
+    template <typename Vector, typename = internal::enable_if_rvalue_t<Vector, vectX_t<T>>>
+    static std::shared_ptr<const FilterCoefficients> create(Vector&& aCoeff, Vector&& bCoeff, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+    {
+        return std::allocate_shared<FilterCoefficients>(std::pmr::polymorphic_allocator<FilterCoefficients>(resource), std::move(aCoeff), std::move(bCoeff), resource);
+    }
+    /*! \brief Create a view on normalized coefficients stored elsewhere.
+     *
+     * Nothing is copied. The memory must outlive the view and all the filters that use it.
+     * \param data Denominator coefficients followed by numerator coefficients, with data[0] = 1.
+     * \param aSize Number of denominator coefficients.
+     * \param bSize Number of numerator coefficients.
+     */
+    static FilterCoefficients view(const T* data, Eigen::Index aSize, Eigen::Index bSize)
+    {
+        Expects(data != nullptr && aSize > 0 && bSize > 0 && data[0] == T(1));
+        return FilterCoefficients(data, aSize, aSize + bSize);
+    }
+
+    /*! \brief Check for bad coefficients.
+     * \param aCoeff Denominator coefficients of the filter.
+     * \param bCoeff Numerator coefficients of the filter.
+     * \return True if the coefficients describe a filter.
+     */
+    template <typename AVector, typename BVector>
+    static bool isValid(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff)
+    {
+        return aCoeff.size() > 0 && std::abs(aCoeff(0)) > std::numeric_limits<T>::epsilon() && bCoeff.size() > 0;
+    }
+
+    /*! \brief Return coefficients of the denominator polynome. */
+    Eigen::Map<const vectX_t<T>> aCoeff() const noexcept { return { m_aData, m_aSize }; }
+    /*! \brief Return coefficients of the numerator polynome. */
+    Eigen::Map<const vectX_t<T>> bCoeff() const noexcept { return { m_bData, m_size - m_aSize }; }
+    /*! \brief Return the order the denominator polynome order of the filter. */
+    Eigen::Index aOrder() const noexcept { return m_aSize; }
+    /*! \brief Return the order the numerator polynome order of the filter. */
+    Eigen::Index bOrder() const noexcept { return m_size - m_aSize; }
+    /*! \brief Return true if the coefficients are a view on external memory. */
+    bool isView() const noexcept { return m_aData != m_storage.data() && !isAdopted(); }
+    /*! \brief Return true if the coefficients use the storage of the vectors they were created from. */
+    bool isAdopted() const noexcept { return m_aData != nullptr && m_aData == m_aAdopted.data(); }
+    /*! \brief Return the size of the FFT convolving the FIR filter, or 0 if the coefficients hold no spectrum. */
+    Eigen::Index fftSize() const noexcept { return 2 * m_fft.size() / 3; }
+    /*! \brief Return the fftSize() / 2 twiddle factors of the transform, see details::fftTransform. */
+    const std::complex<T>* fftTwiddles() const noexcept { return m_fft.data(); }
+    /*! \brief Return the spectrum of the numerator zero-padded to fftSize(). */
+    const std::complex<T>* fftKernel() const noexcept { return m_fft.data() + fftSize() / 2; }
+    /*! \brief Return the memory resource of the coefficients (unused by a view). */
+    std::pmr::memory_resource* memoryResource() const noexcept { return m_storage.resource(); }
+
+private:
+    FilterCoefficients(const T* data, Eigen::Index aSize, Eigen::Index size) noexcept
+        : m_aSize(aSize)
+        , m_size(size)
+        , m_aData(data)
+        , m_bData(data + aSize)
+    {}
+
+    /*! \brief Write and normalize checked coefficients, reusing the storage if the size is unchanged.
+     *
+     * Only a filter that created these coefficients and is their single owner may call it.
+     */
+    template <typename AVector, typename BVector>
+    void assign(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff)
+    {
+        const Eigen::Index aSize = aCoeff.size();
+        const Eigen::Index bSize = bCoeff.size();
+        const T a0 = aCoeff(0);
+        if (m_aData == nullptr || isView() || aSize != m_aSize || aSize + bSize != m_size) {
+            m_storage.resize(aSize + bSize);
+            m_aAdopted.resize(0);
+            m_bAdopted.resize(0);
+            m_aSize = aSize;
+            m_size = aSize + bSize;
+            m_aData = m_storage.data();
+            m_bData = m_storage.data() + aSize;
+        }
+        Eigen::Map<vectX_t<T>> a(const_cast<T*>(m_aData), aSize);
+        Eigen::Map<vectX_t<T>> b(const_cast<T*>(m_bData), bSize);
+        a = aCoeff;
+        b = bCoeff;
+        if (std::abs(a0 - T(1)) >= std::numeric_limits<T>::epsilon()) {
+            a /= a0;
+            b /= a0;
+        }
+        computeSpectrum();
+    }
+
+    /*! \brief Compute the twiddle factors and the kernel spectrum of a long FIR filter, or release them.
+     *
+     * It does not allocate if the number of taps is unchanged.
+     */
+    void computeSpectrum()
+    {
+        const Eigen::Index taps = bOrder();
+        if (m_aSize != 1 || taps < FFT_MIN_TAPS) {
+            m_fft.resize(0);
+            return;
+        }
+
+        // [twiddles (n / 2) | kernel spectrum (n)]
+        const auto n = static_cast<Eigen::Index>(details::nextPowerOfTwo(static_cast<size_t>(4 * taps)));
+        if (m_fft.size() != 3 * n / 2) {
+            m_fft.resize(3 * n / 2);
+            details::fftTwiddles(m_fft.data(), static_cast<size_t>(n));
+        }
+        std::complex<T>* kernel = m_fft.data() + n / 2;
+        std::fill_n(kernel, n, std::complex<T>(0));
+        for (Eigen::Index i = 0; i < taps; ++i)
+            kernel[i] = m_bData[i];
+        details::fftTransform(kernel, m_fft.data(), static_cast<size_t>(n), false);
+    }
+
+private:
+    Eigen::Index m_aSize = 0; /*!< Number of denominator coefficients */
+    Eigen::Index m_size = 0; /*!< Number of coefficients */
+    const T* m_aData = nullptr; /*!< Denominator coefficients */
+    const T* m_bData = nullptr; /*!< Numerator coefficients */
+    details::Buffer<T> m_storage; /*!< Storage of the denominator followed by the numerator if they are not a view or adopted */
+    vectX_t<T> m_aAdopted; /*!< Denominator coefficients moved into the coefficients */
+    vectX_t<T> m_bAdopted; /*!< Numerator coefficients moved into the coefficients */
+    details::Buffer<std::complex<T>> m_fft; /*!< Twiddle factors and kernel spectrum of a long FIR filter */
+};
+
+} // namespace difi
@@ -0,0 +1,233 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include "BaseFilter.h"
+#include "buffer.h"
+#include "gsl/gsl_assert.h"
+#include "typedefs.h"
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace difi {
+
+using Q15 = std::int16_t; /*!< Signed fixed-point number with 15 fractional bits */
+using Q31 = std::int32_t; /*!< Signed fixed-point number with 31 fractional bits */
+
+/*! \brief Rounding mode of the fixed-point filters when the accumulator is scaled back to the data format. */
+enum class Rounding {
+    Truncate, /*!< Round toward minus infinity (simple shift) */
+    Nearest, /*!< Round to nearest, ties toward plus infinity */
+    Convergent /*!< Round to nearest, ties to even (unbiased) */
+};
+
+/*! \brief Properties of a fixed-point format.
+ * \tparam I Signed integer type of the data (Q15 or Q31).
+ */
+template <typename I>
+struct FixedPointTraits {
+    static_assert(std::is_same<I, Q15>::value || std::is_same<I, Q31>::value, "Only Q15 and Q31 fixed-point formats are supported.");
+    using accumulator_type = std::int64_t; /*!< Wide accumulator of the kernels */
+    static constexpr int fractionalBits = std::numeric_limits<I>::digits; /*!< Number of fractional bits */
+};
+
+/*! \brief Convert a floating point value in [-1, 1) into a fixed-point value.
+ *
+ * Values outside of the range are saturated.
+ * \tparam I Fixed-point type.
+ * \param value Value to convert.
+ */
+template <typename I, typename T>
+I toFixedPoint(T value) noexcept;
+/*! \brief Convert a fixed-point value into a floating point value in [-1, 1).
+ * \tparam T Floating type.
+ * \param value Value to convert.
+ */
+template <typename T, typename I>
+T fromFixedPoint(I value) noexcept;
+
+/*! \brief Fixed-point FIR filter.
+ *
+ * Coefficients are quantized from a floating point design with a scaling chosen automatically:
+ * the coefficients use as many fractional bits as possible without overflowing the coefficient type nor the accumulator.
+ * The products are accumulated in a 64-bit integer and the output is rounded and saturated to the data format.
+ * \tparam I Fixed-point type of the data and of the coefficients (Q15 or Q31).
+ * \tparam R Rounding mode of the output.
+ */
+template <typename I, Rounding R = Rounding::Nearest>
+class FixedPointFIRFilter {
+    using traits = FixedPointTraits<I>;
+    using acc_t = typename traits::accumulator_type;
+
+public:
+    /*! \brief Default uninitialized constructor. */
+    FixedPointFIRFilter() = default;
+    /*! \brief Constructor.
+     * \param bCoeff Floating point coefficients of the filter in decreasing order.
+     */
+    template <typename T>
+    explicit FixedPointFIRFilter(const vectX_t<T>& bCoeff) { setCoeffs(bCoeff); }
+    /*! \brief Quantize a floating point FIR design (e.g. a MovingAverage).
+     * \param filter Initialized filter with no denominator.
+     */
+    template <typename T, typename Derived>
+    explicit FixedPointFIRFilter(const BaseFilter<T, Derived>& filter);
+
+    /*! \brief Set and quantize the coefficients of the filter.
+     * \param bCoeff Floating point coefficients of the filter in decreasing order.
+     */
+    template <typename T>
+    void setCoeffs(const vectX_t<T>& bCoeff);
+    /*! \brief Filter a new data.
+     * \param data New data to filter.
+     * \return Filtered data.
+     */
+    I stepFilter(I data);
+    /*! \brief Filter a new data without checking the filter state.
+     * \warning The filter must be initialized.
+     * \param data New data to filter.
+     * \return Filtered data.
+     */
+    I stepFilterUnchecked(I data) noexcept;
+    /*! \brief Filter a signal.
+     * \param data Signal.
+     * \return Filtered signal.
+     */
+    vectX_t<I> filter(const vectX_t<I>& data);
+    /*! \brief Reset the data. */
+    void resetFilter() noexcept { m_rawData.setZero(m_bCoeff.size()); }
+
+    /*! \brief Return the initialization state of the filter. */
+    bool isInitialized() const noexcept { return m_bCoeff.size() > 0; }
+    /*! \brief Return the quantized coefficients. */
+    Eigen::Map<const vectX_t<I>> bCoeff() const noexcept { return m_bCoeff.vector(); }
+    /*! \brief Return the memory resource of the coefficients and of the data history. */
+    std::pmr::memory_resource* memoryResource() const noexcept { return m_bCoeff.resource(); }
+    /*! \brief Save or restore the filter through a snapshot archive.
+     * \see saveSnapshot, restoreSnapshot
+     */
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        ar(m_shift);
+        ar(m_bCoeff);
+        ar(m_rawData);
+        if constexpr (Archive::IsLoading)
+            Expects(m_rawData.size() == m_bCoeff.size());
+    }
+    /*! \brief Return the number of fractional bits of the quantized coefficients. */
+    int coeffShift() const noexcept { return m_shift; }
+
+private:
+    int m_shift = 0; /*!< Number of fractional bits of the coefficients */
+    details::Buffer<I> m_bCoeff; /*!< Quantized coefficients */
+    details::Buffer<I> m_rawData; /*!< Last set of non-filtered data */
+};
+
+/*! \brief Fixed-point cascade of second-order sections (biquads).
+ *
+ * Each section is computed in Direct Form I so that only the input and output of the section are stored,
+ * in the data format, and the sum is done in a single 64-bit accumulator.
+ * Each section has its own coefficient scaling.
+ * The gain of the cascade is spread over all sections to keep the numerator coefficients in range.
+ * \warning The intermediate signals are saturated. Resonant sections may need some headroom on the input.
+ * \tparam I Fixed-point type of the data and of the coefficients (Q15 or Q31).
+ * \tparam R Rounding mode of the output of each section.
+ */
+template <typename I, Rounding R = Rounding::Nearest>
+class FixedPointBiquadFilter {
+    using traits = FixedPointTraits<I>;
+    using acc_t = typename traits::accumulator_type;
+
+public:
+    /*! \brief Default uninitialized constructor. */
+    FixedPointBiquadFilter() = default;
+    /*! \brief Constructor.
+     * \param sos Second-order sections as rows \f$[b_0, b_1, b_2, a_0, a_1, a_2]\f$.
+     * \see Butterworth::secondOrderSections, zpkToSOS
+     */
+    template <typename T>
+    explicit FixedPointBiquadFilter(const matX_t<T>& sos) { setSections(sos); }
+
+    /*! \brief Set and quantize the sections of the filter.
+     * \param sos Second-order sections as rows \f$[b_0, b_1, b_2, a_0, a_1, a_2]\f$.
+     */
+    template <typename T>
+    void setSections(const matX_t<T>& sos);
+    /*! \brief Filter a new data.
+     * \param data New data to filter.
+     * \return Filtered data.
+     */
+    I stepFilter(I data);
+    /*! \brief Filter a new data without checking the filter state.
+     * \warning The filter must be initialized.
+     * \param data New data to filter.
+     * \return Filtered data.
+     */
+    I stepFilterUnchecked(I data) noexcept;
+    /*! \brief Filter a signal.
+     * \param data Signal.
+     * \return Filtered signal.
+     */
+    vectX_t<I> filter(const vectX_t<I>& data);
+    /*! \brief Reset the data of all sections. */
+    void resetFilter() noexcept { m_states.setZero(4 * nrSections()); }
+
+    /*! \brief Return the initialization state of the filter. */
+    bool isInitialized() const noexcept { return m_shifts.size() > 0; }
+    /*! \brief Return the number of sections. */
+    Eigen::Index nrSections() const noexcept { return m_shifts.size(); }
+    /*! \brief Return the quantized coefficients as rows \f$[b_0, b_1, b_2, a_1, a_2]\f$. */
+    Eigen::Map<const Eigen::Matrix<I, Eigen::Dynamic, 5, Eigen::RowMajor>> coeffs() const noexcept { return { m_coeffs.data(), nrSections(), 5 }; }
+    /*! \brief Return the number of fractional bits of the quantized coefficients of each section. */
+    Eigen::Map<const Eigen::VectorXi> coeffShifts() const noexcept { return m_shifts.vector(); }
+    /*! \brief Return the memory resource of the coefficients and of the data history. */
+    std::pmr::memory_resource* memoryResource() const noexcept { return m_coeffs.resource(); }
+    /*! \brief Save or restore the filter through a snapshot archive.
+     * \see saveSnapshot, restoreSnapshot
+     */
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        ar(m_coeffs);
+        ar(m_shifts);
+        ar(m_states);
+        if constexpr (Archive::IsLoading)
+            Expects(m_coeffs.size() == 5 * nrSections() && m_states.size() == 4 * nrSections());
+    }
+
+private:
+    details::Buffer<I> m_coeffs; /*!< Quantized coefficients [b0, b1, b2, a1, a2] of each section, section after section */
+    details::Buffer<int> m_shifts; /*!< Number of fractional bits of the coefficients of each section */
+    details::Buffer<I> m_states; /*!< [x(n-1), x(n-2), y(n-1), y(n-2)] of each section, section after section */
+};
+
+} // namespace difi
+
+#include "FixedPointFilter.tpp"
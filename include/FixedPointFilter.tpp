@@ -0,0 +1,244 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#include <cmath>
+
+namespace difi {
+
+namespace details {
+
+// Saturate a wide value to the fixed-point range.
+template <typename I, typename Acc>
+inline I saturate(Acc value) noexcept
+{
+    if (value > static_cast<Acc>(std::numeric_limits<I>::max()))
+        return std::numeric_limits<I>::max();
+    if (value < static_cast<Acc>(std::numeric_limits<I>::min()))
+        return std::numeric_limits<I>::min();
+    return static_cast<I>(value);
+}
+
+// Divide by 2^shift with the given rounding mode.
+template <Rounding R, typename Acc>
+inline Acc roundingShift(Acc value, int shift) noexcept
+{
+    if (shift == 0)
+        return value;
+
+    const Acc half = Acc(1) << (shift - 1);
+    switch (R) {
+    case Rounding::Nearest:
+        return (value + half) >> shift;
+    case Rounding::Convergent: {
+        Acc q = value >> shift;
+        const Acc rem = value - q * (Acc(1) << shift);
+        if (rem > half || (rem == half && (q & 1)))
+            ++q;
+        return q;
+    }
+    case Rounding::Truncate:
+    default:
+        return value >> shift;
+    }
+}
+
+// Largest number of fractional bits such that the quantized coefficients fit in I
+// and such that the sum of their products with full-scale data fits in the accumulator.
+template <typename I, typename T>
+int coefficientShift(const Eigen::Ref<const vectX_t<T>>& coeffs)
+{
+    using traits = FixedPointTraits<I>;
+    const long double maxAbs = static_cast<long double>(coeffs.cwiseAbs().maxCoeff());
+    const long double sumAbs = static_cast<long double>(coeffs.cwiseAbs().sum());
+    Expects(maxAbs > 0.L);
+
+    const int coeffBits = static_cast<int>(std::floor(std::log2(static_cast<long double>(std::numeric_limits<I>::max()) / maxAbs)));
+    // One bit is kept for the rounding offset
+    const int accBits = static_cast<int>(std::floor(std::numeric_limits<typename traits::accumulator_type>::digits - 1 - traits::fractionalBits - std::log2(sumAbs)));
+    const int shift = std::min({ coeffBits, accBits, std::numeric_limits<typename traits::accumulator_type>::digits - 1 });
+    Expects(shift >= 0); // Coefficients are too large for the fixed-point format
+    return shift;
+}
+
+// Quantize coefficients with the given number of fractional bits.
+template <typename I, typename T>
+vectX_t<I> quantize(const Eigen::Ref<const vectX_t<T>>& coeffs, int shift)
+{
+    vectX_t<I> res(coeffs.size());
+    const long double scale = std::ldexp(1.L, shift);
+    for (Eigen::Index i = 0; i < coeffs.size(); ++i)
+        res(i) = saturate<I>(std::llround(static_cast<long double>(coeffs(i)) * scale));
+    return res;
+}
+
+} // namespace details
+
+template <typename I, typename T>
+I toFixedPoint(T value) noexcept
+{
+    static_assert(std::is_floating_point<T>::value, "Only accept floating point types.");
+    return details::saturate<I>(std::llround(std::ldexp(static_cast<long double>(value), FixedPointTraits<I>::fractionalBits)));
+}
+
+template <typename T, typename I>
+T fromFixedPoint(I value) noexcept
+{
+    static_assert(std::is_floating_point<T>::value, "Only accept floating point types.");
+    return std::ldexp(static_cast<T>(value), -FixedPointTraits<I>::fractionalBits);
+}
+
+/*
+ * FixedPointFIRFilter
+ */
+
+template <typename I, Rounding R>
+template <typename T, typename Derived>
+FixedPointFIRFilter<I, R>::FixedPointFIRFilter(const BaseFilter<T, Derived>& filter)
+{
+    Expects(filter.isInitialized());
+    Expects(filter.aOrder() == 1); // Only FIR filters
+    setCoeffs(vectX_t<T>(filter.bCoeff()));
+}
+
+template <typename I, Rounding R>
+template <typename T>
+void FixedPointFIRFilter<I, R>::setCoeffs(const vectX_t<T>& bCoeff)
+{
+    Expects(bCoeff.size() > 0);
+    m_shift = details::coefficientShift<I, T>(bCoeff);
+    m_bCoeff.resize(bCoeff.size());
+    m_bCoeff.vector() = details::quantize<I, T>(bCoeff, m_shift);
+    resetFilter();
+}
+
+template <typename I, Rounding R>
+I FixedPointFIRFilter<I, R>::stepFilter(I data)
+{
+    Expects(isInitialized());
+    return stepFilterUnchecked(data);
+}
+
+template <typename I, Rounding R>
+I FixedPointFIRFilter<I, R>::stepFilterUnchecked(I data) noexcept
+{
+    I* rawData = m_rawData.data();
+    const I* bCoeff = m_bCoeff.data();
+
+    // Slide data (can't use SIMD, but should be small)
+    for (Eigen::Index i = m_rawData.size() - 1; i > 0; --i)
+        rawData[i] = rawData[i - 1];
+    rawData[0] = data;
+
+    acc_t acc = 0;
+    for (Eigen::Index i = 0; i < m_bCoeff.size(); ++i)
+        acc += static_cast<acc_t>(bCoeff[i]) * static_cast<acc_t>(rawData[i]);
+    return details::saturate<I>(details::roundingShift<R>(acc, m_shift));
+}
+
+template <typename I, Rounding R>
+vectX_t<I> FixedPointFIRFilter<I, R>::filter(const vectX_t<I>& data)
+{
+    Expects(isInitialized());
+    vectX_t<I> results(data.size());
+    for (Eigen::Index i = 0; i < data.size(); ++i)
+        results(i) = stepFilterUnchecked(data(i));
+    return results;
+}
+
+/*
+ * FixedPointBiquadFilter
+ */
+
+template <typename I, Rounding R>
+template <typename T>
+void FixedPointBiquadFilter<I, R>::setSections(const matX_t<T>& sos)
+{
+    Expects(sos.rows() > 0 && sos.cols() == 6);
+    Expects((sos.col(3).array() != T(0)).all());
+
+    // Normalize and balance the numerator magnitudes so that the gain is not carried by a single section
+    matX_t<T> coeffs(sos.rows(), 5);
+    long double logGain = 0;
+    for (Eigen::Index i = 0; i < sos.rows(); ++i) {
+        coeffs.row(i) << sos(i, 0), sos(i, 1), sos(i, 2), sos(i, 4), sos(i, 5);
+        coeffs.row(i) /= sos(i, 3);
+        const T bMax = coeffs.row(i).head(3).cwiseAbs().maxCoeff();
+        Expects(bMax > T(0));
+        coeffs.row(i).head(3) /= bMax;
+        logGain += std::log(static_cast<long double>(bMax));
+    }
+    coeffs.leftCols(3) *= static_cast<T>(std::exp(logGain / static_cast<long double>(sos.rows())));
+
+    m_coeffs.resize(5 * sos.rows());
+    m_shifts.resize(sos.rows());
+    int* shifts = m_shifts.data();
+    for (Eigen::Index i = 0; i < sos.rows(); ++i) {
+        const vectX_t<T> section = coeffs.row(i).transpose();
+        shifts[i] = details::coefficientShift<I, T>(section);
+        m_coeffs.segment(5 * i, 5) = details::quantize<I, T>(section, shifts[i]);
+    }
+    resetFilter();
+}
+
+template <typename I, Rounding R>
+I FixedPointBiquadFilter<I, R>::stepFilter(I data)
+{
+    Expects(isInitialized());
+    return stepFilterUnchecked(data);
+}
+
+template <typename I, Rounding R>
+I FixedPointBiquadFilter<I, R>::stepFilterUnchecked(I data) noexcept
+{
+    I x = data;
+    const int* shifts = m_shifts.data();
+    for (Eigen::Index i = 0; i < nrSections(); ++i) {
+        const I* c = m_coeffs.data() + 5 * i;
+        I* s = m_states.data() + 4 * i;
+        const acc_t acc = static_cast<acc_t>(c[0]) * x + static_cast<acc_t>(c[1]) * s[0] + static_cast<acc_t>(c[2]) * s[1]
+            - static_cast<acc_t>(c[3]) * s[2] - static_cast<acc_t>(c[4]) * s[3];
+        const I y = details::saturate<I>(details::roundingShift<R>(acc, shifts[i]));
+        s[1] = s[0];
+        s[0] = x;
+        s[3] = s[2];
+        s[2] = y;
+        x = y;
+    }
+    return x;
+}
+
+template <typename I, Rounding R>
+vectX_t<I> FixedPointBiquadFilter<I, R>::filter(const vectX_t<I>& data)
+{
+    Expects(isInitialized());
+    vectX_t<I> results(data.size());
+    for (Eigen::Index i = 0; i < data.size(); ++i)
+        results(i) = stepFilterUnchecked(data(i));
+    return results;
+}
+
+} // namespace difi
@@ -28,19 +28,40 @@
 #pragma once
 
 #include "BaseFilter.h"
+#include "accumulators.h"
+#include "fft.h"
+#include <algorithm>
+#include <complex>
+#include <type_traits>
+#include <vector>
 
 namespace difi {
 
-template <typename T>
-class GenericFilter : public BaseFilter<T, GenericFilter<T>> {
-    using Base = BaseFilter<T, GenericFilter<T>>;
+/*! \brief Filter of a scalar signal.
+ *
+ * \tparam T Floating type of the coefficients and of the signal.
+ * \tparam Accumulator Floating type used to compute the output, or CompensatedSum.
+ * A wider type (e.g. float signal with double accumulation) reduces the rounding errors of long or recursive filters
+ * while keeping the memory footprint of T.
+ */
+template <typename T, typename Accumulator = T>
+class GenericFilter : public BaseFilter<T, GenericFilter<T, Accumulator>> {
+    using Base = BaseFilter<T, GenericFilter<T, Accumulator>>;
+    friend Base;
     using Base::m_isInitialized;
-    using Base::m_aCoeff;
-    using Base::m_bCoeff;
-    using Base::m_rawData;
-    using Base::m_filteredData;
+    using Base::m_flushDenormals;
 
 public:
+    /*! \brief Minimal number of taps of a FIR filter for the block filter functions to use an FFT convolution.
+     *
+     * Above it, the signal is filtered by overlap-save in \f$O(\log(taps))\f$ per sample instead of \f$O(taps)\f$.
+     * The FFT is only used when the accumulator is T, when the coefficients hold their spectrum (see FilterCoefficients::fftSize),
+     * and for signals at least as long as a transform, i.e. the power of two above 4 times the number of taps.
+     * The spectrum is shared with the coefficients. The filter only owns a workspace of the transform size,
+     * allocated by the first block filtered through the FFT and never copied with the filter.
+     */
+    static constexpr Eigen::Index FFT_MIN_TAPS = FilterCoefficients<T>::FFT_MIN_TAPS;
+
     /*! \brief Filter a new data.
      * 
      * This function is practical for online application that does not know the whole signal in advance.
@@ -48,31 +69,84 @@ public:
      * \return Filtered data.
      */
     T stepFilter(const T& data);
+    /*! \brief Filter a new data without checking the filter state.
+     *
+     * Same as stepFilter but without contract checks, so that the per-sample work is pure arithmetic.
+     * \warning The filter must be initialized.
+     * \param data New data to filter.
+     * \return Filtered data.
+     */
+    T stepFilterUnchecked(const T& data) noexcept;
     /*! \brief Filter a signal.
      * 
      * Filter all data given by the signal.
+     * Long FIR filters use an FFT convolution, see FFT_MIN_TAPS.
      * \param data Signal.
      * \return Filtered signal.
      */
     vectX_t<T> filter(const vectX_t<T>& data);
+    /*! \brief Filter a strided signal without copy.
+     *
+     * The samples are read and written through their strides, e.g. one channel of an interleaved buffer.
+     * Long FIR filters use an FFT convolution, see FFT_MIN_TAPS.
+     * \param data Signal, e.g. an Eigen::Map with an Eigen::InnerStride.
+     * \param results Filtered signal of the same size. It can be the same memory as data to filter in place.
+     */
+    void filter(const Eigen::Ref<const vectX_t<T>, 0, Eigen::InnerStride<>>& data, Eigen::Ref<vectX_t<T>, 0, Eigen::InnerStride<>> results);
+    /*! \brief Filter a strided signal given by raw pointers.
+     * \param data Pointer to the first sample.
+     * \param results Pointer to the first filtered sample. It can be equal to data to filter in place.
+     * \param size Number of samples.
+     * \param dataStride Number of elements between two samples of data.
+     * \param resultsStride Number of elements between two samples of results.
+     */
+    void filter(const T* data, T* results, Eigen::Index size, Eigen::Index dataStride = 1, Eigen::Index resultsStride = 1);
 
     void resetFilter() noexcept;
 
 protected:
     GenericFilter() = default;
-    GenericFilter(const vectX_t<T>& aCoeff, const vectX_t<T>& bCoeff, FilterType type = FilterType::Backward)
-        : Base(aCoeff, bCoeff, type)
+    explicit GenericFilter(std::pmr::memory_resource* resource) noexcept
+        : Base(resource)
+        , m_fftWork(resource)
     {}
+    template <typename AVector, typename BVector>
+    GenericFilter(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : GenericFilter(resource)
+    {
+        this->setCoeffs(aCoeff, bCoeff);
+        this->setType(type);
+    }
+    template <typename Vector, typename = internal::enable_if_rvalue_t<Vector, vectX_t<T>>>
+    GenericFilter(Vector&& aCoeff, Vector&& bCoeff, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : GenericFilter(resource)
+    {
+        this->setCoeffs(std::move(aCoeff), std::move(bCoeff));
+        this->setType(type);
+    }
+    GenericFilter(std::shared_ptr<const FilterCoefficients<T>> coeffs, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : GenericFilter(resource)
+    {
+        this->setCoeffs(std::move(coeffs));
+        this->setType(type);
+    }
+    /*! \brief Only the final filters can be destroyed, as the destructor is not virtual. */
+    ~GenericFilter() = default;
+
+private:
+    bool useFFT(Eigen::Index size) const noexcept;
+    void fftFilter(const Eigen::Ref<const vectX_t<T>, 0, Eigen::InnerStride<>>& data, Eigen::Ref<vectX_t<T>, 0, Eigen::InnerStride<>> results);
+
+private:
+    /*! \brief Workspace of the FFT convolution: the transformed blocks, then the input history. */
+    details::Workspace<std::complex<T>> m_fftWork;
 };
 
 template <typename T>
 class TVGenericFilter : public BaseFilter<T, TVGenericFilter<T>> {
     using Base = BaseFilter<T, TVGenericFilter<T>>;
     using Base::m_isInitialized;
-    using Base::m_aCoeff;
-    using Base::m_bCoeff;
-    using Base::m_rawData;
-    using Base::m_filteredData;
+    using Base::m_flushDenormals;
 
 public:
     /*! \brief Filter a new data.
@@ -82,6 +156,15 @@ public:
      * \return Filtered data.
      */
     T stepFilter(const T& time, const T& data);
+    /*! \brief Filter a new data without checking the filter state.
+     *
+     * Same as stepFilter but without contract checks, so that the per-sample work is pure arithmetic.
+     * \warning The filter must be initialized.
+     * \param time Time of the new data.
+     * \param data New data to filter.
+     * \return Filtered data.
+     */
+    T stepFilterUnchecked(const T& time, const T& data) noexcept;
     /*! \brief Filter a signal.
      * 
      * Filter all data given by the signal.
@@ -92,9 +175,16 @@ public:
 
     void resetFilter() noexcept;
 
+    /*! \brief Save or restore the filter through a snapshot archive.
+     * \see saveSnapshot, restoreSnapshot
+     */
+    template <typename Archive>
+    void serialize(Archive& ar);
+
 protected:
     TVGenericFilter() = default;
-    TVGenericFilter(size_t differentialOrder, const vectX_t<T>& aCoeff, const vectX_t<T>& bCoeff, FilterType type = FilterType::Backward)
+    template <typename AVector, typename BVector>
+    TVGenericFilter(size_t differentialOrder, const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff, FilterType type = FilterType::Backward)
         : Base()
         , m_diffOrder(differentialOrder)
     {
@@ -102,10 +192,13 @@ protected:
         this->setCoeffs(aCoeff, bCoeff);
         this->setType(type);
     }
+    /*! \brief Only the final filters can be destroyed, as the destructor is not virtual. */
+    ~TVGenericFilter() = default;
 
 private:
     size_t m_diffOrder = 1;
-    vectX_t<T> m_timers;
+    details::Buffer<T> m_timers;
+    details::Buffer<T> m_tvBCoeff;
 };
 
 } // namespace difi
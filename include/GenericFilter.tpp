@@ -27,66 +27,193 @@
 
 namespace difi {
 
-template <typename T>
-T GenericFilter<T>::stepFilter(const T& data)
+template <typename T, typename Accumulator>
+T GenericFilter<T, Accumulator>::stepFilter(const T& data)
 {
     Expects(m_isInitialized);
+    return stepFilterUnchecked(data);
+}
+
+template <typename T, typename Accumulator>
+T GenericFilter<T, Accumulator>::stepFilterUnchecked(const T& data) noexcept
+{
+    auto rawData = this->rawData();
+    auto filteredData = this->filteredData();
 
     // Slide data (can't use SIMD, but should be small)
-    for (Eigen::Index i = m_rawData.size() - 1; i > 0; --i)
-        m_rawData(i) = m_rawData(i - 1);
-    for (Eigen::Index i = m_filteredData.size() - 1; i > 0; --i)
-        m_filteredData(i) = m_filteredData(i - 1);
-
-    m_rawData(0) = data;
-    m_filteredData(0) = 0;
-    m_filteredData(0) = m_bCoeff.dot(m_rawData) - m_aCoeff.dot(m_filteredData);
-    return m_filteredData(0);
+    for (Eigen::Index i = rawData.size() - 1; i > 0; --i)
+        rawData(i) = rawData(i - 1);
+    for (Eigen::Index i = filteredData.size() - 1; i > 0; --i)
+        filteredData(i) = filteredData(i - 1);
+
+    rawData(0) = data;
+    filteredData(0) = 0;
+    filteredData(0) = internal::FilterKernel<T, Accumulator>::run(this->bCoeff(), rawData, this->aCoeff(), filteredData);
+    if (m_flushDenormals)
+        filteredData(0) = details::flushDenormal(filteredData(0));
+    return filteredData(0);
 }
 
-template <typename T>
-vectX_t<T> GenericFilter<T>::filter(const vectX_t<T>& data)
+template <typename T, typename Accumulator>
+vectX_t<T> GenericFilter<T, Accumulator>::filter(const vectX_t<T>& data)
 {
     Expects(m_isInitialized);
+    ScopedDenormalGuard guard;
     vectX_t<T> results(data.size());
+    if (useFFT(data.size())) {
+        fftFilter(data, results);
+        return results;
+    }
+
     for (Eigen::Index i = 0; i < data.size(); ++i)
-        results(i) = stepFilter(data(i));
+        results(i) = stepFilterUnchecked(data(i));
     return results;
 }
 
-template <typename T>
-void GenericFilter<T>::resetFilter() noexcept
+template <typename T, typename Accumulator>
+void GenericFilter<T, Accumulator>::filter(const Eigen::Ref<const vectX_t<T>, 0, Eigen::InnerStride<>>& data, Eigen::Ref<vectX_t<T>, 0, Eigen::InnerStride<>> results)
+{
+    Expects(m_isInitialized);
+    Expects(data.size() == results.size());
+    ScopedDenormalGuard guard;
+    if (useFFT(data.size())) {
+        fftFilter(data, results);
+        return;
+    }
+
+    // Each sample is read before its result is written, so data and results can alias
+    for (Eigen::Index i = 0; i < data.size(); ++i)
+        results(i) = stepFilterUnchecked(data(i));
+}
+
+template <typename T, typename Accumulator>
+void GenericFilter<T, Accumulator>::filter(const T* data, T* results, Eigen::Index size, Eigen::Index dataStride, Eigen::Index resultsStride)
+{
+    Expects(size >= 0);
+    Expects(size == 0 || (data != nullptr && results != nullptr));
+    Expects(dataStride > 0 && resultsStride > 0);
+    using StridedMap = Eigen::Map<vectX_t<T>, 0, Eigen::InnerStride<>>;
+    using ConstStridedMap = Eigen::Map<const vectX_t<T>, 0, Eigen::InnerStride<>>;
+    filter(ConstStridedMap(data, size, Eigen::InnerStride<>(dataStride)), StridedMap(results, size, Eigen::InnerStride<>(resultsStride)));
+}
+
+template <typename T, typename Accumulator>
+void GenericFilter<T, Accumulator>::resetFilter() noexcept
 {
-    m_filteredData.setZero(m_aCoeff.size());
-    m_rawData.setZero(m_bCoeff.size());
+    this->resetState();
+}
+
+template <typename T, typename Accumulator>
+bool GenericFilter<T, Accumulator>::useFFT(Eigen::Index size) const noexcept
+{
+    // Shorter signals would mostly transform zeros
+    const Eigen::Index n = this->coefficients()->fftSize();
+    return std::is_same<Accumulator, T>::value && n > 0 && size >= n;
+}
+
+template <typename T, typename Accumulator>
+void GenericFilter<T, Accumulator>::fftFilter(const Eigen::Ref<const vectX_t<T>, 0, Eigen::InnerStride<>>& data, Eigen::Ref<vectX_t<T>, 0, Eigen::InnerStride<>> results)
+{
+    // Overlap-save: each block of the FFT holds the last taps - 1 inputs followed by step new inputs,
+    // and its first taps - 1 outputs, corrupted by the circular wrap, are discarded.
+    // As the kernel is real, two consecutive blocks are transformed at once as the real and imaginary parts.
+    const FilterCoefficients<T>& coeffs = *this->coefficients();
+    const Eigen::Index taps = this->bOrder();
+    const Eigen::Index size = data.size();
+    const Eigen::Index n = coeffs.fftSize();
+    const Eigen::Index step = n - taps + 1;
+    const std::complex<T>* twiddles = coeffs.fftTwiddles();
+    const std::complex<T>* kernel = coeffs.fftKernel();
+    // [workspace (n) | history and last inputs (2 * taps - 1 values of T)]
+    std::complex<T>* work = m_fftWork.reserve(n + taps);
+    T* history = reinterpret_cast<T*>(work + n);
+    T* lastInputs = history + taps - 1;
+
+    // History of the first block, oldest first
+    auto rawData = this->rawData();
+    for (Eigen::Index i = 0; i < taps - 1; ++i)
+        history[i] = rawData(taps - 2 - i);
+    // Inputs are saved before results, that can alias them, are written
+    for (Eigen::Index i = 0; i < taps; ++i)
+        lastInputs[i] = data(size - 1 - i);
+
+    for (Eigen::Index start = 0; start < size; start += 2 * step) {
+        const Eigen::Index size1 = std::min(step, size - start);
+        const Eigen::Index start2 = start + step;
+        const Eigen::Index size2 = std::max(Eigen::Index(0), std::min(step, size - start2));
+
+        std::fill_n(work, n, std::complex<T>(0));
+        for (Eigen::Index i = 0; i < taps - 1; ++i)
+            work[i].real(history[i]);
+        for (Eigen::Index i = 0; i < size1; ++i)
+            work[taps - 1 + i].real(data(start + i));
+        if (size2 > 0) {
+            for (Eigen::Index i = 0; i < taps - 1 + size2; ++i)
+                work[i].imag(data(start2 - taps + 1 + i));
+        }
+        const Eigen::Index next = start + 2 * step;
+        if (next < size) {
+            for (Eigen::Index i = 0; i < taps - 1; ++i)
+                history[i] = data(next - taps + 1 + i);
+        }
+
+        details::fftTransform(work, twiddles, static_cast<size_t>(n), false);
+        for (Eigen::Index i = 0; i < n; ++i)
+            work[i] = details::multiply(work[i], kernel[i]);
+        details::fftTransform(work, twiddles, static_cast<size_t>(n), true);
+
+        for (Eigen::Index i = 0; i < size1; ++i)
+            results(start + i) = work[taps - 1 + i].real();
+        for (Eigen::Index i = 0; i < size2; ++i)
+            results(start2 + i) = work[taps - 1 + i].imag();
+    }
+
+    if (m_flushDenormals) {
+        for (Eigen::Index i = 0; i < size; ++i)
+            results(i) = details::flushDenormal(results(i));
+    }
+    rawData = Eigen::Map<const vectX_t<T>>(lastInputs, taps);
+    this->filteredData()(0) = results(size - 1);
 }
 
 template <typename T>
 T TVGenericFilter<T>::stepFilter(const T& time, const T& data)
 {
     Expects(m_isInitialized);
+    return stepFilterUnchecked(time, data);
+}
+
+template <typename T>
+T TVGenericFilter<T>::stepFilterUnchecked(const T& time, const T& data) noexcept
+{
+    auto rawData = this->rawData();
+    auto filteredData = this->filteredData();
+    auto timers = m_timers.vector();
+    auto tvBCoeff = m_tvBCoeff.vector();
 
     // Slide data (can't use SIMD, but should be small)
-    for (Eigen::Index i = m_rawData.size() - 1; i > 0; --i) {
-        m_rawData(i) = m_rawData(i - 1);
-        m_timers(i) = m_timers(i - 1);
+    for (Eigen::Index i = rawData.size() - 1; i > 0; --i) {
+        rawData(i) = rawData(i - 1);
+        timers(i) = timers(i - 1);
     }
-    for (Eigen::Index i = m_filteredData.size() - 1; i > 0; --i)
-        m_filteredData(i) = m_filteredData(i - 1);
+    for (Eigen::Index i = filteredData.size() - 1; i > 0; --i)
+        filteredData(i) = filteredData(i - 1);
 
-    m_timers(0) = time;
-    const Eigen::Index M = (m_rawData.size() - 1) / 2;
-    auto bCoeff = m_bCoeff;
+    timers(0) = time;
+    const Eigen::Index M = (rawData.size() - 1) / 2;
+    tvBCoeff = this->bCoeff();
     for (Eigen::Index i = 1; i < M + 1; ++i) {
-        const T diff = std::pow(m_timers(M - i) - m_timers(M + i), m_diffOrder);
-        bCoeff(M + i) /= diff;
-        bCoeff(M - i) /= diff;
-        bCoeff(M) -= (bCoeff(M - i) + bCoeff(M + i));
+        const T diff = std::pow(timers(M - i) - timers(M + i), m_diffOrder);
+        tvBCoeff(M + i) /= diff;
+        tvBCoeff(M - i) /= diff;
+        tvBCoeff(M) -= (tvBCoeff(M - i) + tvBCoeff(M + i));
     }
-    m_rawData(0) = data;
-    m_filteredData(0) = 0;
-    m_filteredData(0) = bCoeff.dot(m_rawData) - m_aCoeff.dot(m_filteredData);
-    return m_filteredData(0);
+    rawData(0) = data;
+    filteredData(0) = 0;
+    filteredData(0) = tvBCoeff.dot(rawData) - this->aCoeff().dot(filteredData);
+    if (m_flushDenormals)
+        filteredData(0) = details::flushDenormal(filteredData(0));
+    return filteredData(0);
 }
 
 template <typename T>
@@ -94,18 +221,32 @@ vectX_t<T> TVGenericFilter<T>::filter(const vectX_t<T>& data, const vectX_t<T>&
 {
     Expects(m_isInitialized);
     Expects(data.size() == time.size());
+    ScopedDenormalGuard guard;
     vectX_t<T> results(data.size());
     for (Eigen::Index i = 0; i < data.size(); ++i)
-        results(i) = stepFilter(time(i), data(i));
+        results(i) = stepFilterUnchecked(time(i), data(i));
     return results;
 }
 
+template <typename T>
+template <typename Archive>
+void TVGenericFilter<T>::serialize(Archive& ar)
+{
+    Base::serialize(ar);
+    ar(m_diffOrder);
+    ar(m_timers);
+    ar(m_tvBCoeff);
+    if constexpr (Archive::IsLoading)
+        Expects(m_timers.size() == this->bOrder() && m_tvBCoeff.size() == this->bOrder());
+}
+
 template <typename T>
 void TVGenericFilter<T>::resetFilter() noexcept
 {
-    m_filteredData.setZero(m_aCoeff.size());
-    m_rawData.setZero(m_bCoeff.size());
-    m_timers.setZero(m_bCoeff.size());
+    this->resetState();
+    m_timers.setZero(this->bOrder());
+    m_tvBCoeff.resize(this->bOrder());
+    m_tvBCoeff.vector() = this->bCoeff();
 }
 
 } // namespace difi
\ No newline at end of file
@@ -27,9 +27,10 @@
 
 #pragma once
 
-#include "DigitalFilter.h"
+#include "GenericFilter.h"
 #include "gsl/gsl_assert.h"
 #include "typedefs.h"
+#include <memory_resource>
 
 namespace difi {
 
@@ -37,17 +38,20 @@ namespace difi {
  * 
  * This is a specialization of a digital filter in order to use a moving average.
  * \tparam T Floating type.
+ * \tparam Accumulator Floating type used to compute the output, or CompensatedSum.
  */
-template <typename T>
-class MovingAverage : public DigitalFilter<T> {
+template <typename T, typename Accumulator = T>
+class MovingAverage final : public GenericFilter<T, Accumulator> {
 public:
     /*! \brief Default uninitialized constructor. */
     MovingAverage() = default;
     /*! \brief Constructor.
      * \param windowSize Size of the moving average window.
      * \param type Type of the filter.
+     * \param resource Memory resource of the data history and of the coefficients.
      */
-    MovingAverage(int windowSize, FilterType type = FilterType::Backward)
+    MovingAverage(int windowSize, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : GenericFilter<T, Accumulator>(resource)
     {
         setWindowSize(windowSize);
         this->setType(type);
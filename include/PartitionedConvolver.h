@@ -0,0 +1,405 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include "BaseFilter.h"
+#include "FilterCoefficients.h"
+#include "buffer.h"
+#include "denormals.h"
+#include "fft.h"
+#include "gsl/gsl_assert.h"
+#include "typedefs.h"
+#include <algorithm>
+#include <complex>
+#include <memory>
+#include <memory_resource>
+
+namespace difi {
+
+/*! \brief Zero-latency streaming convolution of a long FIR filter.
+ *
+ * The taps are split into partitions of blockSize() taps.
+ * The first partition is applied in the time domain, so that each output only depends on the inputs up to the current one.
+ * The other partitions are applied in the frequency domain (uniformly partitioned overlap-save):
+ * the spectra of the input blocks are multiplied with the spectra of the partitions,
+ * which gives the contribution of the tail of the filter to the next blockSize() outputs.
+ * Only the first frequency-domain partition needs the newest input block: the products of the others are spread over the samples of the block before.
+ * So every sample costs blockSize() multiply-adds and about nrPartitions() / blockSize() products of blockSize() + 1 complex bins,
+ * and the sample completing a block also transforms the last input blocks, does one product and transforms the result back,
+ * i.e. two FFTs of 2 * blockSize() points.
+ * Smaller blocks lower this worst case, larger blocks reduce the average cost.
+ *
+ * It is a filter like the others: it can be chained in a Cascade, run in a FilterBank, merged or saved in a snapshot.
+ * Its denominator must be equal to 1.
+ * The spectra and the history are allocated when the coefficients are set, stepping and swapCoeffs never allocate.
+ * \code
+ * difi::PartitionedConvolverd convolver(difi::MovingAveraged(2000));
+ * double y = convolver.stepFilter(x);
+ * \endcode
+ * \tparam T Floating type.
+ */
+template <typename T>
+class PartitionedConvolver final : public BaseFilter<T, PartitionedConvolver<T>> {
+    using Base = BaseFilter<T, PartitionedConvolver<T>>;
+    friend Base;
+    using Base::m_isInitialized;
+    using Base::m_flushDenormals;
+
+public:
+    static constexpr Eigen::Index DEFAULT_BLOCK_SIZE = 64; /*!< Default number of taps of a partition */
+
+public:
+    /*! \brief Uninitialized constructor.
+     * \param blockSize Number of taps of a partition. It must be a power of two.
+     * \param resource Memory resource of the partitions, of the data history and of the coefficients.
+     */
+    explicit PartitionedConvolver(Eigen::Index blockSize = DEFAULT_BLOCK_SIZE, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    /*! \brief Constructor.
+     * \param aCoeff Denominator coefficients of the filter. It must be of size 1.
+     * \param bCoeff Numerator coefficients of the filter in decreasing order.
+     * \param blockSize Number of taps of a partition. It must be a power of two.
+     * \param type Type of the filter.
+     * \param resource Memory resource of the partitions, of the data history and of the coefficients.
+     */
+    template <typename AVector, typename BVector>
+    PartitionedConvolver(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff, Eigen::Index blockSize = DEFAULT_BLOCK_SIZE, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : PartitionedConvolver(blockSize, resource)
+    {
+        this->setCoeffs(aCoeff, bCoeff);
+        this->setType(type);
+    }
+    /*! \brief Constructor sharing existing coefficients.
+     * \param coeffs Coefficients of a FIR filter, i.e. with a denominator equal to 1.
+     * \param blockSize Number of taps of a partition. It must be a power of two.
+     * \param type Type of the filter.
+     * \param resource Memory resource of the partitions and of the data history.
+     */
+    explicit PartitionedConvolver(std::shared_ptr<const FilterCoefficients<T>> coeffs, Eigen::Index blockSize = DEFAULT_BLOCK_SIZE, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : PartitionedConvolver(blockSize, resource)
+    {
+        this->setCoeffs(std::move(coeffs));
+        this->setType(type);
+    }
+    /*! \brief Constructor from a FIR filter, sharing its coefficients.
+     * \param filter Initialized filter with a denominator equal to 1.
+     * \param blockSize Number of taps of a partition. It must be a power of two.
+     * \param resource Memory resource of the partitions and of the data history.
+     */
+    template <typename Derived>
+    explicit PartitionedConvolver(const BaseFilter<T, Derived>& filter, Eigen::Index blockSize = DEFAULT_BLOCK_SIZE, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : PartitionedConvolver(filter.coefficients(), blockSize, filter.type(), resource)
+    {}
+
+    /*! \brief Filter a new data.
+     * \param data New data to filter.
+     * \return Filtered data.
+     */
+    T stepFilter(const T& data);
+    /*! \brief Filter a new data without checking the filter state.
+     *
+     * Same as stepFilter but without contract checks.
+     * \warning The filter must be initialized.
+     * \param data New data to filter.
+     * \return Filtered data.
+     */
+    T stepFilterUnchecked(const T& data) noexcept;
+    /*! \brief Filter a signal.
+     * \param data Signal.
+     * \return Filtered signal.
+     */
+    vectX_t<T> filter(const vectX_t<T>& data);
+    /*! \brief Filter a strided signal given by raw pointers.
+     * \param data Pointer to the first sample.
+     * \param results Pointer to the first filtered sample. It can be equal to data to filter in place.
+     * \param size Number of samples.
+     * \param dataStride Number of elements between two samples of data.
+     * \param resultsStride Number of elements between two samples of results.
+     */
+    void filter(const T* data, T* results, Eigen::Index size, Eigen::Index dataStride = 1, Eigen::Index resultsStride = 1);
+
+    void resetFilter() noexcept;
+
+    /*! \brief Return the number of taps of a partition. */
+    Eigen::Index blockSize() const noexcept { return m_blockSize; }
+    /*! \brief Return the number of partitions applied in the frequency domain. */
+    Eigen::Index nrPartitions() const noexcept { return m_nrPartitions; }
+    /*! \brief Save or restore the filter through a snapshot archive.
+     * \see saveSnapshot, restoreSnapshot
+     */
+    template <typename Archive>
+    void serialize(Archive& ar);
+
+private:
+    /*! \brief The history is kept by blocks, the base filter has none. */
+    static constexpr Eigen::Index stateSize(Eigen::Index, Eigen::Index) noexcept { return 0; }
+    /*! \brief Only accept FIR filters. */
+    template <typename AVector, typename BVector>
+    bool checkCoeffs(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff) const
+    {
+        return aCoeff.size() == 1 && Base::checkCoeffs(aCoeff, bCoeff);
+    }
+    /*! \brief Split the taps into partitions and compute their spectra. */
+    void coeffsChanged();
+    void processBlock() noexcept;
+    /*! \brief Return the end of the partitions whose products are spread over the samples of a block before the given position. */
+    Eigen::Index spreadEnd(Eigen::Index position) const noexcept { return 1 + position * (m_nrPartitions - 1) / m_blockSize; }
+    /*! \brief Accumulate the products of partitions [first, last) for a block whose newest input spectrum is in the given slot. */
+    void accumulate(Eigen::Index first, Eigen::Index last, Eigen::Index newest) noexcept;
+    /*! \brief Add the product of the first partition and transform the accumulated products into the block of outputs. */
+    void computeTail() noexcept;
+
+private:
+    Eigen::Index m_blockSize;
+    Eigen::Index m_nrPartitions = 0;
+    details::Buffer<std::complex<T>> m_twiddles; /*!< Twiddle factors of the transforms of size 2*blockSize */
+    details::Buffer<T> m_head; /*!< Taps of the time-domain partition, the oldest first */
+    details::Buffer<std::complex<T>> m_spectra; /*!< Spectra of the partitions, blockSize+1 bins each */
+    details::Buffer<std::complex<T>> m_inputSpectra; /*!< Ring of the spectra of the last input blocks, blockSize+1 bins each */
+    details::Buffer<std::complex<T>> m_accumulator; /*!< Products of the partitions for the next block of outputs, blockSize+1 bins */
+    details::Buffer<std::complex<T>> m_work; /*!< Transform workspace of 2*blockSize elements */
+    details::Buffer<T> m_input; /*!< Previous block of inputs followed by the current one */
+    details::Buffer<T> m_tail; /*!< Contribution of the frequency-domain partitions to the current block of outputs */
+    Eigen::Index m_position = 0; /*!< Position in the current block */
+    Eigen::Index m_newest = 0; /*!< Slot of the newest input spectrum */
+};
+
+template <typename T>
+PartitionedConvolver<T>::PartitionedConvolver(Eigen::Index blockSize, std::pmr::memory_resource* resource)
+    : Base(resource)
+    , m_blockSize(blockSize)
+    , m_twiddles(resource)
+    , m_head(resource)
+    , m_spectra(resource)
+    , m_inputSpectra(resource)
+    , m_accumulator(resource)
+    , m_work(resource)
+    , m_input(resource)
+    , m_tail(resource)
+{
+    Expects(blockSize > 0 && (blockSize & (blockSize - 1)) == 0);
+}
+
+template <typename T>
+T PartitionedConvolver<T>::stepFilter(const T& data)
+{
+    Expects(m_isInitialized);
+    return stepFilterUnchecked(data);
+}
+
+template <typename T>
+T PartitionedConvolver<T>::stepFilterUnchecked(const T& data) noexcept
+{
+    const Eigen::Index current = m_blockSize + m_position;
+    m_input.data()[current] = data;
+
+    // First partition in the time domain: the inputs of the previous block are contiguous with the current ones
+    const Eigen::Index headTaps = m_head.size();
+    T result = m_tail.data()[m_position] + m_head.vector().dot(m_input.segment(current - headTaps + 1, headTaps));
+
+    if (m_nrPartitions > 1)
+        accumulate(spreadEnd(m_position), spreadEnd(m_position + 1), m_newest + 1);
+    if (++m_position == m_blockSize) {
+        processBlock();
+        m_position = 0;
+    }
+    if (m_flushDenormals)
+        result = details::flushDenormal(result);
+    return result;
+}
+
+template <typename T>
+vectX_t<T> PartitionedConvolver<T>::filter(const vectX_t<T>& data)
+{
+    Expects(m_isInitialized);
+    ScopedDenormalGuard guard;
+    vectX_t<T> results(data.size());
+    for (Eigen::Index i = 0; i < data.size(); ++i)
+        results(i) = stepFilterUnchecked(data(i));
+    return results;
+}
+
+template <typename T>
+void PartitionedConvolver<T>::filter(const T* data, T* results, Eigen::Index size, Eigen::Index dataStride, Eigen::Index resultsStride)
+{
+    Expects(m_isInitialized);
+    Expects(size >= 0);
+    Expects(size == 0 || (data != nullptr && results != nullptr));
+    Expects(dataStride > 0 && resultsStride > 0);
+    ScopedDenormalGuard guard;
+    // Each sample is read before its result is written, so data and results can alias
+    for (Eigen::Index i = 0; i < size; ++i)
+        results[i * resultsStride] = stepFilterUnchecked(data[i * dataStride]);
+}
+
+template <typename T>
+void PartitionedConvolver<T>::resetFilter() noexcept
+{
+    std::fill_n(m_inputSpectra.data(), m_inputSpectra.size(), std::complex<T>(0));
+    std::fill_n(m_accumulator.data(), m_accumulator.size(), std::complex<T>(0));
+    std::fill_n(m_input.data(), m_input.size(), T(0));
+    std::fill_n(m_tail.data(), m_tail.size(), T(0));
+    m_position = 0;
+    m_newest = 0;
+}
+
+template <typename T>
+template <typename Archive>
+void PartitionedConvolver<T>::serialize(Archive& ar)
+{
+    if constexpr (Archive::IsLoading) {
+        // Everything is read and checked before the convolver is modified
+        Eigen::Index blockSize;
+        Eigen::Index position;
+        Eigen::Index newest;
+        ar(blockSize);
+        const auto fields = this->readFields(ar);
+        const auto inputSpectra = ar.template array<std::complex<T>>();
+        const auto input = ar.template array<T>();
+        const auto tail = ar.template array<T>();
+        ar(position);
+        ar(newest);
+        Expects(blockSize > 0 && (blockSize & (blockSize - 1)) == 0);
+        Expects(fields.aCoeff.size() == 1);
+        const Eigen::Index nrPartitions = (fields.bCoeff.size() - 1) / blockSize;
+        Expects(inputSpectra.size() == nrPartitions * (blockSize + 1) && input.size() == 2 * blockSize && tail.size() == blockSize);
+        Expects(position >= 0 && position < blockSize && newest >= 0 && newest < std::max(Eigen::Index(1), nrPartitions));
+
+        m_blockSize = blockSize;
+        m_inputSpectra.resize(inputSpectra.size());
+        m_inputSpectra.vector() = inputSpectra;
+        m_input.resize(input.size());
+        m_input.vector() = input;
+        m_tail.resize(tail.size());
+        m_tail.vector() = tail;
+        m_position = position;
+        m_newest = newest;
+        // The partitions depend on the block size as well as on the coefficients, and the spread products are not saved
+        if (!this->assignFields(fields))
+            coeffsChanged();
+    } else {
+        ar(m_blockSize);
+        Base::serialize(ar);
+        ar(m_inputSpectra);
+        ar(m_input);
+        ar(m_tail);
+        ar(m_position);
+        ar(m_newest);
+    }
+}
+
+template <typename T>
+void PartitionedConvolver<T>::coeffsChanged()
+{
+    const Eigen::Index taps = this->bOrder();
+    const Eigen::Index bins = m_blockSize + 1;
+    if (m_twiddles.size() != m_blockSize) {
+        m_twiddles.resize(m_blockSize);
+        details::fftTwiddles(m_twiddles.data(), static_cast<size_t>(2 * m_blockSize));
+    }
+    m_nrPartitions = (taps - 1) / m_blockSize;
+    const bool keepsHistory = m_inputSpectra.size() == m_nrPartitions * bins;
+    m_spectra.resize(m_nrPartitions * bins);
+    m_inputSpectra.resize(m_nrPartitions * bins);
+    m_accumulator.resize(bins);
+    m_work.resize(2 * m_blockSize);
+    m_input.resize(2 * m_blockSize);
+    m_tail.resize(m_blockSize);
+
+    const auto bCoeff = this->bCoeff();
+    m_head.resize(std::min(m_blockSize, taps));
+    m_head.vector() = bCoeff.head(m_head.size()).reverse();
+    for (Eigen::Index p = 0; p < m_nrPartitions; ++p) {
+        const Eigen::Index first = (p + 1) * m_blockSize;
+        const Eigen::Index size = std::min(m_blockSize, taps - first);
+        std::fill_n(m_work.data(), m_work.size(), std::complex<T>(0));
+        for (Eigen::Index i = 0; i < size; ++i)
+            m_work.data()[i] = bCoeff(first + i);
+        details::fftTransform(m_work.data(), m_twiddles.data(), static_cast<size_t>(2 * m_blockSize), false);
+        std::copy_n(m_work.data(), bins, m_spectra.data() + p * bins);
+    }
+    // The rest of the current block of outputs and the products already spread for the next one
+    // are computed again with the new coefficients, e.g. after swapCoeffs
+    if (keepsHistory && m_nrPartitions > 0) {
+        std::fill_n(m_accumulator.data(), bins, std::complex<T>(0));
+        accumulate(1, m_nrPartitions, m_newest);
+        computeTail();
+        std::fill_n(m_accumulator.data(), bins, std::complex<T>(0));
+        if (m_nrPartitions > 1)
+            accumulate(1, spreadEnd(m_position), m_newest + 1);
+    }
+}
+
+template <typename T>
+void PartitionedConvolver<T>::processBlock() noexcept
+{
+    const Eigen::Index bins = m_blockSize + 1;
+    if (m_nrPartitions > 0) {
+        // Spectrum of the last two input blocks
+        for (Eigen::Index i = 0; i < 2 * m_blockSize; ++i)
+            m_work.data()[i] = m_input.data()[i];
+        details::fftTransform(m_work.data(), m_twiddles.data(), static_cast<size_t>(2 * m_blockSize), false);
+        m_newest = (m_newest + 1) % m_nrPartitions;
+        std::copy_n(m_work.data(), bins, m_inputSpectra.data() + m_newest * bins);
+        computeTail();
+        std::fill_n(m_accumulator.data(), bins, std::complex<T>(0));
+    }
+    std::copy_n(m_input.data() + m_blockSize, m_blockSize, m_input.data());
+}
+
+template <typename T>
+void PartitionedConvolver<T>::accumulate(Eigen::Index first, Eigen::Index last, Eigen::Index newest) noexcept
+{
+    // Partition p is applied to the input spectrum of p blocks before the newest one
+    const Eigen::Index bins = m_blockSize + 1;
+    for (Eigen::Index p = first; p < last; ++p) {
+        const Eigen::Index slot = (newest - p + m_nrPartitions) % m_nrPartitions;
+        const std::complex<T>* x = m_inputSpectra.data() + slot * bins;
+        const std::complex<T>* h = m_spectra.data() + p * bins;
+        for (Eigen::Index k = 0; k < bins; ++k)
+            m_accumulator.data()[k] += details::multiply(x[k], h[k]);
+    }
+}
+
+template <typename T>
+void PartitionedConvolver<T>::computeTail() noexcept
+{
+    // The signals are real, so only the first half of the spectrum is accumulated and the other half is its conjugate
+    const Eigen::Index bins = m_blockSize + 1;
+    const std::complex<T>* x = m_inputSpectra.data() + m_newest * bins;
+    for (Eigen::Index k = 0; k < bins; ++k)
+        m_work.data()[k] = m_accumulator.data()[k] + details::multiply(x[k], m_spectra.data()[k]);
+    for (Eigen::Index k = 1; k < m_blockSize; ++k)
+        m_work.data()[2 * m_blockSize - k] = std::conj(m_work.data()[k]);
+    details::fftTransform(m_work.data(), m_twiddles.data(), static_cast<size_t>(2 * m_blockSize), true);
+
+    // The last half of the circular convolution is the linear one
+    for (Eigen::Index i = 0; i < m_blockSize; ++i)
+        m_tail.data()[i] = m_work.data()[m_blockSize + i].real();
+}
+
+} // namespace difi
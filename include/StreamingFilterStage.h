@@ -0,0 +1,138 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+#pragma once
+
+#include "DigitalFilter.h"
+#include "gsl/gsl_assert.h"
+#include "spsc_ring.h"
+#include <cstddef>
+#include <memory_resource>
+
+namespace difi {
+
+/*! \brief Filter between an acquisition thread and a consumer thread.
+ *
+ * The acquisition thread pushes the samples to an input SpscRing, never blocking.
+ * The filtering thread calls process() in its loop: it drains the input ring in batches through the block filter path
+ * and publishes the filtered samples to an output SpscRing, where the consumer thread pops them.
+ * Each ring has a single producer and a single consumer, so there is no lock and thus no priority inversion.
+ * Nothing is allocated after construction.
+ * \code
+ * difi::StreamingFilterStaged stage(difi::DigitalFilterd(bf.coefficients(), bf.type()));
+ * // Acquisition thread
+ * stage.push(sample);
+ * // Filtering thread
+ * while (running)
+ *     if (stage.process() == 0)
+ *         std::this_thread::yield();
+ * // Consumer thread
+ * while (stage.pop(result))
+ *     use(result);
+ * \endcode
+ * \tparam T Floating type.
+ * \tparam Filter Scalar filter with a filter(const T*, T*, Eigen::Index) member, e.g. a DigitalFilter or a differentiator.
+ */
+template <typename T, typename Filter = DigitalFilter<T>>
+class StreamingFilterStage {
+public:
+    /*! \brief Constructor.
+     * \param filter Initialized filter, copied in the stage.
+     * \param capacity Minimum capacity of each ring.
+     * \param batchSize Maximum number of samples filtered by a call to process().
+     * \param resource Memory resource of the rings and of the batch.
+     */
+    explicit StreamingFilterStage(const Filter& filter, std::size_t capacity = 4096, std::size_t batchSize = 256, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_filter(filter)
+        , m_input(capacity, resource)
+        , m_output(capacity, resource)
+        , m_batch(resource)
+    {
+        Expects(m_filter.isInitialized());
+        Expects(batchSize > 0);
+        m_batch.resize(static_cast<Eigen::Index>(batchSize));
+    }
+
+    /*! \brief Push a sample (acquisition thread).
+     * \return False if the input ring is full.
+     */
+    bool push(const T& sample) noexcept { return m_input.push(sample); }
+    /*! \brief Push as many samples as possible (acquisition thread).
+     * \return Number of pushed samples.
+     */
+    std::size_t push(const T* samples, std::size_t n) noexcept { return m_input.push(samples, n); }
+
+    /*! \brief Filter the pending samples, up to a batch (filtering thread).
+     *
+     * No more samples than the free space of the output ring are taken, so a slow consumer holds back the input ring instead of losing results.
+     * \return Number of filtered samples.
+     */
+    std::size_t process()
+    {
+        const std::size_t n = m_input.pop(m_batch.data(), std::min(static_cast<std::size_t>(m_batch.size()), m_output.freeSpace()));
+        if (n == 0)
+            return 0;
+        m_filter.filter(m_batch.data(), m_batch.data(), static_cast<Eigen::Index>(n));
+        m_output.push(m_batch.data(), n);
+        return n;
+    }
+
+    /*! \brief Pop a filtered sample (consumer thread).
+     * \return False if no filtered sample is available.
+     */
+    bool pop(T& result) noexcept { return m_output.pop(result); }
+    /*! \brief Pop as many filtered samples as possible (consumer thread).
+     * \return Number of popped samples.
+     */
+    std::size_t pop(T* results, std::size_t n) noexcept { return m_output.pop(results, n); }
+
+    /*! \brief Save or restore the filter through a snapshot archive (filtering thread).
+     *
+     * The samples waiting in the rings are not part of the snapshot.
+     * \see saveSnapshot, restoreSnapshot
+     */
+    template <typename Archive>
+    void serialize(Archive& ar) { m_filter.serialize(ar); }
+
+    /*! \brief Return true if the filter is initialized. */
+    bool isInitialized() const noexcept { return m_filter.isInitialized(); }
+    /*! \brief Return the filter. It must only be used by the filtering thread. */
+    Filter& filter() noexcept { return m_filter; }
+    /*! \brief Return the filter. It must only be used by the filtering thread. */
+    const Filter& filter() const noexcept { return m_filter; }
+    /*! \brief Return the capacity of each ring. */
+    std::size_t capacity() const noexcept { return m_input.capacity(); }
+    /*! \brief Return the maximum number of samples filtered by a call to process(). */
+    std::size_t batchSize() const noexcept { return static_cast<std::size_t>(m_batch.size()); }
+
+private:
+    Filter m_filter;
+    SpscRing<T> m_input;
+    SpscRing<T> m_output;
+    details::Buffer<T> m_batch;
+};
+
+} // namespace difi
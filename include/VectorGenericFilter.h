@@ -0,0 +1,225 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include "BaseFilter.h"
+
+namespace difi {
+
+/*! \brief Filter of a vector-valued signal.
+ *
+ * All the components of the signal are filtered by the same transfer function.
+ * The last samples are kept as the columns of a matrix so that filtering a new sample is a matrix-vector product.
+ * The dimension of the signal is set by setDimension() or by the first filtered sample.
+ * \tparam T Floating type.
+ */
+template <typename T>
+class VectorGenericFilter : public BaseFilter<T, VectorGenericFilter<T>> {
+    using Base = BaseFilter<T, VectorGenericFilter<T>>;
+    friend Base;
+    using Base::m_isInitialized;
+    using Base::m_flushDenormals;
+
+public:
+    /*! \brief Filter a new data.
+     * 
+     * This function is practical for online application that does not know the whole signal in advance.
+     * \param data New data to filter.
+     * \return Filtered data. The reference is valid until the next call to the filter.
+     */
+    Eigen::Ref<const vectX_t<T>> stepFilter(const Eigen::Ref<const vectX_t<T>>& data);
+    /*! \brief Filter a new data without checking the filter state.
+     *
+     * Same as stepFilter but without contract checks, so that the per-sample work is pure arithmetic.
+     * \warning The filter must be initialized and its dimension must match the data.
+     * \param data New data to filter.
+     * \return Filtered data. The reference is valid until the next call to the filter.
+     */
+    Eigen::Ref<const vectX_t<T>> stepFilterUnchecked(const Eigen::Ref<const vectX_t<T>>& data) noexcept;
+    /*! \brief Filter a signal.
+     * 
+     * Filter all data given by the signal.
+     * \param data Signal. Each column is a sample.
+     * \return Filtered signal.
+     */
+    matX_t<T> filter(const Eigen::Ref<const matX_t<T>>& data);
+    /*! \brief Filter a strided signal without copy.
+     *
+     * An interleaved buffer of frames [x0, x1, ..., xn] is a matrix whose columns are the frames,
+     * with an inner stride of 1 and an outer stride equal to the size of a frame.
+     * \param data Signal. Each column is a sample, e.g. an Eigen::Map with an Eigen::Stride.
+     * \param results Filtered signal of the same size. It can be the same memory as data to filter in place.
+     */
+    void filter(const Eigen::Ref<const matX_t<T>, 0, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>& data, Eigen::Ref<matX_t<T>, 0, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>> results);
+    /*! \brief Filter interleaved frames given by raw pointers.
+     *
+     * The components of a sample are contiguous.
+     * \warning The dimension of the filter must be set.
+     * \param data Pointer to the first component of the first sample.
+     * \param results Pointer to the first component of the first filtered sample. It can be equal to data to filter in place.
+     * \param nrSamples Number of samples.
+     * \param dataStride Number of elements between two samples of data.
+     * \param resultsStride Number of elements between two samples of results.
+     */
+    void filter(const T* data, T* results, Eigen::Index nrSamples, Eigen::Index dataStride, Eigen::Index resultsStride);
+
+    void resetFilter() noexcept;
+
+    /*! \brief Set the dimension of the signal and reset the filter. */
+    void setDimension(Eigen::Index dimension);
+    /*! \brief Return the dimension of the signal (0 if not set yet). */
+    Eigen::Index dimension() const noexcept { return m_dimension; }
+    /*! \brief Save or restore the filter through a snapshot archive.
+     * \see saveSnapshot, restoreSnapshot
+     */
+    template <typename Archive>
+    void serialize(Archive& ar);
+
+protected:
+    VectorGenericFilter() = default;
+    explicit VectorGenericFilter(std::pmr::memory_resource* resource) noexcept
+        : Base(resource)
+        , m_rawHistory(resource)
+        , m_filteredHistory(resource)
+    {}
+    template <typename AVector, typename BVector>
+    VectorGenericFilter(const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : VectorGenericFilter(resource)
+    {
+        this->setCoeffs(aCoeff, bCoeff);
+        this->setType(type);
+    }
+    template <typename Vector, typename = internal::enable_if_rvalue_t<Vector, vectX_t<T>>>
+    VectorGenericFilter(Vector&& aCoeff, Vector&& bCoeff, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : VectorGenericFilter(resource)
+    {
+        this->setCoeffs(std::move(aCoeff), std::move(bCoeff));
+        this->setType(type);
+    }
+    VectorGenericFilter(std::shared_ptr<const FilterCoefficients<T>> coeffs, FilterType type = FilterType::Backward, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : VectorGenericFilter(resource)
+    {
+        this->setCoeffs(std::move(coeffs));
+        this->setType(type);
+    }
+    /*! \brief Only the final filters can be destroyed, as the destructor is not virtual. */
+    ~VectorGenericFilter() = default;
+
+private:
+    /*! \brief The history is kept as matrices, the base filter has none. */
+    static constexpr Eigen::Index stateSize(Eigen::Index, Eigen::Index) noexcept { return 0; }
+
+    /*! \brief Filter a new data of any stride. The result is the first column of the filtered history. */
+    template <typename Derived>
+    void pushSample(const Eigen::MatrixBase<Derived>& data) noexcept;
+
+    Eigen::Index m_dimension = 0; /*!< Dimension of the signal */
+    details::Buffer<T> m_rawHistory; /*!< Last set of non-filtered data, one sample per column */
+    details::Buffer<T> m_filteredHistory; /*!< Last set of filtered data, one sample per column */
+};
+
+/*! \brief Time-varying filter of a vector-valued signal.
+ *
+ * Vector-valued version of TVGenericFilter.
+ * \tparam T Floating type.
+ */
+template <typename T>
+class TVVectorGenericFilter : public BaseFilter<T, TVVectorGenericFilter<T>> {
+    using Base = BaseFilter<T, TVVectorGenericFilter<T>>;
+    friend Base;
+    using Base::m_isInitialized;
+    using Base::m_flushDenormals;
+
+public:
+    /*! \brief Filter a new data.
+     * 
+     * This function is practical for online application that does not know the whole signal in advance.
+     * \param time Time of the new data.
+     * \param data New data to filter.
+     * \return Filtered data. The reference is valid until the next call to the filter.
+     */
+    Eigen::Ref<const vectX_t<T>> stepFilter(const T& time, const Eigen::Ref<const vectX_t<T>>& data);
+    /*! \brief Filter a new data without checking the filter state.
+     *
+     * Same as stepFilter but without contract checks, so that the per-sample work is pure arithmetic.
+     * \warning The filter must be initialized and its dimension must match the data.
+     * \param time Time of the new data.
+     * \param data New data to filter.
+     * \return Filtered data. The reference is valid until the next call to the filter.
+     */
+    Eigen::Ref<const vectX_t<T>> stepFilterUnchecked(const T& time, const Eigen::Ref<const vectX_t<T>>& data) noexcept;
+    /*! \brief Filter a signal.
+     * 
+     * Filter all data given by the signal.
+     * \param data Signal. Each column is a sample.
+     * \param time Time of each sample.
+     * \return Filtered signal.
+     */
+    matX_t<T> filter(const Eigen::Ref<const matX_t<T>>& data, const vectX_t<T>& time);
+
+    void resetFilter() noexcept;
+
+    /*! \brief Set the dimension of the signal and reset the filter. */
+    void setDimension(Eigen::Index dimension);
+    /*! \brief Return the dimension of the signal (0 if not set yet). */
+    Eigen::Index dimension() const noexcept { return m_dimension; }
+    /*! \brief Save or restore the filter through a snapshot archive.
+     * \see saveSnapshot, restoreSnapshot
+     */
+    template <typename Archive>
+    void serialize(Archive& ar);
+
+protected:
+    TVVectorGenericFilter() = default;
+    template <typename AVector, typename BVector>
+    TVVectorGenericFilter(size_t differentialOrder, const Eigen::MatrixBase<AVector>& aCoeff, const Eigen::MatrixBase<BVector>& bCoeff, FilterType type = FilterType::Backward)
+        : Base()
+        , m_diffOrder(differentialOrder)
+    {
+        Expects(differentialOrder >= 1);
+        this->setCoeffs(aCoeff, bCoeff);
+        this->setType(type);
+    }
+    /*! \brief Only the final filters can be destroyed, as the destructor is not virtual. */
+    ~TVVectorGenericFilter() = default;
+
+private:
+    /*! \brief The history is kept as matrices, the base filter has none. */
+    static constexpr Eigen::Index stateSize(Eigen::Index, Eigen::Index) noexcept { return 0; }
+
+    size_t m_diffOrder = 1;
+    details::Buffer<T> m_timers;
+    details::Buffer<T> m_tvBCoeff; /*!< Numerator coefficients at current time */
+    Eigen::Index m_dimension = 0; /*!< Dimension of the signal */
+    details::Buffer<T> m_rawHistory; /*!< Last set of non-filtered data, one sample per column */
+    details::Buffer<T> m_filteredHistory; /*!< Last set of filtered data, one sample per column */
+};
+
+} // namespace difi
+
+#include "VectorGenericFilter.tpp"
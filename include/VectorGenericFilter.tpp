@@ -0,0 +1,239 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+namespace difi {
+
+namespace details {
+
+// Shift the history by one sample. Columns are contiguous so the whole history is moved at once.
+template <typename T>
+void slideColumns(Buffer<T>& history, Eigen::Index rows) noexcept
+{
+    if (history.size() > rows)
+        std::copy_backward(history.data(), history.data() + history.size() - rows, history.data() + history.size());
+}
+
+} // namespace details
+
+template <typename T>
+Eigen::Ref<const vectX_t<T>> VectorGenericFilter<T>::stepFilter(const Eigen::Ref<const vectX_t<T>>& data)
+{
+    Expects(m_isInitialized);
+    if (dimension() == 0)
+        setDimension(data.size());
+    Expects(data.size() == dimension());
+    return stepFilterUnchecked(data);
+}
+
+template <typename T>
+Eigen::Ref<const vectX_t<T>> VectorGenericFilter<T>::stepFilterUnchecked(const Eigen::Ref<const vectX_t<T>>& data) noexcept
+{
+    pushSample(data);
+    return m_filteredHistory.matrix(m_dimension).col(0);
+}
+
+template <typename T>
+template <typename Derived>
+void VectorGenericFilter<T>::pushSample(const Eigen::MatrixBase<Derived>& data) noexcept
+{
+    details::slideColumns(m_rawHistory, m_dimension);
+    details::slideColumns(m_filteredHistory, m_dimension);
+
+    const auto aCoeff = this->aCoeff();
+    auto rawHistory = m_rawHistory.matrix(m_dimension);
+    auto filteredHistory = m_filteredHistory.matrix(m_dimension);
+    rawHistory.col(0) = data;
+    auto result = filteredHistory.col(0);
+    result.noalias() = rawHistory * this->bCoeff();
+    if (aCoeff.size() > 1)
+        result.noalias() -= filteredHistory.rightCols(aCoeff.size() - 1) * aCoeff.tail(aCoeff.size() - 1);
+    if (m_flushDenormals)
+        result = result.unaryExpr([](T value) { return details::flushDenormal(value); });
+}
+
+template <typename T>
+matX_t<T> VectorGenericFilter<T>::filter(const Eigen::Ref<const matX_t<T>>& data)
+{
+    Expects(m_isInitialized);
+    if (dimension() == 0)
+        setDimension(data.rows());
+    Expects(data.rows() == dimension());
+    ScopedDenormalGuard guard;
+    matX_t<T> results(data.rows(), data.cols());
+    for (Eigen::Index i = 0; i < data.cols(); ++i)
+        results.col(i) = stepFilterUnchecked(data.col(i));
+    return results;
+}
+
+template <typename T>
+void VectorGenericFilter<T>::filter(const Eigen::Ref<const matX_t<T>, 0, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>& data, Eigen::Ref<matX_t<T>, 0, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>> results)
+{
+    Expects(m_isInitialized);
+    Expects(data.rows() == results.rows() && data.cols() == results.cols());
+    if (dimension() == 0)
+        setDimension(data.rows());
+    Expects(data.rows() == dimension());
+    ScopedDenormalGuard guard;
+    // Each sample is copied in the history before its result is written, so data and results can alias
+    for (Eigen::Index i = 0; i < data.cols(); ++i) {
+        pushSample(data.col(i));
+        results.col(i) = m_filteredHistory.matrix(m_dimension).col(0);
+    }
+}
+
+template <typename T>
+void VectorGenericFilter<T>::filter(const T* data, T* results, Eigen::Index nrSamples, Eigen::Index dataStride, Eigen::Index resultsStride)
+{
+    Expects(dimension() > 0);
+    Expects(nrSamples >= 0);
+    Expects(nrSamples == 0 || (data != nullptr && results != nullptr));
+    Expects(dataStride >= dimension() && resultsStride >= dimension());
+    using Stride = Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>;
+    using StridedMap = Eigen::Map<matX_t<T>, 0, Stride>;
+    using ConstStridedMap = Eigen::Map<const matX_t<T>, 0, Stride>;
+    filter(ConstStridedMap(data, dimension(), nrSamples, Stride(dataStride, 1)), StridedMap(results, dimension(), nrSamples, Stride(resultsStride, 1)));
+}
+
+template <typename T>
+void VectorGenericFilter<T>::resetFilter() noexcept
+{
+    m_filteredHistory.setZero(m_dimension * this->aOrder());
+    m_rawHistory.setZero(m_dimension * this->bOrder());
+}
+
+template <typename T>
+template <typename Archive>
+void VectorGenericFilter<T>::serialize(Archive& ar)
+{
+    Base::serialize(ar);
+    ar(m_dimension);
+    ar(m_rawHistory);
+    ar(m_filteredHistory);
+    if constexpr (Archive::IsLoading)
+        Expects(m_rawHistory.size() == m_dimension * this->bOrder() && m_filteredHistory.size() == m_dimension * this->aOrder());
+}
+
+template <typename T>
+void VectorGenericFilter<T>::setDimension(Eigen::Index dimension)
+{
+    Expects(dimension > 0);
+    m_dimension = dimension;
+    resetFilter();
+}
+
+template <typename T>
+Eigen::Ref<const vectX_t<T>> TVVectorGenericFilter<T>::stepFilter(const T& time, const Eigen::Ref<const vectX_t<T>>& data)
+{
+    Expects(m_isInitialized);
+    if (dimension() == 0)
+        setDimension(data.size());
+    Expects(data.size() == dimension());
+    return stepFilterUnchecked(time, data);
+}
+
+template <typename T>
+Eigen::Ref<const vectX_t<T>> TVVectorGenericFilter<T>::stepFilterUnchecked(const T& time, const Eigen::Ref<const vectX_t<T>>& data) noexcept
+{
+    details::slideColumns(m_rawHistory, m_dimension);
+    details::slideColumns(m_filteredHistory, m_dimension);
+    details::slideColumns(m_timers, 1);
+
+    auto timers = m_timers.vector();
+    auto tvBCoeff = m_tvBCoeff.vector();
+    timers(0) = time;
+    const Eigen::Index M = (tvBCoeff.size() - 1) / 2;
+    tvBCoeff = this->bCoeff();
+    for (Eigen::Index i = 1; i < M + 1; ++i) {
+        const T diff = std::pow(timers(M - i) - timers(M + i), m_diffOrder);
+        tvBCoeff(M + i) /= diff;
+        tvBCoeff(M - i) /= diff;
+        tvBCoeff(M) -= (tvBCoeff(M - i) + tvBCoeff(M + i));
+    }
+
+    const auto aCoeff = this->aCoeff();
+    auto rawHistory = m_rawHistory.matrix(m_dimension);
+    auto filteredHistory = m_filteredHistory.matrix(m_dimension);
+    rawHistory.col(0) = data;
+    auto result = filteredHistory.col(0);
+    result.noalias() = rawHistory * tvBCoeff;
+    if (aCoeff.size() > 1)
+        result.noalias() -= filteredHistory.rightCols(aCoeff.size() - 1) * aCoeff.tail(aCoeff.size() - 1);
+    if (m_flushDenormals)
+        result = result.unaryExpr([](T value) { return details::flushDenormal(value); });
+    return result;
+}
+
+template <typename T>
+matX_t<T> TVVectorGenericFilter<T>::filter(const Eigen::Ref<const matX_t<T>>& data, const vectX_t<T>& time)
+{
+    Expects(m_isInitialized);
+    Expects(data.cols() == time.size());
+    if (dimension() == 0)
+        setDimension(data.rows());
+    Expects(data.rows() == dimension());
+    ScopedDenormalGuard guard;
+    matX_t<T> results(data.rows(), data.cols());
+    for (Eigen::Index i = 0; i < data.cols(); ++i)
+        results.col(i) = stepFilterUnchecked(time(i), data.col(i));
+    return results;
+}
+
+template <typename T>
+void TVVectorGenericFilter<T>::resetFilter() noexcept
+{
+    m_filteredHistory.setZero(m_dimension * this->aOrder());
+    m_rawHistory.setZero(m_dimension * this->bOrder());
+    m_timers.setZero(this->bOrder());
+    m_tvBCoeff.setZero(this->bOrder());
+}
+
+template <typename T>
+template <typename Archive>
+void TVVectorGenericFilter<T>::serialize(Archive& ar)
+{
+    Base::serialize(ar);
+    ar(m_diffOrder);
+    ar(m_timers);
+    ar(m_tvBCoeff);
+    ar(m_dimension);
+    ar(m_rawHistory);
+    ar(m_filteredHistory);
+    if constexpr (Archive::IsLoading) {
+        Expects(m_timers.size() == this->bOrder() && m_tvBCoeff.size() == this->bOrder());
+        Expects(m_rawHistory.size() == m_dimension * this->bOrder() && m_filteredHistory.size() == m_dimension * this->aOrder());
+    }
+}
+
+template <typename T>
+void TVVectorGenericFilter<T>::setDimension(Eigen::Index dimension)
+{
+    Expects(dimension > 0);
+    m_dimension = dimension;
+    resetFilter();
+}
+
+} // namespace difi
@@ -0,0 +1,90 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include "typedefs.h"
+#include <type_traits>
+
+namespace difi {
+
+/*! \brief Accumulator tag for a compensated (Neumaier) summation in the storage precision.
+ *
+ * \see https://en.wikipedia.org/wiki/Kahan_summation_algorithm#Further_enhancements
+ */
+struct CompensatedSum {};
+
+namespace internal {
+
+/*! \brief Compute \f$b^T x - a^T y\f$, the output of a digital filter.
+ *
+ * The data are stored in T while the sum is done in Accumulator.
+ * \tparam T Floating type of the coefficients and of the data.
+ * \tparam Accumulator Floating type of the sum or CompensatedSum.
+ */
+template <typename T, typename Accumulator>
+struct FilterKernel {
+    static_assert(std::is_floating_point<Accumulator>::value, "The accumulator must be a floating point type or CompensatedSum.");
+    static_assert(sizeof(Accumulator) >= sizeof(T), "The accumulator can't be less precise than the storage type.");
+
+    template <typename BVector, typename XVector, typename AVector, typename YVector>
+    static T run(const BVector& bCoeff, const XVector& rawData, const AVector& aCoeff, const YVector& filteredData) noexcept
+    {
+        if constexpr (std::is_same<T, Accumulator>::value)
+            return bCoeff.dot(rawData) - aCoeff.dot(filteredData);
+        else
+            return static_cast<T>(bCoeff.template cast<Accumulator>().dot(rawData.template cast<Accumulator>()) - aCoeff.template cast<Accumulator>().dot(filteredData.template cast<Accumulator>()));
+    }
+};
+
+template <typename T>
+struct FilterKernel<T, CompensatedSum> {
+    template <typename BVector, typename XVector, typename AVector, typename YVector>
+    static T run(const BVector& bCoeff, const XVector& rawData, const AVector& aCoeff, const YVector& filteredData) noexcept
+    {
+        T sum = T(0);
+        T c = T(0);
+        const auto add = [&sum, &c](T value) {
+            const T t = sum + value;
+            if (std::abs(sum) >= std::abs(value))
+                c += (sum - t) + value;
+            else
+                c += (value - t) + sum;
+            sum = t;
+        };
+
+        for (Eigen::Index i = 0; i < bCoeff.size(); ++i)
+            add(bCoeff(i) * rawData(i));
+        for (Eigen::Index i = 0; i < aCoeff.size(); ++i)
+            add(-aCoeff(i) * filteredData(i));
+        return sum + c;
+    }
+};
+
+} // namespace internal
+
+} // namespace difi
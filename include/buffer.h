@@ -0,0 +1,230 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include "typedefs.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace difi {
+
+/*! \brief RAII guard that sets the default memory resource in its scope.
+ *
+ * Filters take their memory resource from std::pmr::get_default_resource() when they are constructed without an explicit one.
+ * Constructing a whole pipeline under this guard puts all the coefficients and histories of its filters into one arena,
+ * e.g. a std::pmr::monotonic_buffer_resource allocated at startup and released in one shot.
+ * It is only a convenience over passing the resource to the constructors of the filters.
+ * \warning The default memory resource is global to the program, not to the thread.
+ * The guard is meant to be used while building the filters, not while other threads construct objects.
+ * A FilterBank is not affected: its workers copy the filters into memory resources of their own.
+ */
+class ScopedMemoryResource {
+public:
+    explicit ScopedMemoryResource(std::pmr::memory_resource* resource) noexcept
+        : m_previous(std::pmr::set_default_resource(resource))
+    {}
+    ~ScopedMemoryResource() noexcept { std::pmr::set_default_resource(m_previous); }
+
+    ScopedMemoryResource(const ScopedMemoryResource&) = delete;
+    ScopedMemoryResource& operator=(const ScopedMemoryResource&) = delete;
+
+private:
+    std::pmr::memory_resource* m_previous;
+};
+
+namespace details {
+
+/*! \brief Return the memory resource that replaces the default one for the buffers created by the calling thread, or null. */
+inline std::pmr::memory_resource*& threadMemoryResource() noexcept
+{
+    thread_local std::pmr::memory_resource* resource = nullptr;
+    return resource;
+}
+
+/*! \brief Return the memory resource of the buffers created by the calling thread without an explicit one. */
+inline std::pmr::memory_resource* defaultMemoryResource() noexcept
+{
+    std::pmr::memory_resource* resource = threadMemoryResource();
+    return resource ? resource : std::pmr::get_default_resource();
+}
+
+/*! \brief RAII guard that sets the memory resource of the buffers created or copied by the calling thread only.
+ *
+ * Unlike ScopedMemoryResource, it does not touch the default memory resource of the program,
+ * so that several threads can copy filters at the same time, each one into its own resource.
+ */
+class ScopedThreadMemoryResource {
+public:
+    explicit ScopedThreadMemoryResource(std::pmr::memory_resource* resource) noexcept
+        : m_previous(std::exchange(threadMemoryResource(), resource))
+    {}
+    ~ScopedThreadMemoryResource() noexcept { threadMemoryResource() = m_previous; }
+
+    ScopedThreadMemoryResource(const ScopedThreadMemoryResource&) = delete;
+    ScopedThreadMemoryResource& operator=(const ScopedThreadMemoryResource&) = delete;
+
+private:
+    std::pmr::memory_resource* m_previous;
+};
+
+/*! \brief Contiguous storage allocated from a polymorphic memory resource.
+ *
+ * It follows the std::pmr containers: the resource is chosen at construction and never changes,
+ * a copy uses the default resource (see ScopedThreadMemoryResource), and a move steals the storage only if both resources are equal.
+ * Resizing to the current size does not allocate.
+ * The content is viewed through Eigen::Map.
+ * \tparam T Type of the elements. It must be trivially copyable.
+ */
+template <typename T>
+class Buffer {
+    static_assert(std::is_trivially_copyable<T>::value, "Only accept trivially copyable types.");
+    static constexpr std::size_t Alignment = std::max<std::size_t>(alignof(T), EIGEN_DEFAULT_ALIGN_BYTES);
+
+public:
+    Buffer() noexcept = default;
+    explicit Buffer(std::pmr::memory_resource* resource) noexcept
+        : m_resource(resource)
+    {}
+    Buffer(const Buffer& other)
+    {
+        resize(other.m_size);
+        std::copy_n(other.m_data, other.m_size, m_data);
+    }
+    Buffer(Buffer&& other) noexcept
+        : m_resource(other.m_resource)
+        , m_data(std::exchange(other.m_data, nullptr))
+        , m_size(std::exchange(other.m_size, 0))
+    {}
+    Buffer& operator=(const Buffer& other)
+    {
+        if (this != &other) {
+            resize(other.m_size);
+            std::copy_n(other.m_data, other.m_size, m_data);
+        }
+        return *this;
+    }
+    Buffer& operator=(Buffer&& other)
+    {
+        if (this == &other)
+            return *this;
+        if (*m_resource == *other.m_resource) {
+            deallocate();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        } else {
+            *this = static_cast<const Buffer&>(other);
+        }
+        return *this;
+    }
+    ~Buffer() noexcept { deallocate(); }
+
+    /*! \brief Resize the buffer. The content is lost unless the size is unchanged. */
+    void resize(Eigen::Index size)
+    {
+        if (size == m_size)
+            return;
+        deallocate();
+        if (size > 0) {
+            m_data = static_cast<T*>(m_resource->allocate(static_cast<std::size_t>(size) * sizeof(T), Alignment));
+            m_size = size;
+        }
+    }
+    /*! \brief Resize the buffer and set all elements to zero. */
+    void setZero(Eigen::Index size)
+    {
+        resize(size);
+        std::fill_n(m_data, m_size, T(0));
+    }
+
+    T* data() noexcept { return m_data; }
+    const T* data() const noexcept { return m_data; }
+    Eigen::Index size() const noexcept { return m_size; }
+    std::pmr::memory_resource* resource() const noexcept { return m_resource; }
+
+    Eigen::Map<vectX_t<T>> segment(Eigen::Index start, Eigen::Index size) noexcept { return { m_data + start, size }; }
+    Eigen::Map<const vectX_t<T>> segment(Eigen::Index start, Eigen::Index size) const noexcept { return { m_data + start, size }; }
+    Eigen::Map<vectX_t<T>> vector() noexcept { return { m_data, m_size }; }
+    Eigen::Map<const vectX_t<T>> vector() const noexcept { return { m_data, m_size }; }
+    /*! \brief View the buffer as a column-major matrix of the given number of rows. */
+    Eigen::Map<matX_t<T>> matrix(Eigen::Index rows) noexcept { return { m_data, rows, rows > 0 ? m_size / rows : 0 }; }
+    /*! \brief View the buffer as a column-major matrix of the given number of rows. */
+    Eigen::Map<const matX_t<T>> matrix(Eigen::Index rows) const noexcept { return { m_data, rows, rows > 0 ? m_size / rows : 0 }; }
+
+private:
+    void deallocate() noexcept
+    {
+        if (m_data)
+            m_resource->deallocate(m_data, static_cast<std::size_t>(m_size) * sizeof(T), Alignment);
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+private:
+    std::pmr::memory_resource* m_resource = defaultMemoryResource();
+    T* m_data = nullptr;
+    Eigen::Index m_size = 0;
+};
+
+/*! \brief Scratch storage of a filter, allocated on first use.
+ *
+ * Its content is meaningless between two calls, so it is never copied:
+ * a copy starts empty, and an assignment keeps the current storage so that it never allocates.
+ * \tparam T Type of the elements. It must be trivially copyable.
+ */
+template <typename T>
+class Workspace {
+public:
+    Workspace() noexcept = default;
+    explicit Workspace(std::pmr::memory_resource* resource) noexcept
+        : m_buffer(resource)
+    {}
+    Workspace(const Workspace&) noexcept {}
+    Workspace(Workspace&&) noexcept = default;
+    Workspace& operator=(const Workspace&) noexcept { return *this; }
+    Workspace& operator=(Workspace&&) noexcept { return *this; }
+
+    /*! \brief Return storage for at least size elements. It only allocates if it is too small. */
+    T* reserve(Eigen::Index size)
+    {
+        if (m_buffer.size() < size)
+            m_buffer.resize(size);
+        return m_buffer.data();
+    }
+    /*! \brief Return the number of allocated elements. */
+    Eigen::Index capacity() const noexcept { return m_buffer.size(); }
+
+private:
+    Buffer<T> m_buffer;
+};
+
+} // namespace details
+
+} // namespace difi
@@ -0,0 +1,110 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define DIFI_HAS_SSE_CSR
+#include <xmmintrin.h>
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define DIFI_HAS_AARCH64_FPCR
+#include <cstdint>
+#endif
+
+namespace difi {
+
+/*! \brief RAII guard that disables denormal (subnormal) floating-point arithmetic in its scope.
+ *
+ * On x86, it sets the Flush-To-Zero and Denormals-Are-Zero bits of the SSE control register.
+ * On AArch64, it sets the Flush-To-Zero bit of the FPCR.
+ * The previous state is restored on destruction. It does nothing on other architectures.
+ * Recursive filters that receive a silent input decay toward zero and end up computing with denormal numbers,
+ * which can be 10-100 times slower on some processors.
+ * \note The control register is thread-local, the guard only affects the calling thread.
+ */
+class ScopedDenormalGuard {
+public:
+    ScopedDenormalGuard() noexcept
+    {
+#if defined(DIFI_HAS_SSE_CSR)
+        m_state = _mm_getcsr();
+        _mm_setcsr(m_state | FTZ_DAZ_MASK);
+#elif defined(DIFI_HAS_AARCH64_FPCR)
+        asm volatile("mrs %0, fpcr" : "=r"(m_state));
+        asm volatile("msr fpcr, %0" : : "r"(m_state | FZ_MASK));
+#endif
+    }
+    ~ScopedDenormalGuard() noexcept
+    {
+#if defined(DIFI_HAS_SSE_CSR)
+        _mm_setcsr(m_state);
+#elif defined(DIFI_HAS_AARCH64_FPCR)
+        asm volatile("msr fpcr, %0" : : "r"(m_state));
+#endif
+    }
+
+    ScopedDenormalGuard(const ScopedDenormalGuard&) = delete;
+    ScopedDenormalGuard& operator=(const ScopedDenormalGuard&) = delete;
+
+    /*! \brief Return true if the guard has an effect on this architecture. */
+    static constexpr bool isSupported() noexcept
+    {
+#if defined(DIFI_HAS_SSE_CSR) || defined(DIFI_HAS_AARCH64_FPCR)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+private:
+#if defined(DIFI_HAS_SSE_CSR)
+    static constexpr unsigned int FTZ_DAZ_MASK = 0x8040; /*!< FTZ (bit 15) and DAZ (bit 6) */
+    unsigned int m_state;
+#elif defined(DIFI_HAS_AARCH64_FPCR)
+    static constexpr std::uint64_t FZ_MASK = std::uint64_t(1) << 24; /*!< FZ (bit 24) */
+    std::uint64_t m_state;
+#endif
+};
+
+namespace details {
+
+// Replace a denormal value by zero.
+template <typename T>
+inline T flushDenormal(T value) noexcept
+{
+    return std::abs(value) < std::numeric_limits<T>::min() ? T(0) : value;
+}
+
+} // namespace details
+
+} // namespace difi
+
+#undef DIFI_HAS_SSE_CSR
+#undef DIFI_HAS_AARCH64_FPCR
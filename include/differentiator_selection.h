@@ -0,0 +1,200 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include "differentiators.h"
+#include "frequency_response.h"
+#include "gsl/gsl_assert.h"
+#include "typedefs.h"
+#include <algorithm>
+#include <complex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace difi {
+
+/*! \brief Requirements on a fixed time-step differentiator.
+ * \tparam T Floating type.
+ */
+template <typename T>
+struct DifferentiatorSpecification {
+    T samplingFrequency; /*!< Sampling frequency of the signal (Hz) */
+    T bandwidth; /*!< Highest frequency of interest of the signal (Hz) */
+    T noiseStd; /*!< Standard deviation of the (white) noise on the signal */
+    T maxNoiseStd; /*!< Maximum allowed standard deviation of the noise on the derivative */
+    T maxDelay; /*!< Maximum allowed delay of the derivative (s) */
+    T maxBandError = T(0.05); /*!< Maximum relative error on the derivative within the bandwidth */
+    int order = 1; /*!< Derivative order (1 or 2) */
+};
+
+/*! \brief Evaluation of a differentiator against a DifferentiatorSpecification.
+ * \tparam T Floating type.
+ */
+template <typename T>
+struct DifferentiatorDesign {
+    std::string name; /*!< Alias of the differentiator in differentiators.h, e.g. CenteredDiffNoiseRobust2<T, 7> */
+    int N; /*!< Number of taps */
+    int order; /*!< Derivative order */
+    FilterType type; /*!< Filter type */
+    vectX_t<T> bCoeff; /*!< Numerator coefficients for a unit time-step */
+    T delay = T(0); /*!< Delay of the derivative (s) */
+    T noiseStd = T(0); /*!< Standard deviation of the noise on the derivative */
+    T bandError = T(0); /*!< Worst relative error on the derivative within the bandwidth */
+
+    /*! \brief Return true if the differentiator meets the specification. */
+    bool meets(const DifferentiatorSpecification<T>& spec) const noexcept
+    {
+        return delay <= spec.maxDelay && noiseStd <= spec.maxNoiseStd && bandError <= spec.maxBandError;
+    }
+};
+
+namespace details {
+
+template <typename T, int N> using GetBSG1Coeffs = GetBSGCoeffs<T, N, 1, 1>;
+template <typename T, int N> using GetBSG2Coeffs = GetBSGCoeffs<T, N, 2, 1>;
+template <typename T, int N> using GetCSG4Coeffs = GetCSGCoeffs<T, N, 4, 1>;
+template <typename T, int N> using GetBSG22Coeffs = GetBSGCoeffs<T, N, 2, 2>;
+template <typename T, int N> using GetCSG22Coeffs = GetCSGCoeffs<T, N, 2, 2>;
+
+template <typename T, template <typename, int> class CoeffGetter, int... Ns>
+void appendFamily(std::vector<DifferentiatorDesign<T>>& designs, const std::string& name, const std::string& extraParams, int order, FilterType type, std::integer_sequence<int, Ns...>)
+{
+    const auto append = [&](int N, vectX_t<T>&& bCoeff) {
+        DifferentiatorDesign<T> d;
+        d.name = name + "<T, " + std::to_string(N) + extraParams + ">";
+        d.N = N;
+        d.order = order;
+        d.type = type;
+        d.bCoeff = std::move(bCoeff);
+        designs.push_back(std::move(d));
+    };
+    (append(Ns, CoeffGetter<T, Ns>{}()), ...);
+}
+
+} // namespace details
+
+/*! \brief Return all the fixed time-step differentiators of differentiators.h of a given order.
+ *
+ * Each family is listed for all the sizes it is defined for (up to 16 taps).
+ * \param order Derivative order (1 or 2).
+ * \return Unevaluated designs.
+ */
+template <typename T>
+std::vector<DifferentiatorDesign<T>> differentiatorCandidates(int order)
+{
+    using namespace details;
+    Expects(order == 1 || order == 2);
+    std::vector<DifferentiatorDesign<T>> designs;
+    if (order == 1) {
+        appendFamily<T, GetFNRCoeffs>(designs, "BackwardDiffNoiseRobust", "", 1, FilterType::Backward, std::integer_sequence<int, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16>{});
+        appendFamily<T, GetFHNRCoeffs>(designs, "BackwardDiffHybridNoiseRobust", "", 1, FilterType::Backward, std::integer_sequence<int, 4, 5, 6, 7, 8, 9, 10, 11, 16>{});
+        appendFamily<T, GetBSG1Coeffs>(designs, "BackwardSavitzkyGolay", ", 1", 1, FilterType::Backward, std::integer_sequence<int, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16>{});
+        appendFamily<T, GetBSG2Coeffs>(designs, "BackwardSavitzkyGolay", ", 2", 1, FilterType::Backward, std::integer_sequence<int, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16>{});
+        appendFamily<T, GetCDCoeffs>(designs, "CenteredDiffBasic", "", 1, FilterType::Centered, std::integer_sequence<int, 3, 5, 7, 9>{});
+        appendFamily<T, GetLNLCoeffs>(designs, "CenteredDiffLowNoiseLanczos", "", 1, FilterType::Centered, std::integer_sequence<int, 3, 5, 7, 9, 11, 13, 15>{});
+        appendFamily<T, GetSLNLCoeffs>(designs, "CenteredDiffSuperLowNoiseLanczos", "", 1, FilterType::Centered, std::integer_sequence<int, 7, 9, 11>{});
+        appendFamily<T, GetCNR2Coeffs>(designs, "CenteredDiffNoiseRobust2", "", 1, FilterType::Centered, std::integer_sequence<int, 3, 5, 7, 9, 11, 13, 15>{});
+        appendFamily<T, GetCNR4Coeffs>(designs, "CenteredDiffNoiseRobust4", "", 1, FilterType::Centered, std::integer_sequence<int, 7, 9, 11>{});
+        appendFamily<T, GetCSG4Coeffs>(designs, "CenteredSavitzkyGolay", ", 4", 1, FilterType::Centered, std::integer_sequence<int, 5, 7, 9, 11, 13, 15>{});
+    } else {
+        appendFamily<T, GetSOFNRCoeffs>(designs, "BackwardDiffSecondOrder", "", 2, FilterType::Backward, std::integer_sequence<int, 5, 7, 9, 11, 13, 15>{});
+        appendFamily<T, GetBSG22Coeffs>(designs, "BackwardSavitzkyGolay", ", 2, 2", 2, FilterType::Backward, std::integer_sequence<int, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16>{});
+        appendFamily<T, GetSOCNRCoeffs>(designs, "CenteredDiffSecondOrder", "", 2, FilterType::Centered, std::integer_sequence<int, 5, 7, 9, 11, 13, 15>{});
+        appendFamily<T, GetCSG22Coeffs>(designs, "CenteredSavitzkyGolay", ", 2, 2", 2, FilterType::Centered, std::integer_sequence<int, 3, 5, 7, 9, 11, 13, 15>{});
+    }
+
+    return designs;
+}
+
+/*! \brief Compute delay, noise gain and in-band error of a differentiator.
+ *
+ * The ideal response is \f$(j\omega)^k e^{-j\omega D}\f$ with \f$D\f$ the center of the filter (0 for FilterType::Backward filters).
+ * The in-band error is the worst relative error of the frequency response on \f$]0, 2\pi bandwidth/fs]\f$.
+ * The noise on the derivative is computed assuming a white noise on the signal.
+ * \param design Design to evaluate.
+ * \param spec Specifications.
+ * \param nrPoints Number of frequencies used to evaluate the in-band error.
+ */
+template <typename T>
+void evaluateDifferentiator(DifferentiatorDesign<T>& design, const DifferentiatorSpecification<T>& spec, int nrPoints = 64)
+{
+    Expects(spec.samplingFrequency > T(0) && spec.bandwidth > T(0) && spec.bandwidth < spec.samplingFrequency / T(2));
+    Expects(nrPoints > 0);
+
+    const T fsk = std::pow(spec.samplingFrequency, static_cast<T>(design.order));
+    const Eigen::Index center = (design.type == FilterType::Backward ? 0 : (design.bCoeff.size() - 1) / 2);
+    design.delay = static_cast<T>(center) / spec.samplingFrequency;
+    design.noiseStd = spec.noiseStd * design.bCoeff.norm() * fsk;
+
+    const T wMax = T(2) * pi<T> * spec.bandwidth / spec.samplingFrequency;
+    const vectX_t<T> w = vectX_t<T>::LinSpaced(nrPoints, wMax / static_cast<T>(nrPoints), wMax);
+    vectXc_t<T> h(nrPoints);
+    freqz<T>(vectX_t<T>::Ones(1), design.bCoeff, w, h);
+    design.bandError = T(0);
+    for (int i = 0; i < nrPoints; ++i) {
+        const std::complex<T> ideal = std::pow(std::complex<T>(T(0), w(i)), design.order) * std::polar(T(1), -w(i) * static_cast<T>(center));
+        design.bandError = std::max(design.bandError, std::abs(h(i) - ideal) / std::abs(ideal));
+    }
+}
+
+/*! \brief Evaluate all differentiator candidates against a specification.
+ * \param spec Specifications.
+ * \return Evaluated designs sorted by number of taps then by noise.
+ */
+template <typename T>
+std::vector<DifferentiatorDesign<T>> evaluateDifferentiators(const DifferentiatorSpecification<T>& spec)
+{
+    auto designs = differentiatorCandidates<T>(spec.order);
+    for (auto& d : designs)
+        evaluateDifferentiator(d, spec);
+
+    std::stable_sort(designs.begin(), designs.end(), [](const DifferentiatorDesign<T>& lhs, const DifferentiatorDesign<T>& rhs) {
+        return lhs.N < rhs.N || (lhs.N == rhs.N && lhs.noiseStd < rhs.noiseStd);
+    });
+    return designs;
+}
+
+/*! \brief Find the differentiator with the fewest taps meeting a specification.
+ *
+ * Ties are broken by selecting the less noisy differentiator.
+ * \param spec Specifications.
+ * \return The selected differentiator, or nothing if none meets the specifications.
+ */
+template <typename T>
+std::optional<DifferentiatorDesign<T>> selectDifferentiator(const DifferentiatorSpecification<T>& spec)
+{
+    auto designs = evaluateDifferentiators(spec);
+    auto it = std::find_if(designs.begin(), designs.end(), [&spec](const DifferentiatorDesign<T>& d) { return d.meets(spec); });
+    if (it == designs.end())
+        return std::nullopt;
+    return std::move(*it);
+}
+
+} // namespace difi
@@ -28,6 +28,8 @@
 #pragma once
 #include "DigitalFilter.h"
 #include "math_utils.h"
+#include <Eigen/Cholesky>
+#include <array>
 
 // Read this if you are an adulator of the math god: https://arxiv.org/pdf/1709.08321.pdf
 
@@ -46,7 +48,7 @@ template <typename T> struct GetCDCoeffs<T, 3> {
     vectN_t<T, 3> operator()() const { return (vectN_t<T, 3>() << T(1), T(0), T(-1)).finished() / T(2); }
 };
 template <typename T> struct GetCDCoeffs<T, 5> {
-    vectN_t<T, 5> operator()() const { return (vectN_t<T, 5>() << T(-1), T(8), T(0), T(8), T(1)).finished() / T(12); }
+    vectN_t<T, 5> operator()() const { return (vectN_t<T, 5>() << T(-1), T(8), T(0), T(-8), T(1)).finished() / T(12); }
 };
 template <typename T> struct GetCDCoeffs<T, 7> {
     vectN_t<T, 7> operator()() const { return (vectN_t<T, 7>() << T(1), T(-9), T(45), T(0), T(-45), T(9), T(-1)).finished() / T(60); }
@@ -140,7 +142,7 @@ template <typename T> struct GetFHNRCoeffs<T, 11> {
     vectN_t<T, 11> operator()() const { return (vectN_t<T, 11>() << T(320), T(206), T(-8), T(-47), T(-186), T(-150), T(-214), T(-103), T(-92), T(94), T(180)).finished() / T(1540); }
 };
 template <typename T> struct GetFHNRCoeffs<T, 16> {
-    vectN_t<T, 16> operator()() const { return (vectN_t<T, 16>() << T(322), T(217), T(110), T(35), T(-42), T(-87), T(-134), T(-149), T(-166), T(-151), T(-138), T(-93), T(-50), T(28), T(98), T(203)).finished() / T(2856); }
+    vectN_t<T, 16> operator()() const { return (vectN_t<T, 16>() << T(322), T(217), T(110), T(35), T(-42), T(-87), T(-134), T(-149), T(-166), T(-151), T(-138), T(-93), T(-50), T(25), T(98), T(203)).finished() / T(2856); }
 };
 
 template <typename T, int N, typename BackwardCoeffs> vectN_t<T, N> GetBackwardISDCoeffs()
@@ -252,7 +254,7 @@ struct GetSOCNRCoeffs {
 };
 // Second-Order Backward Noise-Robust differentiator: http://www.holoborodko.com/pavel/downloads/NoiseRobustSecondDerivative.pdf
 template <typename T, int N> struct GetSOFNRCoeffs {
-    vectN_t<T, N> operator()() const { return GetSOCNRCoeffs<T, N>(); }
+    vectN_t<T, N> operator()() const { return GetSOCNRCoeffs<T, N>{}(); }
 }; // Coefficients are the same.
 
 // Second-Order Centered Noise-Robust Irregular Space Data differentiator: http://www.holoborodko.com/pavel/downloads/NoiseRobustSecondDerivative.pdf
@@ -283,59 +285,287 @@ struct GetSOCNRISDCoeffs {
 
 // Second-Order Backward Noise-Robust Irregular Space Data differentiator: http://www.holoborodko.com/pavel/downloads/NoiseRobustSecondDerivative.pdf
 template <typename T, int N> struct GetSOFNRISDCoeffs {
-    vectN_t<T, N> operator()() const { return GetSOCNRISDCoeffs<T, N>(); }
+    vectN_t<T, N> operator()() const { return GetSOCNRISDCoeffs<T, N>{}(); }
 }; // Same coefficients
 
+/*
+ * Savitzky-Golay differentiators
+ */
+
+// Least-squares projection of a window of N samples onto a polynome of order PolyOrder: https://en.wikipedia.org/wiki/Savitzky%E2%80%93Golay_filter
+// The returned kernel gives the DerivOrder-th derivative of the fitted polynome at abscissa 0, x(k) being the abscissa of the k-th newest sample.
+// Everything is constexpr so that the fixed-sampling kernels are evaluated at compile-time.
+template <int N, int PolyOrder, int DerivOrder>
+constexpr std::array<long double, N> GetSGKernel(const std::array<long double, N>& x)
+{
+    constexpr const int P = PolyOrder + 1;
+
+    // Gram matrix A^T.A with A the Vandermonde matrix, augmented with the identity for the Gauss-Jordan inversion
+    std::array<std::array<long double, 2 * P>, P> g{};
+    for (int i = 0; i < P; ++i) {
+        for (int j = 0; j < P; ++j) {
+            g[i][j] = 0;
+            for (int k = 0; k < N; ++k) {
+                long double xp = 1;
+                for (int e = 0; e < i + j; ++e)
+                    xp *= x[k];
+                g[i][j] += xp;
+            }
+        }
+        g[i][P + i] = 1;
+    }
+
+    for (int c = 0; c < P; ++c) {
+        int pivot = c;
+        for (int r = c + 1; r < P; ++r)
+            if ((g[r][c] < 0 ? -g[r][c] : g[r][c]) > (g[pivot][c] < 0 ? -g[pivot][c] : g[pivot][c]))
+                pivot = r;
+        for (int j = 0; j < 2 * P; ++j) {
+            const long double tmp = g[c][j];
+            g[c][j] = g[pivot][j];
+            g[pivot][j] = tmp;
+        }
+        const long double diag = g[c][c];
+        for (int j = 0; j < 2 * P; ++j)
+            g[c][j] /= diag;
+        for (int r = 0; r < P; ++r) {
+            if (r == c)
+                continue;
+            const long double f = g[r][c];
+            for (int j = 0; j < 2 * P; ++j)
+                g[r][j] -= f * g[c][j];
+        }
+    }
+
+    constexpr const long double fact = Factorial<long double>(DerivOrder);
+
+    // h(k) = d! * sum_j (A^T.A)^-1(d, j) * x(k)^j
+    std::array<long double, N> h{};
+    for (int k = 0; k < N; ++k) {
+        h[k] = 0;
+        long double xp = 1;
+        for (int j = 0; j < P; ++j) {
+            h[k] += g[DerivOrder][P + j] * xp;
+            xp *= x[k];
+        }
+        h[k] *= fact;
+    }
+
+    return h;
+}
+
+template <int N, bool IsCentered>
+constexpr std::array<long double, N> GetSGAbscissae()
+{
+    std::array<long double, N> x{};
+    for (int k = 0; k < N; ++k)
+        x[k] = IsCentered ? static_cast<long double>((N - 1) / 2 - k) : static_cast<long double>(-k);
+    return x;
+}
+
+// Backward Savitzky-Golay differentiators (derivative estimated at the newest sample)
+template <typename T, int N, int PolyOrder, int DerivOrder>
+struct GetBSGCoeffs {
+    vectN_t<T, N> operator()() const
+    {
+        static_assert(PolyOrder >= 0 && PolyOrder < N, "PolyOrder must be in [0, N - 1]");
+        static_assert(DerivOrder >= 0 && DerivOrder <= PolyOrder, "DerivOrder must be in [0, PolyOrder]");
+        constexpr const std::array<long double, N> h = GetSGKernel<N, PolyOrder, DerivOrder>(GetSGAbscissae<N, false>());
+        vectN_t<T, N> v{};
+        for (int k = 0; k < N; ++k)
+            v(k) = static_cast<T>(h[k]);
+        return v;
+    }
+};
+
+// Centered Savitzky-Golay differentiators (derivative estimated at the middle sample)
+template <typename T, int N, int PolyOrder, int DerivOrder>
+struct GetCSGCoeffs {
+    vectN_t<T, N> operator()() const
+    {
+        static_assert(N > 2 && N % 2 == 1, "'N' must be odd.");
+        static_assert(PolyOrder >= 0 && PolyOrder < N, "PolyOrder must be in [0, N - 1]");
+        static_assert(DerivOrder >= 0 && DerivOrder <= PolyOrder, "DerivOrder must be in [0, PolyOrder]");
+        constexpr const std::array<long double, N> h = GetSGKernel<N, PolyOrder, DerivOrder>(GetSGAbscissae<N, true>());
+        vectN_t<T, N> v{};
+        for (int k = 0; k < N; ++k)
+            v(k) = static_cast<T>(h[k]);
+        return v;
+    }
+};
+
 /*
  * Differentiator Generator
  */
 
-template <typename T, int N, int Order, typename CoeffGetter>
-class BackwardDifferentiator : public GenericFilter<T> {
+template <typename T, int N, int Order, typename CoeffGetter, typename Filter = GenericFilter<T>>
+class BackwardDifferentiator final : public Filter {
 public:
     BackwardDifferentiator()
-        : GenericFilter<T>(vectX_t<T>::Constant(1, T(1)), CoeffGetter{}())
+        : Filter(vectX_t<T>::Constant(1, T(1)), CoeffGetter{}())
     {}
     BackwardDifferentiator(T timestep)
-        : GenericFilter<T>(vectX_t<T>::Constant(1, T(1)), CoeffGetter{}() / std::pow(timestep, Order))
+        : Filter(vectX_t<T>::Constant(1, T(1)), CoeffGetter{}() / std::pow(timestep, Order))
     {}
     void setTimestep(T timestep) { this->setCoeffs(vectX_t<T>::Constant(1, T(1)), CoeffGetter{}() / std::pow(timestep, Order)); }
     T timestep() const noexcept { return std::pow(this->bCoeff()(0) / CoeffGetter{}()(0), T(1) / Order); }
 };
 
-template <typename T, int N, int Order, typename CoeffGetter>
-class CenteredDifferentiator : public GenericFilter<T> {
+template <typename T, int N, int Order, typename CoeffGetter, typename Filter = GenericFilter<T>>
+class CenteredDifferentiator final : public Filter {
 public:
     CenteredDifferentiator()
-        : GenericFilter<T>(vectX_t<T>::Constant(1, T(1)), CoeffGetter{}(), FilterType::Centered)
+        : Filter(vectX_t<T>::Constant(1, T(1)), CoeffGetter{}(), FilterType::Centered)
     {}
     CenteredDifferentiator(T timestep)
-        : GenericFilter<T>(vectX_t<T>::Constant(1, T(1)), CoeffGetter{}() / std::pow(timestep, Order))
+        : Filter(vectX_t<T>::Constant(1, T(1)), CoeffGetter{}() / std::pow(timestep, Order), FilterType::Centered)
     {}
     void setTimestep(T timestep) { this->setCoeffs(vectX_t<T>::Constant(1, T(1)), CoeffGetter{}() / std::pow(timestep, Order)); }
     T timestep() const noexcept { return std::pow(this->bCoeff()(0) / CoeffGetter{}()(0), T(1) / Order); }
 };
 
-template <typename T, int N, int Order, typename CoeffGetter>
-class TVBackwardDifferentiator : public TVGenericFilter<T> {
+template <typename T, int N, int Order, typename CoeffGetter, typename Filter = TVGenericFilter<T>>
+class TVBackwardDifferentiator final : public Filter {
     static_assert(Order >= 1, "Order must be greater or equal to 1");
 
 public:
     TVBackwardDifferentiator()
-        : TVGenericFilter<T>(Order, vectX_t<T>::Constant(1, T(1)), CoeffGetter{}())
+        : Filter(Order, vectX_t<T>::Constant(1, T(1)), CoeffGetter{}())
     {}
 };
 
-template <typename T, int N, int Order, typename CoeffGetter>
-class TVCenteredDifferentiator : public TVGenericFilter<T> {
+template <typename T, int N, int Order, typename CoeffGetter, typename Filter = TVGenericFilter<T>>
+class TVCenteredDifferentiator final : public Filter {
     static_assert(Order >= 1, "Order must be greater or equal to 1");
 
 public:
     TVCenteredDifferentiator()
-        : TVGenericFilter<T>(Order, vectX_t<T>::Constant(1, T(1)), CoeffGetter{}(), FilterType::Centered)
+        : Filter(Order, vectX_t<T>::Constant(1, T(1)), CoeffGetter{}(), FilterType::Centered)
     {}
 };
 
+template <typename T, int N, int PolyOrder, int DerivOrder, FilterType Type>
+class TVSavitzkyGolayDifferentiator final : public BaseFilter<T, TVSavitzkyGolayDifferentiator<T, N, PolyOrder, DerivOrder, Type>> {
+    static_assert(PolyOrder >= 0 && PolyOrder < N, "PolyOrder must be in [0, N - 1]");
+    static_assert(DerivOrder >= 0 && DerivOrder <= PolyOrder, "DerivOrder must be in [0, PolyOrder]");
+    using Base = BaseFilter<T, TVSavitzkyGolayDifferentiator<T, N, PolyOrder, DerivOrder, Type>>;
+    using Base::m_isInitialized;
+    static constexpr const int P = PolyOrder + 1;
+
+public:
+    TVSavitzkyGolayDifferentiator()
+        : Base()
+    {
+        // The fixed-sampling kernel is only kept for the filter size and type, the real one is computed at each step.
+        if constexpr (Type == FilterType::Centered)
+            this->setCoeffs(vectX_t<T>::Constant(1, T(1)), GetCSGCoeffs<T, N, PolyOrder, DerivOrder>{}());
+        else
+            this->setCoeffs(vectX_t<T>::Constant(1, T(1)), GetBSGCoeffs<T, N, PolyOrder, DerivOrder>{}());
+        this->setType(Type);
+    }
+
+    /*! \brief Filter a new data.
+     *
+     * The least-squares projection is re-computed from the time of the last N samples.
+     * \param time Time of the new data.
+     * \param data New data to filter.
+     * \return Filtered data.
+     */
+    T stepFilter(const T& time, const T& data);
+    /*! \brief Filter a new data without checking the filter state.
+     *
+     * Same as stepFilter but without contract checks, so that the per-sample work is pure arithmetic.
+     * \param time Time of the new data.
+     * \param data New data to filter.
+     * \return Filtered data.
+     */
+    T stepFilterUnchecked(const T& time, const T& data) noexcept;
+    /*! \brief Filter a signal.
+     * \param data Signal.
+     * \param time Time of each sample of the signal.
+     * \return Filtered signal.
+     */
+    vectX_t<T> filter(const vectX_t<T>& data, const vectX_t<T>& time);
+
+    void resetFilter() noexcept;
+
+    /*! \brief Save or restore the filter through a snapshot archive.
+     * \see saveSnapshot, restoreSnapshot
+     */
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        Base::serialize(ar);
+        ar(m_timers);
+        if constexpr (Archive::IsLoading)
+            Expects(this->bOrder() == N);
+    }
+
+private:
+    vectN_t<T, N> m_timers;
+};
+
+template <typename T, int N, int PolyOrder, int DerivOrder, FilterType Type>
+T TVSavitzkyGolayDifferentiator<T, N, PolyOrder, DerivOrder, Type>::stepFilter(const T& time, const T& data)
+{
+    Expects(m_isInitialized);
+    return stepFilterUnchecked(time, data);
+}
+
+template <typename T, int N, int PolyOrder, int DerivOrder, FilterType Type>
+T TVSavitzkyGolayDifferentiator<T, N, PolyOrder, DerivOrder, Type>::stepFilterUnchecked(const T& time, const T& data) noexcept
+{
+    auto rawData = this->rawData();
+    auto filteredData = this->filteredData();
+
+    for (Eigen::Index i = N - 1; i > 0; --i) {
+        rawData(i) = rawData(i - 1);
+        m_timers(i) = m_timers(i - 1);
+    }
+    rawData(0) = data;
+    m_timers(0) = time;
+
+    // Abscissae are normalized by the mean time step to keep the Gram matrix well conditioned
+    const T h = (m_timers(0) - m_timers(N - 1)) / static_cast<T>(N - 1);
+    if (!(h > T(0))) { // Not enough samples yet
+        filteredData(0) = T(0);
+        return filteredData(0);
+    }
+
+    const T tEval = (Type == FilterType::Centered ? m_timers((N - 1) / 2) : m_timers(0));
+    Eigen::Matrix<T, N, P> A;
+    for (int k = 0; k < N; ++k) {
+        const T x = (m_timers(k) - tEval) / h;
+        A(k, 0) = T(1);
+        for (int j = 1; j < P; ++j)
+            A(k, j) = A(k, j - 1) * x;
+    }
+
+    const Eigen::Matrix<T, P, P> G = A.transpose() * A;
+    const vectN_t<T, P> y = G.ldlt().solve(vectN_t<T, P>::Unit(DerivOrder));
+    const T scale = Factorial<T>(DerivOrder) / std::pow(h, DerivOrder);
+    filteredData(0) = scale * (A * y).dot(rawData);
+    return filteredData(0);
+}
+
+template <typename T, int N, int PolyOrder, int DerivOrder, FilterType Type>
+vectX_t<T> TVSavitzkyGolayDifferentiator<T, N, PolyOrder, DerivOrder, Type>::filter(const vectX_t<T>& data, const vectX_t<T>& time)
+{
+    Expects(m_isInitialized);
+    Expects(data.size() == time.size());
+    vectX_t<T> results(data.size());
+    for (Eigen::Index i = 0; i < data.size(); ++i)
+        results(i) = stepFilterUnchecked(time(i), data(i));
+    return results;
+}
+
+template <typename T, int N, int PolyOrder, int DerivOrder, FilterType Type>
+void TVSavitzkyGolayDifferentiator<T, N, PolyOrder, DerivOrder, Type>::resetFilter() noexcept
+{
+    this->resetState();
+    m_timers.setZero();
+}
+
 } // namespace details
 
 // Backward differentiators
@@ -365,4 +595,35 @@ template <typename T, int N> using CenteredDiffSecondOrder = details::CenteredDi
 // Second-order Time-Varying centered differentiators
 template <typename T, int N> using TVCenteredDiffSecondOrder = details::TVCenteredDifferentiator<T, N, 2, details::GetSOCNRISDCoeffs<T, N>>;
 
+// Savitzky-Golay differentiators (DerivOrder = 0 gives the smoother)
+template <typename T, int N, int PolyOrder, int DerivOrder = 1> using BackwardSavitzkyGolay = details::BackwardDifferentiator<T, N, DerivOrder, details::GetBSGCoeffs<T, N, PolyOrder, DerivOrder>>;
+template <typename T, int N, int PolyOrder, int DerivOrder = 1> using CenteredSavitzkyGolay = details::CenteredDifferentiator<T, N, DerivOrder, details::GetCSGCoeffs<T, N, PolyOrder, DerivOrder>>;
+// Time-Varying Savitzky-Golay differentiators
+template <typename T, int N, int PolyOrder, int DerivOrder = 1> using TVBackwardSavitzkyGolay = details::TVSavitzkyGolayDifferentiator<T, N, PolyOrder, DerivOrder, FilterType::Backward>;
+template <typename T, int N, int PolyOrder, int DerivOrder = 1> using TVCenteredSavitzkyGolay = details::TVSavitzkyGolayDifferentiator<T, N, PolyOrder, DerivOrder, FilterType::Centered>;
+
+
+// Vector-valued backward differentiators
+template <typename T, int N> using VectorBackwardDiffNoiseRobust = details::BackwardDifferentiator<T, N, 1, details::GetFNRCoeffs<T, N>, VectorGenericFilter<T>>;
+template <typename T, int N> using VectorBackwardDiffHybridNoiseRobust = details::BackwardDifferentiator<T, N, 1, details::GetFHNRCoeffs<T, N>, VectorGenericFilter<T>>;
+template <typename T, int N> using VectorBackwardDiffSecondOrder = details::BackwardDifferentiator<T, N, 2, details::GetSOFNRCoeffs<T, N>, VectorGenericFilter<T>>;
+template <typename T, int N, int PolyOrder, int DerivOrder = 1> using VectorBackwardSavitzkyGolay = details::BackwardDifferentiator<T, N, DerivOrder, details::GetBSGCoeffs<T, N, PolyOrder, DerivOrder>, VectorGenericFilter<T>>;
+// Vector-valued time-varying backward differentiators
+template <typename T, int N> using TVVectorBackwardDiffNoiseRobust = details::TVBackwardDifferentiator<T, N, 1, details::GetFNRISDCoeffs<T, N>, TVVectorGenericFilter<T>>;
+template <typename T, int N> using TVVectorBackwardDiffHybridNoiseRobust = details::TVBackwardDifferentiator<T, N, 1, details::GetFHNRISDCoeffs<T, N>, TVVectorGenericFilter<T>>;
+template <typename T, int N> using TVVectorBackwardDiffSecondOrder = details::TVBackwardDifferentiator<T, N, 2, details::GetSOFNRISDCoeffs<T, N>, TVVectorGenericFilter<T>>;
+
+// Vector-valued centered differentiators
+template <typename T, int N> using VectorCenteredDiffBasic = details::CenteredDifferentiator<T, N, 1, details::GetCDCoeffs<T, N>, VectorGenericFilter<T>>;
+template <typename T, int N> using VectorCenteredDiffLowNoiseLanczos = details::CenteredDifferentiator<T, N, 1, details::GetLNLCoeffs<T, N>, VectorGenericFilter<T>>;
+template <typename T, int N> using VectorCenteredDiffSuperLowNoiseLanczos = details::CenteredDifferentiator<T, N, 1, details::GetSLNLCoeffs<T, N>, VectorGenericFilter<T>>;
+template <typename T, int N> using VectorCenteredDiffNoiseRobust2 = details::CenteredDifferentiator<T, N, 1, details::GetCNR2Coeffs<T, N>, VectorGenericFilter<T>>;
+template <typename T, int N> using VectorCenteredDiffNoiseRobust4 = details::CenteredDifferentiator<T, N, 1, details::GetCNR4Coeffs<T, N>, VectorGenericFilter<T>>;
+template <typename T, int N> using VectorCenteredDiffSecondOrder = details::CenteredDifferentiator<T, N, 2, details::GetSOCNRCoeffs<T, N>, VectorGenericFilter<T>>;
+template <typename T, int N, int PolyOrder, int DerivOrder = 1> using VectorCenteredSavitzkyGolay = details::CenteredDifferentiator<T, N, DerivOrder, details::GetCSGCoeffs<T, N, PolyOrder, DerivOrder>, VectorGenericFilter<T>>;
+// Vector-valued time-varying centered differentiators
+template <typename T, int N> using TVVectorCenteredDiffNoiseRobust2 = details::TVCenteredDifferentiator<T, N, 1, details::GetCNR2ISDCoeffs<T, N>, TVVectorGenericFilter<T>>;
+template <typename T, int N> using TVVectorCenteredDiffNoiseRobust4 = details::TVCenteredDifferentiator<T, N, 1, details::GetCNR4ISDCoeffs<T, N>, TVVectorGenericFilter<T>>;
+template <typename T, int N> using TVVectorCenteredDiffSecondOrder = details::TVCenteredDifferentiator<T, N, 2, details::GetSOCNRISDCoeffs<T, N>, TVVectorGenericFilter<T>>;
+
 } // namespace difi
\ No newline at end of file
@@ -0,0 +1,162 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include "buffer.h"
+#include "gsl/gsl_assert.h"
+#include "typedefs.h"
+#include <complex>
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+namespace difi {
+
+namespace details {
+
+/*! \brief Complex product without the NaN and infinity recovery of std::complex operator*, which is not inlined. */
+template <typename T>
+inline std::complex<T> multiply(const std::complex<T>& lhs, const std::complex<T>& rhs) noexcept
+{
+    return { lhs.real() * rhs.real() - lhs.imag() * rhs.imag(), lhs.real() * rhs.imag() + lhs.imag() * rhs.real() };
+}
+
+/*! \brief Compute the twiddle factors of a radix-2 FFT.
+ * \param twiddles Array of size / 2 elements.
+ * \param size Size of the transform. It must be a power of two.
+ */
+template <typename T>
+void fftTwiddles(std::complex<T>* twiddles, size_t size) noexcept
+{
+    // Twiddles are computed once instead of accumulated, for accuracy
+    for (size_t k = 0; k < size / 2; ++k)
+        twiddles[k] = std::polar(T(1), T(-2) * pi<T> * static_cast<T>(k) / static_cast<T>(size));
+}
+
+/*! \brief In-place radix-2 FFT with precomputed twiddle factors.
+ * \param data Array of size elements.
+ * \param twiddles Twiddle factors computed by fftTwiddles for the same size.
+ * \param size Size of the transform. It must be a power of two.
+ * \param inverse Compute the inverse transform, scaled by 1/size.
+ */
+template <typename T>
+void fftTransform(std::complex<T>* data, const std::complex<T>* twiddles, size_t size, bool inverse) noexcept
+{
+    // Bit-reversal permutation, the reversed index being incremented from the top bit
+    for (size_t i = 1, j = 0; i < size; ++i) {
+        size_t bit = size >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(data[i], data[j]);
+    }
+    // std::complex is layout-compatible with an array of two T
+    T* values = reinterpret_cast<T*>(data);
+    const T* w = reinterpret_cast<const T*>(twiddles);
+    const T sign = inverse ? T(-1) : T(1);
+    for (size_t len = 2; len <= size; len <<= 1) {
+        const size_t step = size / len;
+        const size_t half = len / 2;
+        for (size_t i = 0; i < size; i += len) {
+            T* u = values + 2 * i;
+            T* v = values + 2 * (i + half);
+            for (size_t j = 0; j < half; ++j) {
+                const T wr = w[2 * j * step];
+                const T wi = sign * w[2 * j * step + 1];
+                const T vr = v[2 * j] * wr - v[2 * j + 1] * wi;
+                const T vi = v[2 * j] * wi + v[2 * j + 1] * wr;
+                v[2 * j] = u[2 * j] - vr;
+                v[2 * j + 1] = u[2 * j + 1] - vi;
+                u[2 * j] += vr;
+                u[2 * j + 1] += vi;
+            }
+        }
+    }
+    if (inverse) {
+        const T scale = T(1) / static_cast<T>(size);
+        for (size_t i = 0; i < size; ++i)
+            data[i] *= scale;
+    }
+}
+
+/*! \brief In-place radix-2 FFT of a fixed size.
+ *
+ * The twiddle factors are computed once, so that a plan can transform many blocks.
+ * \tparam T Floating type.
+ */
+template <typename T>
+class FFTPlan {
+public:
+    /*! \brief Constructor.
+     * \param size Size of the transform. It must be a power of two.
+     * \param resource Memory resource of the twiddle factors.
+     */
+    explicit FFTPlan(size_t size, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_size(size)
+        , m_twiddles(resource)
+    {
+        Expects(size > 0 && (size & (size - 1)) == 0);
+        m_twiddles.resize(static_cast<Eigen::Index>(size / 2));
+        fftTwiddles(m_twiddles.data(), size);
+    }
+
+    /*! \brief Return the size of the transform. */
+    size_t size() const noexcept { return m_size; }
+
+    /*! \brief Transform in place.
+     * \param data Array of size() elements.
+     * \param inverse Compute the inverse transform, scaled by 1/size().
+     */
+    void transform(std::complex<T>* data, bool inverse) const noexcept { fftTransform(data, m_twiddles.data(), m_size, inverse); }
+
+private:
+    size_t m_size;
+    Buffer<std::complex<T>> m_twiddles;
+};
+
+/*! \brief Return the smallest power of two greater or equal to size. */
+inline size_t nextPowerOfTwo(size_t size) noexcept
+{
+    size_t n = 1;
+    while (n < size)
+        n <<= 1;
+    return n;
+}
+
+// In-place radix-2 FFT. The size must be a power of two.
+template <typename T>
+void fft(std::vector<std::complex<T>>& data, bool inverse)
+{
+    FFTPlan<T>(data.size()).transform(data.data(), inverse);
+}
+
+} // namespace details
+
+} // namespace difi
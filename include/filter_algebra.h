@@ -0,0 +1,109 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include "BaseFilter.h"
+#include "Cascade.h"
+#include "DigitalFilter.h"
+#include "gsl/gsl_assert.h"
+#include "polynome_functions.h"
+#include "typedefs.h"
+#include <tuple>
+#include <utility>
+
+namespace difi {
+
+/*! \brief Merge two filters applied one after the other into a single filter.
+ *
+ * The transfer function of the result is the product of both transfer functions: \f$b=b_1*b_2\f$ and \f$a=a_1*a_2\f$.
+ * Merging FIR filters gives a FIR filter, and long FIR filters are multiplied through an FFT.
+ * The result is FilterType::Centered only if both filters are centered, in which case its center is the sum of both centers.
+ * Otherwise it is FilterType::Backward, and a centered stage loses its center.
+ * \param lhs First filter to apply.
+ * \param rhs Second filter to apply.
+ * \return Merged filter.
+ */
+template <typename T, typename Derived1, typename Derived2>
+DigitalFilter<T> merge(const BaseFilter<T, Derived1>& lhs, const BaseFilter<T, Derived2>& rhs)
+{
+    Expects(lhs.isInitialized() && rhs.isInitialized());
+    const bool isCentered = lhs.type() == FilterType::Centered && rhs.type() == FilterType::Centered;
+    return DigitalFilter<T>(polyMultiply<T>(lhs.aCoeff(), rhs.aCoeff()), polyMultiply<T>(lhs.bCoeff(), rhs.bCoeff()), isCentered ? FilterType::Centered : FilterType::Backward);
+}
+
+/*! \brief Merge all the stages of a cascade into a single filter.
+ * \see merge(const BaseFilter<T, Derived1>&, const BaseFilter<T, Derived2>&)
+ * \param chain Cascade to merge.
+ * \return Merged filter.
+ */
+template <typename T, typename Filter, typename... Filters>
+DigitalFilter<T> merge(const Cascade<T, Filter, Filters...>& chain)
+{
+    return std::apply([](const Filter& first, const Filters&... others) {
+        DigitalFilter<T> merged(first.aCoeff(), first.bCoeff(), first.type());
+        ((merged = merge(merged, others)), ...);
+        return merged;
+    },
+        chain.stages());
+}
+
+/*! \brief Factor a filter into second-order sections.
+ *
+ * The zeros and poles of the filter are the roots of its numerator and denominator.
+ * \see zpkToSOS
+ * \param filter Filter to factor. The first coefficient of its numerator must not be 0.
+ * \return Matrix of size \f$L\times 6\f$ where each row is a section \f$[b_0, b_1, b_2, 1, a_1, a_2]\f$.
+ */
+template <typename T, typename Derived>
+matX_t<T> toSOS(const BaseFilter<T, Derived>& filter)
+{
+    Expects(filter.isInitialized());
+    const vectX_t<T> aCoeff = filter.aCoeff();
+    const vectX_t<T> bCoeff = filter.bCoeff();
+    Expects(bCoeff(0) != T(0));
+    return zpkToSOS<T>(polyRoots(bCoeff), polyRoots(aCoeff), bCoeff(0) / aCoeff(0));
+}
+
+/*! \brief Build a filter from second-order sections.
+ * \param sos Matrix of size \f$L\times 6\f$ where each row is a section \f$[b_0, b_1, b_2, a_0, a_1, a_2]\f$.
+ * \return Filter equivalent to the sections applied one after the other.
+ */
+template <typename T>
+DigitalFilter<T> fromSOS(const matX_t<T>& sos)
+{
+    Expects(sos.rows() > 0 && sos.cols() == 6);
+    vectX_t<T> aCoeff = sos.row(0).tail(3).transpose();
+    vectX_t<T> bCoeff = sos.row(0).head(3).transpose();
+    for (Eigen::Index i = 1; i < sos.rows(); ++i) {
+        aCoeff = polyMultiply<T>(aCoeff, sos.row(i).tail(3).transpose());
+        bCoeff = polyMultiply<T>(bCoeff, sos.row(i).head(3).transpose());
+    }
+    return DigitalFilter<T>(std::move(aCoeff), std::move(bCoeff));
+}
+
+} // namespace difi
@@ -0,0 +1,294 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include "BaseFilter.h"
+#include "fft.h"
+#include "gsl/gsl_assert.h"
+#include "type_checks.h"
+#include "typedefs.h"
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <vector>
+
+namespace difi {
+
+namespace details {
+
+// Values of exp(-jw) at all frequencies
+template <typename T>
+vectXc_t<T> unitDelays(const Eigen::Ref<const vectX_t<T>>& w)
+{
+    vectXc_t<T> zInv(w.size());
+    zInv.real() = w.array().cos().matrix();
+    zInv.imag() = -w.array().sin().matrix();
+    return zInv;
+}
+
+// Polynome in z^-1 at all frequencies, by Horner's scheme vectorized over the frequencies
+template <typename T>
+void evalPolynome(const Eigen::Ref<const vectX_t<T>>& coeffs, const vectXc_t<T>& zInv, vectXc_t<T>& result)
+{
+    result.setConstant(zInv.size(), std::complex<T>(coeffs(coeffs.size() - 1)));
+    for (Eigen::Index k = coeffs.size() - 2; k >= 0; --k)
+        result.array() = result.array() * zInv.array() + std::complex<T>(coeffs(k));
+}
+
+// Group delay of a polynome in z^-1: Re(sum k c_k z^-k / sum c_k z^-k), 0 where the polynome vanishes
+template <typename T>
+void polynomeDelay(const Eigen::Ref<const vectX_t<T>>& coeffs, const vectXc_t<T>& zInv, Eigen::Ref<vectX_t<T>> delay)
+{
+    vectXc_t<T> value = vectXc_t<T>::Constant(zInv.size(), std::complex<T>(coeffs(coeffs.size() - 1)));
+    vectXc_t<T> derivative = vectXc_t<T>::Zero(zInv.size());
+    for (Eigen::Index k = coeffs.size() - 2; k >= 0; --k) {
+        derivative.array() = derivative.array() * zInv.array() + value.array();
+        value.array() = value.array() * zInv.array() + std::complex<T>(coeffs(k));
+    }
+
+    const T tol = std::numeric_limits<T>::epsilon() * coeffs.cwiseAbs().sum();
+    for (Eigen::Index i = 0; i < zInv.size(); ++i)
+        delay(i) = std::abs(value(i)) > tol ? (zInv(i) * derivative(i) / value(i)).real() : T(0);
+}
+
+template <typename T>
+void unwrap(Eigen::Ref<vectX_t<T>> phase) noexcept
+{
+    T offset = T(0);
+    for (Eigen::Index i = 1; i < phase.size(); ++i) {
+        const T jump = phase(i) + offset - phase(i - 1);
+        offset -= T(2) * pi<T> * std::round(jump / (T(2) * pi<T>));
+        phase(i) += offset;
+    }
+}
+
+template <typename T>
+void frequencyResponse(const Eigen::Ref<const vectX_t<T>>& aCoeff, const Eigen::Ref<const vectX_t<T>>& bCoeff, const vectXc_t<T>& zInv, Eigen::Ref<vectXc_t<T>> h)
+{
+    Expects(aCoeff.size() > 0 && bCoeff.size() > 0);
+    vectXc_t<T> num;
+    vectXc_t<T> den;
+    evalPolynome<T>(bCoeff, zInv, num);
+    evalPolynome<T>(aCoeff, zInv, den);
+    h.array() = num.array() / den.array();
+}
+
+} // namespace details
+
+/*! \brief Compute the frequency response of a filter.
+ *
+ * \f$H(e^{j\omega}) = \frac{\sum_k b_k e^{-jk\omega}}{\sum_k a_k e^{-jk\omega}}\f$ is evaluated at all frequencies at once:
+ * Horner's scheme runs over the coefficients on whole vectors of frequencies, which Eigen vectorizes.
+ * \param aCoeff Denominator coefficients of the filter in decreasing order.
+ * \param bCoeff Numerator coefficients of the filter in decreasing order.
+ * \param w Normalized angular frequencies in rad/sample, \f$\omega=2\pi f/f_s\f$.
+ * \param[out] h Frequency response, of the size of w.
+ * \see https://www.mathworks.com/help/signal/ref/freqz.html
+ */
+template <typename T>
+void freqz(const vectX_t<T>& aCoeff, const vectX_t<T>& bCoeff, const Eigen::Ref<const vectX_t<internal::non_deduced_t<T>>>& w, Eigen::Ref<vectXc_t<internal::non_deduced_t<T>>> h)
+{
+    Expects(h.size() == w.size());
+    details::frequencyResponse<T>(aCoeff, bCoeff, details::unitDelays<T>(w), h);
+}
+
+/*! \brief Compute the frequency response of a filter.
+ * \see freqz(const vectX_t<T>&, const vectX_t<T>&, const Eigen::Ref<const vectX_t<T>>&, Eigen::Ref<vectXc_t<T>>)
+ * \param filter Initialized filter.
+ * \param w Normalized angular frequencies in rad/sample.
+ * \param[out] h Frequency response, of the size of w.
+ */
+template <typename T, typename Derived>
+void freqz(const BaseFilter<T, Derived>& filter, const Eigen::Ref<const vectX_t<internal::non_deduced_t<T>>>& w, Eigen::Ref<vectXc_t<internal::non_deduced_t<T>>> h)
+{
+    Expects(filter.isInitialized());
+    Expects(h.size() == w.size());
+    details::frequencyResponse<T>(filter.aCoeff(), filter.bCoeff(), details::unitDelays<T>(w), h);
+}
+
+/*! \brief Compute the frequency response of a filter on a uniform grid.
+ *
+ * The grid is \f$\omega_k = \pi k / N\f$ for \f$k = 0..N-1\f$ with N the size of h.
+ * For long filters and N a power of two, the numerator and the denominator are evaluated by an FFT of size 2N
+ * in \f$O(N\log N)\f$, otherwise by Horner's scheme in \f$O(N\times taps)\f$.
+ * \param filter Initialized filter.
+ * \param[out] h Frequency response.
+ */
+template <typename T, typename Derived>
+void freqz(const BaseFilter<T, Derived>& filter, Eigen::Ref<vectXc_t<internal::non_deduced_t<T>>> h)
+{
+    Expects(filter.isInitialized());
+    const Eigen::Index n = h.size();
+    if (n == 0)
+        return;
+
+    size_t log2n = 0;
+    while ((size_t(1) << log2n) < static_cast<size_t>(2 * n))
+        ++log2n;
+    const bool useFFT = (n & (n - 1)) == 0 && filter.aOrder() + filter.bOrder() > static_cast<Eigen::Index>(4 * log2n);
+    if (!useFFT) {
+        const vectX_t<T> w = vectX_t<T>::LinSpaced(n, T(0), pi<T> * static_cast<T>(n - 1) / static_cast<T>(n));
+        details::frequencyResponse<T>(filter.aCoeff(), filter.bCoeff(), details::unitDelays<T>(w), h);
+        return;
+    }
+
+    // exp(-jw_k m) is periodic in m of period 2N, so coefficients beyond 2N are folded
+    const details::FFTPlan<T> plan(static_cast<size_t>(2 * n));
+    auto spectrum = [&plan](const Eigen::Map<const vectX_t<T>>& coeffs) {
+        std::vector<std::complex<T>> values(plan.size());
+        for (Eigen::Index k = 0; k < coeffs.size(); ++k)
+            values[static_cast<size_t>(k) % plan.size()] += coeffs(k);
+        plan.transform(values.data(), false);
+        return values;
+    };
+    const std::vector<std::complex<T>> num = spectrum(filter.bCoeff());
+    const std::vector<std::complex<T>> den = spectrum(filter.aCoeff());
+    for (Eigen::Index k = 0; k < n; ++k)
+        h(k) = num[static_cast<size_t>(k)] / den[static_cast<size_t>(k)];
+}
+
+/*! \brief Compute the frequency responses of several filters on the same frequencies.
+ *
+ * The unit delays \f$e^{-j\omega}\f$ are computed once for all the filters.
+ * \param filters Pointer to the first filter. All the filters must be initialized.
+ * \param count Number of filters.
+ * \param w Normalized angular frequencies in rad/sample.
+ * \param[out] h Matrix of size w.size() x count. Column i is the frequency response of filter i.
+ */
+template <typename Filter>
+void freqz(const Filter* filters, Eigen::Index count, const Eigen::Ref<const vectX_t<details::filter_scalar_t<Filter>>>& w, Eigen::Ref<matX_t<std::complex<details::filter_scalar_t<Filter>>>> h)
+{
+    using T = details::filter_scalar_t<Filter>;
+    Expects(count >= 0);
+    Expects(count == 0 || filters != nullptr);
+    Expects(h.rows() == w.size() && h.cols() == count);
+    const vectXc_t<T> zInv = details::unitDelays<T>(w);
+    for (Eigen::Index i = 0; i < count; ++i) {
+        Expects(filters[i].isInitialized());
+        details::frequencyResponse<T>(filters[i].aCoeff(), filters[i].bCoeff(), zInv, h.col(i));
+    }
+}
+
+/*! \brief Compute the frequency response of second-order sections.
+ * \param sos Matrix of size \f$L\times 6\f$ where each row is a section \f$[b_0, b_1, b_2, a_0, a_1, a_2]\f$.
+ * \param w Normalized angular frequencies in rad/sample.
+ * \param[out] h Frequency response, of the size of w.
+ */
+template <typename T>
+void freqz(const matX_t<T>& sos, const Eigen::Ref<const vectX_t<internal::non_deduced_t<T>>>& w, Eigen::Ref<vectXc_t<internal::non_deduced_t<T>>> h)
+{
+    Expects(sos.rows() > 0 && sos.cols() == 6);
+    Expects(h.size() == w.size());
+    const vectXc_t<T> zInv = details::unitDelays<T>(w);
+    vectXc_t<T> section(w.size());
+    h.setOnes();
+    for (Eigen::Index i = 0; i < sos.rows(); ++i) {
+        details::frequencyResponse<T>(sos.row(i).tail(3).transpose(), sos.row(i).head(3).transpose(), zInv, section);
+        h.array() *= section.array();
+    }
+}
+
+/*! \brief Compute the unwrapped phase response of a filter.
+ *
+ * The phase is unwrapped along w, which must be sorted and dense enough for the phase to change by less than \f$\pi\f$ between two frequencies.
+ * \param filter Initialized filter.
+ * \param w Normalized angular frequencies in rad/sample.
+ * \param[out] phase Phase in rad, of the size of w.
+ * \see https://www.mathworks.com/help/signal/ref/phasez.html
+ */
+template <typename T, typename Derived>
+void phasez(const BaseFilter<T, Derived>& filter, const Eigen::Ref<const vectX_t<internal::non_deduced_t<T>>>& w, Eigen::Ref<vectX_t<internal::non_deduced_t<T>>> phase)
+{
+    Expects(phase.size() == w.size());
+    vectXc_t<T> h(w.size());
+    freqz(filter, w, h);
+    phase = h.array().arg().matrix();
+    details::unwrap<T>(phase);
+}
+
+/*! \brief Compute the unwrapped phase response of second-order sections.
+ * \see phasez(const BaseFilter<T, Derived>&, const Eigen::Ref<const vectX_t<T>>&, Eigen::Ref<vectX_t<T>>)
+ * \param sos Matrix of size \f$L\times 6\f$ where each row is a section \f$[b_0, b_1, b_2, a_0, a_1, a_2]\f$.
+ * \param w Normalized angular frequencies in rad/sample.
+ * \param[out] phase Phase in rad, of the size of w.
+ */
+template <typename T>
+void phasez(const matX_t<T>& sos, const Eigen::Ref<const vectX_t<internal::non_deduced_t<T>>>& w, Eigen::Ref<vectX_t<internal::non_deduced_t<T>>> phase)
+{
+    Expects(phase.size() == w.size());
+    vectXc_t<T> h(w.size());
+    freqz(sos, w, h);
+    phase = h.array().arg().matrix();
+    details::unwrap<T>(phase);
+}
+
+/*! \brief Compute the group delay of a filter.
+ *
+ * The group delay \f$-d\phi/d\omega\f$ is computed exactly from the coefficients,
+ * as \f$\Re\left(\frac{\sum_k k b_k e^{-jk\omega}}{\sum_k b_k e^{-jk\omega}}\right) - \Re\left(\frac{\sum_k k a_k e^{-jk\omega}}{\sum_k a_k e^{-jk\omega}}\right)\f$.
+ * It is set to 0 at the zeros of the numerator on the unit circle, where it is not defined.
+ * \param filter Initialized filter.
+ * \param w Normalized angular frequencies in rad/sample.
+ * \param[out] delay Group delay in samples, of the size of w.
+ * \see https://www.mathworks.com/help/signal/ref/grpdelay.html
+ */
+template <typename T, typename Derived>
+void grpdelay(const BaseFilter<T, Derived>& filter, const Eigen::Ref<const vectX_t<internal::non_deduced_t<T>>>& w, Eigen::Ref<vectX_t<internal::non_deduced_t<T>>> delay)
+{
+    Expects(filter.isInitialized());
+    Expects(delay.size() == w.size());
+    const vectXc_t<T> zInv = details::unitDelays<T>(w);
+    vectX_t<T> aDelay(w.size());
+    details::polynomeDelay<T>(filter.bCoeff(), zInv, delay);
+    details::polynomeDelay<T>(filter.aCoeff(), zInv, aDelay);
+    delay -= aDelay;
+}
+
+/*! \brief Compute the group delay of second-order sections, the sum of the delays of the sections.
+ * \see grpdelay(const BaseFilter<T, Derived>&, const Eigen::Ref<const vectX_t<T>>&, Eigen::Ref<vectX_t<T>>)
+ * \param sos Matrix of size \f$L\times 6\f$ where each row is a section \f$[b_0, b_1, b_2, a_0, a_1, a_2]\f$.
+ * \param w Normalized angular frequencies in rad/sample.
+ * \param[out] delay Group delay in samples, of the size of w.
+ */
+template <typename T>
+void grpdelay(const matX_t<T>& sos, const Eigen::Ref<const vectX_t<internal::non_deduced_t<T>>>& w, Eigen::Ref<vectX_t<internal::non_deduced_t<T>>> delay)
+{
+    Expects(sos.rows() > 0 && sos.cols() == 6);
+    Expects(delay.size() == w.size());
+    const vectXc_t<T> zInv = details::unitDelays<T>(w);
+    vectX_t<T> bDelay(w.size());
+    vectX_t<T> aDelay(w.size());
+    delay.setZero();
+    for (Eigen::Index i = 0; i < sos.rows(); ++i) {
+        details::polynomeDelay<T>(sos.row(i).head(3).transpose(), zInv, bDelay);
+        details::polynomeDelay<T>(sos.row(i).tail(3).transpose(), zInv, aDelay);
+        delay += bDelay - aDelay;
+    }
+}
+
+} // namespace difi
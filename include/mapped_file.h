@@ -0,0 +1,190 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include "gsl/gsl_assert.h"
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DIFI_HAS_MMAP 1
+#else
+#define DIFI_HAS_MMAP 0
+#endif
+
+namespace difi {
+
+namespace details {
+
+/*! \brief Read-only view of a whole file.
+ *
+ * The file is memory-mapped on POSIX systems, so nothing is read before it is used.
+ * On other systems it is read into a buffer aligned on 64 bytes.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    /*! \brief Map a file.
+     * \param path Path of the file.
+     */
+    explicit MappedFile(const std::string& path)
+    {
+#if DIFI_HAS_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        Expects(fd >= 0);
+        struct stat st;
+        const bool isStat = ::fstat(fd, &st) == 0;
+        if (!isStat)
+            ::close(fd);
+        Expects(isStat);
+        m_size = static_cast<std::size_t>(st.st_size);
+        if (m_size > 0) {
+            void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            Expects(data != MAP_FAILED);
+            m_data = static_cast<const std::byte*>(data);
+        } else {
+            ::close(fd);
+        }
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        Expects(file.good());
+        m_size = static_cast<std::size_t>(file.tellg());
+        m_buffer.reset(new Line[(m_size + sizeof(Line) - 1) / sizeof(Line)]);
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(m_buffer.get()), static_cast<std::streamsize>(m_size));
+        Expects(file.good());
+        m_data = reinterpret_cast<const std::byte*>(m_buffer.get());
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { swap(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        MappedFile tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+    ~MappedFile() noexcept
+    {
+#if DIFI_HAS_MMAP
+        if (m_data)
+            ::munmap(const_cast<std::byte*>(m_data), m_size);
+#endif
+    }
+
+    const std::byte* data() const noexcept { return m_data; }
+    std::size_t size() const noexcept { return m_size; }
+
+private:
+    void swap(MappedFile& other) noexcept
+    {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+#if !DIFI_HAS_MMAP
+        std::swap(m_buffer, other.m_buffer);
+#endif
+    }
+
+private:
+    const std::byte* m_data = nullptr;
+    std::size_t m_size = 0;
+#if !DIFI_HAS_MMAP
+    struct alignas(64) Line {
+        std::byte bytes[64];
+    };
+    std::unique_ptr<Line[]> m_buffer;
+#endif
+};
+
+/*! \brief Writable file of a fixed size.
+ *
+ * The file is memory-mapped on POSIX systems, so the data are written in place.
+ * On other systems they are written from a buffer when the file is closed.
+ */
+class MappedOutputFile {
+public:
+    /*! \brief Create or truncate a file and map it.
+     * \param path Path of the file.
+     * \param size Size of the file.
+     */
+    MappedOutputFile(const std::string& path, std::size_t size)
+        : m_size(size)
+    {
+#if DIFI_HAS_MMAP
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        Expects(fd >= 0);
+        const bool isResized = ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+        void* data = isResized && size > 0 ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : nullptr;
+        ::close(fd);
+        Expects(isResized && data != MAP_FAILED);
+        m_data = static_cast<std::byte*>(data);
+#else
+        m_path = path;
+        m_buffer.reset(new Line[(size + sizeof(Line) - 1) / sizeof(Line)]);
+        m_data = reinterpret_cast<std::byte*>(m_buffer.get());
+#endif
+    }
+    MappedOutputFile(const MappedOutputFile&) = delete;
+    MappedOutputFile& operator=(const MappedOutputFile&) = delete;
+    ~MappedOutputFile() noexcept
+    {
+#if DIFI_HAS_MMAP
+        if (m_data)
+            ::munmap(m_data, m_size);
+#else
+        std::ofstream file(m_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(m_data), static_cast<std::streamsize>(m_size));
+#endif
+    }
+
+    std::byte* data() noexcept { return m_data; }
+    std::size_t size() const noexcept { return m_size; }
+
+private:
+    std::byte* m_data = nullptr;
+    std::size_t m_size = 0;
+#if !DIFI_HAS_MMAP
+    struct alignas(64) Line {
+        std::byte bytes[64];
+    };
+    std::string m_path;
+    std::unique_ptr<Line[]> m_buffer;
+#endif
+};
+
+} // namespace details
+
+} // namespace difi
@@ -46,6 +46,12 @@ constexpr T Binomial(int n, int k)
         return Binomial<T>(n - 1, k) * n / (n - k);
 }
 
+template <typename T>
+constexpr T Factorial(int n)
+{
+    return n <= 1 ? T(1) : T(n) * Factorial<T>(n - 1);
+}
+
 template <typename T>
 constexpr T pow(T n, T k)
 {
@@ -27,9 +27,17 @@
 
 #pragma once
 
+#include "fft.h"
+#include "gsl/gsl_assert.h"
 #include "type_checks.h"
 #include "typedefs.h"
+#include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <cmath>
 #include <complex>
+#include <limits>
+#include <utility>
+#include <vector>
 
 namespace difi {
 
@@ -64,4 +72,306 @@ vectX_t<T> VietaAlgo<T>::polyCoeffFromRoot(const vectX_t<T>& roots)
     return coeffs;
 }
 
+namespace details {
+
+// Direct convolution of two sets of coefficients.
+template <typename T>
+vectX_t<T> convolve(const vectX_t<T>& p, const vectX_t<T>& q)
+{
+    vectX_t<T> result = vectX_t<T>::Zero(p.size() + q.size() - 1);
+    for (Eigen::Index i = 0; i < p.size(); ++i)
+        result.segment(i, q.size()) += p(i) * q;
+    return result;
+}
+
+} // namespace details
+
+/*! \brief Multiply two polynomes.
+ *
+ * The product is the convolution of the coefficients. Long polynomes (e.g. long FIR filters) are multiplied through an FFT,
+ * in \f$O((n+m)\log(n+m))\f$ instead of \f$O(nm)\f$.
+ * \param p Coefficients of the first polynome, in decreasing order.
+ * \param q Coefficients of the second polynome, in decreasing order.
+ * \return Coefficients of the product, in decreasing order.
+ */
+template <typename T>
+vectX_t<T> polyMultiply(const vectX_t<T>& p, const vectX_t<T>& q)
+{
+    using real_t = internal::complex_sub_type_t<T>;
+    static_assert(std::is_floating_point<real_t>::value, "This function can only accept floating types or complex.");
+    constexpr Eigen::Index FFT_THRESHOLD = 64;
+    Expects(p.size() > 0 && q.size() > 0);
+    const Eigen::Index size = p.size() + q.size() - 1;
+
+    if (std::min(p.size(), q.size()) < FFT_THRESHOLD)
+        return details::convolve(p, q);
+
+    const size_t n = details::nextPowerOfTwo(static_cast<size_t>(size));
+    std::vector<std::complex<real_t>> fp(n);
+    std::vector<std::complex<real_t>> fq(n);
+    std::copy(p.data(), p.data() + p.size(), fp.begin());
+    std::copy(q.data(), q.data() + q.size(), fq.begin());
+    details::fft(fp, false);
+    details::fft(fq, false);
+    for (size_t i = 0; i < n; ++i)
+        fp[i] = details::multiply(fp[i], fq[i]);
+    details::fft(fp, true);
+
+    vectX_t<T> result(size);
+    for (Eigen::Index i = 0; i < size; ++i) {
+        if constexpr (internal::is_complex<T>::value)
+            result(i) = fp[static_cast<size_t>(i)];
+        else
+            result(i) = fp[static_cast<size_t>(i)].real();
+    }
+    return result;
+}
+
+/*! \brief Divide two polynomes.
+ *
+ * Compute \f$q\f$ and \f$r\f$ such that \f$num = q\times den + r\f$ with \f$\deg r < \deg den\f$.
+ * \param num Coefficients of the numerator, in decreasing order.
+ * \param den Coefficients of the denominator, in decreasing order. The first one must not be 0.
+ * \param[out] quotient Coefficients of the quotient, in decreasing order.
+ * \param[out] remainder Coefficients of the remainder, in decreasing order, of the size of den minus one (or one if den is a constant).
+ */
+template <typename T>
+void polyDivide(const vectX_t<T>& num, const vectX_t<T>& den, vectX_t<T>& quotient, vectX_t<T>& remainder)
+{
+    Expects(num.size() > 0 && den.size() > 0);
+    Expects(den(0) != T(0));
+    if (num.size() < den.size()) {
+        quotient = vectX_t<T>::Zero(1);
+        remainder = vectX_t<T>::Zero(std::max<Eigen::Index>(1, den.size() - 1));
+        remainder.tail(num.size()) = num;
+        return;
+    }
+
+    vectX_t<T> r = num;
+    quotient.resize(num.size() - den.size() + 1);
+    for (Eigen::Index i = 0; i < quotient.size(); ++i) {
+        quotient(i) = r(i) / den(0);
+        r.segment(i, den.size()) -= quotient(i) * den;
+    }
+    if (den.size() > 1)
+        remainder = r.tail(den.size() - 1);
+    else
+        remainder = vectX_t<T>::Zero(1);
+}
+
+/*! \brief Find the roots of a polynome.
+ *
+ * The roots are the eigenvalues of the companion matrix of the polynome.
+ * As the polynome is real, complex roots come in exact conjugate pairs.
+ * \param coeffs Coefficients of the polynome, in decreasing order. The first one must not be 0.
+ * \return Roots of the polynome.
+ */
+template <typename T>
+vectXc_t<T> polyRoots(const vectX_t<T>& coeffs)
+{
+    static_assert(std::is_floating_point<T>::value, "This function can only accept floating types.");
+    Expects(coeffs.size() > 0);
+    Expects(coeffs(0) != T(0));
+
+    // Trailing zeros are roots at 0
+    Eigen::Index degree = coeffs.size() - 1;
+    Eigen::Index nrZeros = 0;
+    while (degree - nrZeros > 0 && coeffs(degree - nrZeros) == T(0))
+        ++nrZeros;
+    const Eigen::Index n = degree - nrZeros;
+
+    vectXc_t<T> roots = vectXc_t<T>::Zero(degree);
+    if (n == 0)
+        return roots;
+
+    matX_t<T> companion = matX_t<T>::Zero(n, n);
+    companion.row(0) = -coeffs.segment(1, n).transpose() / coeffs(0);
+    companion.diagonal(-1).setOnes();
+    Eigen::EigenSolver<matX_t<T>> solver(companion, false);
+    Expects(solver.info() == Eigen::Success);
+    roots.head(n) = solver.eigenvalues();
+    return roots;
+}
+
+namespace details {
+
+// Real factor of order 1 or 2 of a polynome built from a root (and its conjugate).
+template <typename T>
+struct RealFactor {
+    std::complex<T> root; // Representative root of the factor
+    T c1; // Factor is 1 + c1 X^-1 + c2 X^-2
+    T c2;
+};
+
+// Group conjugate roots into real factors.
+template <typename T>
+std::vector<RealFactor<T>> realFactors(const vectXc_t<T>& roots)
+{
+    const T tol = std::sqrt(std::numeric_limits<T>::epsilon());
+    std::vector<RealFactor<T>> factors;
+    std::vector<T> reals;
+    Eigen::Index nrPositive = 0;
+    Eigen::Index nrNegative = 0;
+    for (Eigen::Index i = 0; i < roots.size(); ++i) {
+        const std::complex<T>& r = roots(i);
+        if (std::abs(r.imag()) <= tol * std::max(T(1), std::abs(r))) {
+            reals.push_back(r.real());
+        } else if (r.imag() > T(0)) {
+            factors.push_back({ r, T(-2) * r.real(), std::norm(r) });
+            ++nrPositive;
+        } else {
+            ++nrNegative;
+        }
+    }
+    Expects(nrPositive == nrNegative); // Roots must come in conjugate pairs
+
+    std::sort(reals.begin(), reals.end());
+    for (size_t i = 0; i + 1 < reals.size(); i += 2)
+        factors.push_back({ std::complex<T>(reals[i + 1]), -(reals[i] + reals[i + 1]), reals[i] * reals[i + 1] });
+    if (reals.size() % 2 == 1)
+        factors.push_back({ std::complex<T>(reals.back()), -reals.back(), T(0) });
+
+    return factors;
+}
+
+} // namespace details
+
+/*! \brief Compute real polynome coefficients from conjugate roots.
+ *
+ * Same as VietaAlgo<std::complex<T>>::polyCoeffFromRoot followed by taking the real part, but in real arithmetic only.
+ * Each pair of conjugate roots gives a real factor \f$X^2 - 2\Re(p)X + |p|^2\f$.
+ * Up to 8 roots, the factors are multiplied in place into the result, whose vector is the only allocation.
+ * Above, they are multiplied pairwise in a balanced product tree between two buffers:
+ * the tree keeps the intermediate polynomes of similar degrees, which limits the rounding errors for high orders.
+ * \note The function return the coefficients in the decreasing order: \f$a_n X^n + a_{n-1}X^{n-1} + ... + a1X + a0\f$.
+ * \param roots Set of all roots of the polynome. Complex roots must come in conjugate pairs.
+ * \return Coefficients of the polynome.
+ */
+template <typename T>
+vectX_t<T> polyCoeffFromConjugateRoots(const vectXc_t<T>& roots)
+{
+    static_assert(std::is_floating_point<T>::value, "This function can only accept floating types.");
+    // Same test as details::realFactors, on squares to avoid the square roots
+    auto isReal = [](const std::complex<T>& r) { return r.imag() * r.imag() <= std::numeric_limits<T>::epsilon() * std::max(T(1), std::norm(r)); };
+    Eigen::Index nrPositive = 0;
+    Eigen::Index nrNegative = 0;
+    for (Eigen::Index i = 0; i < roots.size(); ++i) {
+        if (!isReal(roots(i)))
+            ++(roots(i).imag() > T(0) ? nrPositive : nrNegative);
+    }
+    Expects(nrPositive == nrNegative); // Roots must come in conjugate pairs
+
+    constexpr Eigen::Index TREE_MIN_ROOTS = 8;
+    if (roots.size() <= TREE_MIN_ROOTS) {
+        vectX_t<T> coeffs = vectX_t<T>::Zero(roots.size() + 1);
+        coeffs(0) = T(1);
+        Eigen::Index degree = 0;
+        for (Eigen::Index i = 0; i < roots.size(); ++i) {
+            const std::complex<T>& r = roots(i);
+            if (isReal(r)) {
+                // Multiply by X - r
+                const T c1 = -r.real();
+                ++degree;
+                for (Eigen::Index k = degree; k > 0; --k)
+                    coeffs(k) += c1 * coeffs(k - 1);
+            } else if (r.imag() > T(0)) {
+                // Multiply by X^2 - 2Re(r)X + |r|^2
+                const T c1 = T(-2) * r.real();
+                const T c2 = std::norm(r);
+                degree += 2;
+                for (Eigen::Index k = degree; k > 1; --k)
+                    coeffs(k) += c1 * coeffs(k - 1) + c2 * coeffs(k - 2);
+                coeffs(1) += c1 * coeffs(0);
+            }
+        }
+        return coeffs;
+    }
+
+    // The polynomes of a level of the tree are stored side by side with their leading 1.
+    // A polynome of degree d has d + 1 coefficients, so the first level holds at most twice the number of roots.
+    std::vector<Eigen::Index> degrees;
+    degrees.reserve(static_cast<size_t>(roots.size()));
+    vectX_t<T> level(2 * roots.size());
+    vectX_t<T> next(2 * roots.size());
+    Eigen::Index pos = 0;
+    for (Eigen::Index i = 0; i < roots.size(); ++i) {
+        const std::complex<T>& r = roots(i);
+        if (isReal(r)) {
+            level.segment(pos, 2) << T(1), -r.real();
+            pos += 2;
+            degrees.push_back(1);
+        } else if (r.imag() > T(0)) {
+            level.segment(pos, 3) << T(1), T(-2) * r.real(), std::norm(r);
+            pos += 3;
+            degrees.push_back(2);
+        }
+    }
+
+    while (degrees.size() > 1) {
+        Eigen::Index in = 0;
+        Eigen::Index out = 0;
+        size_t count = 0;
+        for (size_t i = 0; i < degrees.size(); i += 2) {
+            const Eigen::Index p = degrees[i] + 1;
+            if (i + 1 == degrees.size()) {
+                next.segment(out, p) = level.segment(in, p);
+                degrees[count++] = degrees[i];
+                break;
+            }
+
+            const Eigen::Index q = degrees[i + 1] + 1;
+            next.segment(out, p + q - 1).setZero();
+            for (Eigen::Index k = 0; k < p; ++k)
+                next.segment(out + k, q) += level(in + k) * level.segment(in + p, q);
+            in += p + q;
+            out += p + q - 1;
+            degrees[count++] = p + q - 2;
+        }
+        degrees.resize(count);
+        level.swap(next);
+    }
+    return level.head(roots.size() + 1);
+}
+
+/*! \brief Convert a zero-pole-gain representation into second-order sections.
+ *
+ * Conjugate roots are grouped into real second-order factors.
+ * Sections are ordered with the poles farthest from the unit circle first, and each pole pair is matched with its closest zeros.
+ * The gain is applied to the first section.
+ * \see https://www.mathworks.com/help/signal/ref/zp2sos.html
+ * \param zeros Zeros of the filter. Complex zeros must come in conjugate pairs.
+ * \param poles Poles of the filter. Complex poles must come in conjugate pairs.
+ * \param gain Gain of the filter.
+ * \return Matrix of size \f$L\times 6\f$ where each row is a section \f$[b_0, b_1, b_2, 1, a_1, a_2]\f$.
+ */
+template <typename T>
+matX_t<T> zpkToSOS(const vectXc_t<T>& zeros, const vectXc_t<T>& poles, T gain)
+{
+    using details::RealFactor;
+    std::vector<RealFactor<T>> pFactors = details::realFactors(poles);
+    std::vector<RealFactor<T>> zFactors = details::realFactors(zeros);
+    const size_t nrSections = std::max<size_t>(1, std::max(pFactors.size(), zFactors.size()));
+    pFactors.resize(nrSections, RealFactor<T>{ std::complex<T>(0), T(0), T(0) });
+
+    std::stable_sort(pFactors.begin(), pFactors.end(), [](const RealFactor<T>& lhs, const RealFactor<T>& rhs) { return std::abs(lhs.root) < std::abs(rhs.root); });
+
+    // Match the poles closest to the unit circle first
+    std::vector<RealFactor<T>> zMatched(nrSections, RealFactor<T>{ std::complex<T>(0), T(0), T(0) });
+    for (size_t i = nrSections; i-- > 0 && !zFactors.empty();) {
+        auto closest = std::min_element(zFactors.begin(), zFactors.end(), [&p = pFactors[i].root](const RealFactor<T>& lhs, const RealFactor<T>& rhs) {
+            return std::abs(lhs.root - p) < std::abs(rhs.root - p);
+        });
+        zMatched[i] = *closest;
+        zFactors.erase(closest);
+    }
+
+    matX_t<T> sos(nrSections, 6);
+    for (size_t i = 0; i < nrSections; ++i) {
+        const auto row = static_cast<Eigen::Index>(i);
+        sos.row(row) << T(1), zMatched[i].c1, zMatched[i].c2, T(1), pFactors[i].c1, pFactors[i].c2;
+    }
+    sos.row(0).head(3) *= gain;
+    return sos;
+}
+
 } // namespace difi
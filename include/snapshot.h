@@ -0,0 +1,380 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#pragma once
+
+#include "buffer.h"
+#include "gsl/gsl_assert.h"
+#include "typedefs.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace difi {
+
+/*! \brief Version of the binary snapshot format. */
+constexpr const std::uint16_t SNAPSHOT_VERSION = 1;
+
+/*! \brief Header of a binary snapshot.
+ *
+ * The header is followed by the payload: the fields of the filter, each one padded to 8 bytes.
+ * Arrays are stored as their number of elements followed by the elements.
+ * The data are stored in the byte order of the machine, which is recorded in the header.
+ */
+struct SnapshotHeader {
+    char magic[4]; /*!< "DIFI" */
+    std::uint16_t version; /*!< Version of the format */
+    std::uint8_t littleEndian; /*!< 1 if the data are little-endian */
+    std::uint8_t reserved; /*!< Zero */
+    std::uint64_t layout; /*!< Fingerprint of the kind and of the size of each field */
+    std::uint64_t payloadSize; /*!< Size of the payload in bytes */
+    std::uint64_t checksum; /*!< FNV-1a hash of the payload */
+};
+
+static_assert(sizeof(SnapshotHeader) == 32 && std::is_trivially_copyable<SnapshotHeader>::value, "The snapshot header must be packed.");
+
+namespace details {
+
+constexpr const std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+constexpr const std::uint64_t FNV_PRIME = 1099511628211ull;
+
+inline std::uint64_t fnv1a(const std::byte* data, std::size_t size, std::uint64_t hash = FNV_OFFSET) noexcept
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<std::uint64_t>(data[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+inline bool isLittleEndian() noexcept
+{
+    const std::uint16_t one = 1;
+    std::uint8_t first;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+constexpr std::size_t paddedSize(std::size_t size) noexcept { return (size + 7) & ~std::size_t(7); }
+
+template <typename U>
+using is_snapshot_scalar = std::integral_constant<bool, std::is_trivially_copyable<U>::value && !std::is_base_of<Eigen::EigenBase<U>, U>::value>;
+
+/*! \brief Archive that writes the fields of a filter.
+ *
+ * Without output buffer, it only measures the size and the layout of the payload.
+ */
+class SnapshotWriter {
+public:
+    static constexpr const bool IsLoading = false;
+
+    SnapshotWriter() = default;
+    SnapshotWriter(std::byte* data, std::size_t capacity) noexcept
+        : m_data(data)
+        , m_capacity(capacity)
+    {}
+
+    template <typename U, typename = std::enable_if_t<is_snapshot_scalar<U>::value>>
+    void operator()(const U& value) noexcept
+    {
+        addField(0, sizeof(U));
+        write(&value, sizeof(U));
+    }
+    template <typename U>
+    void operator()(const Buffer<U>& buffer) noexcept { writeArray(buffer.data(), buffer.size()); }
+    template <typename Derived>
+    void operator()(const Eigen::PlainObjectBase<Derived>& m) noexcept { writeArray(m.data(), m.size()); }
+    template <typename U, int Options, typename Stride>
+    void operator()(const Eigen::Map<const vectX_t<U>, Options, Stride>& m) noexcept { writeArray(m.data(), m.size()); }
+
+    std::size_t size() const noexcept { return m_size; }
+    std::uint64_t layout() const noexcept { return m_layout; }
+
+private:
+    template <typename U>
+    void writeArray(const U* data, Eigen::Index size) noexcept
+    {
+        addField(1, sizeof(U));
+        const std::int64_t count = size;
+        write(&count, sizeof(count));
+        write(data, static_cast<std::size_t>(size) * sizeof(U));
+    }
+    void addField(std::uint64_t kind, std::size_t elementSize) noexcept
+    {
+        const std::uint64_t field[2] = { kind, elementSize };
+        m_layout = fnv1a(reinterpret_cast<const std::byte*>(field), sizeof(field), m_layout);
+    }
+    void write(const void* data, std::size_t size) noexcept
+    {
+        const std::size_t padded = paddedSize(size);
+        if (m_data && m_size + padded <= m_capacity) {
+            if (size > 0)
+                std::memcpy(m_data + m_size, data, size);
+            std::memset(m_data + m_size + size, 0, padded - size);
+        }
+        m_size += padded;
+    }
+
+private:
+    std::byte* m_data = nullptr;
+    std::size_t m_capacity = 0;
+    std::size_t m_size = 0;
+    std::uint64_t m_layout = FNV_OFFSET;
+};
+
+/*! \brief Archive that restores the fields of a filter from a validated payload.
+ *
+ * Buffers keep their storage if their size is unchanged, so restoring into a filter of the same design does not allocate.
+ */
+class SnapshotReader {
+public:
+    static constexpr const bool IsLoading = true;
+
+    SnapshotReader(const std::byte* data, std::size_t size) noexcept
+        : m_data(data)
+        , m_size(size)
+    {}
+
+    template <typename U, typename = std::enable_if_t<is_snapshot_scalar<U>::value>>
+    void operator()(U& value)
+    {
+        read(&value, sizeof(U));
+    }
+    template <typename U>
+    void operator()(Buffer<U>& buffer)
+    {
+        const Eigen::Index size = readCount<U>();
+        buffer.resize(size);
+        read(buffer.data(), static_cast<std::size_t>(size) * sizeof(U));
+    }
+    template <typename Derived>
+    void operator()(Eigen::PlainObjectBase<Derived>& m)
+    {
+        const Eigen::Index size = readCount<typename Derived::Scalar>();
+        Expects(size == m.size());
+        read(m.data(), static_cast<std::size_t>(size) * sizeof(typename Derived::Scalar));
+    }
+    /*! \brief Return a view on an array of the payload, without copy. */
+    template <typename U>
+    Eigen::Map<const vectX_t<U>> array()
+    {
+        const Eigen::Index size = readCount<U>();
+        const std::size_t bytes = paddedSize(static_cast<std::size_t>(size) * sizeof(U));
+        Expects(bytes <= m_size - m_pos);
+        const U* data = reinterpret_cast<const U*>(m_data + m_pos);
+        m_pos += bytes;
+        return { data, size };
+    }
+
+    bool atEnd() const noexcept { return m_pos == m_size; }
+
+private:
+    template <typename U>
+    Eigen::Index readCount()
+    {
+        std::int64_t count;
+        read(&count, sizeof(count));
+        Expects(count >= 0 && static_cast<std::uint64_t>(count) <= (m_size - m_pos) / sizeof(U));
+        return static_cast<Eigen::Index>(count);
+    }
+    void read(void* data, std::size_t size)
+    {
+        const std::size_t padded = paddedSize(size);
+        Expects(padded <= m_size - m_pos);
+        if (size > 0)
+            std::memcpy(data, m_data + m_pos, size);
+        m_pos += padded;
+    }
+
+private:
+    const std::byte* m_data;
+    std::size_t m_size;
+    std::size_t m_pos = 0;
+};
+
+/*! \brief Archive that compares a validated payload to the fields of a filter, without modifying it.
+ *
+ * It throws if a fixed-size field of the filter can't hold the saved one,
+ * and records whether every array of the payload has the size of the corresponding field.
+ */
+class SnapshotChecker {
+public:
+    static constexpr const bool IsLoading = false;
+
+    SnapshotChecker(const std::byte* data, std::size_t size) noexcept
+        : m_reader(data, size)
+    {}
+
+    template <typename U, typename = std::enable_if_t<is_snapshot_scalar<U>::value>>
+    void operator()(const U&)
+    {
+        U value;
+        m_reader(value);
+    }
+    template <typename U>
+    void operator()(const Buffer<U>& buffer) { compareArray<U>(buffer.size()); }
+    template <typename Derived>
+    void operator()(const Eigen::PlainObjectBase<Derived>& m)
+    {
+        // Eigen objects are restored in place, they can't be resized
+        Expects(m_reader.template array<typename Derived::Scalar>().size() == m.size());
+    }
+    template <typename U, int Options, typename Stride>
+    void operator()(const Eigen::Map<const vectX_t<U>, Options, Stride>& m) { compareArray<U>(m.size()); }
+
+    bool atEnd() const noexcept { return m_reader.atEnd(); }
+    /*! \brief Return true if every array of the payload has the size of the corresponding field of the filter. */
+    bool isSameShape() const noexcept { return m_isSameShape; }
+
+private:
+    template <typename U>
+    void compareArray(Eigen::Index size)
+    {
+        if (m_reader.template array<U>().size() != size)
+            m_isSameShape = false;
+    }
+
+private:
+    SnapshotReader m_reader;
+    bool m_isSameShape = true;
+};
+
+} // namespace details
+
+/*! \brief Return the size in bytes of the snapshot of a filter.
+ * \param filter Filter.
+ */
+template <typename Filter>
+std::size_t snapshotSize(const Filter& filter)
+{
+    details::SnapshotWriter measure;
+    // serialize only reads the filter when it saves it
+    const_cast<Filter&>(filter).serialize(measure);
+    return sizeof(SnapshotHeader) + measure.size();
+}
+
+/*! \brief Save the coefficients and the data history of a filter into a preallocated buffer.
+ *
+ * It neither allocates nor locks, and it costs a copy of the filter data.
+ * A filter can thus be snapshot between two calls to stepFilter, at the sampling rate,
+ * and the buffer handed over to another thread (e.g. with double buffering).
+ * \param filter Initialized filter.
+ * \param data Output buffer, aligned on 8 bytes.
+ * \param capacity Size of the output buffer. It must be at least snapshotSize(filter).
+ * \return Number of bytes written.
+ */
+template <typename Filter>
+std::size_t saveSnapshot(const Filter& filter, void* data, std::size_t capacity)
+{
+    Expects(filter.isInitialized());
+    Expects(capacity >= sizeof(SnapshotHeader));
+    auto* bytes = static_cast<std::byte*>(data);
+    details::SnapshotWriter writer(bytes + sizeof(SnapshotHeader), capacity - sizeof(SnapshotHeader));
+    const_cast<Filter&>(filter).serialize(writer);
+    Expects(sizeof(SnapshotHeader) + writer.size() <= capacity);
+
+    SnapshotHeader header = { { 'D', 'I', 'F', 'I' }, SNAPSHOT_VERSION, static_cast<std::uint8_t>(details::isLittleEndian()), 0,
+        writer.layout(), writer.size(), details::fnv1a(bytes + sizeof(SnapshotHeader), writer.size()) };
+    std::memcpy(bytes, &header, sizeof(header));
+    return sizeof(SnapshotHeader) + writer.size();
+}
+
+/*! \brief Save the coefficients and the data history of a filter.
+ * \param filter Initialized filter.
+ * \return Snapshot of the filter.
+ */
+template <typename Filter>
+std::vector<std::byte> saveSnapshot(const Filter& filter)
+{
+    std::vector<std::byte> snapshot(snapshotSize(filter));
+    saveSnapshot(filter, snapshot.data(), snapshot.size());
+    return snapshot;
+}
+
+/*! \brief Restore a filter from a snapshot.
+ *
+ * The snapshot is fully validated (format, version, byte order, layout of the filter and checksum) before the filter is modified,
+ * and the filter is left unchanged if the snapshot can't be restored.
+ * If every array of the snapshot has the size of the corresponding field of the filter, the data are copied directly into its storage
+ * and no memory is allocated. Otherwise the snapshot is restored into a copy of the filter, which then replaces it.
+ * Filters that can't be copied, e.g. a HotSwapFilter or a StreamingFilterStage, are only restored from snapshots of the same shape.
+ * Filters sharing coefficients keep sharing them if the snapshot has the same coefficients.
+ * \param filter Filter of the same kind as the saved one. It does not need to be initialized.
+ * \param data Snapshot, aligned on 8 bytes.
+ * \param size Size of the snapshot.
+ */
+template <typename Filter>
+void restoreSnapshot(Filter& filter, const void* data, std::size_t size)
+{
+    Expects(size >= sizeof(SnapshotHeader));
+    const auto* bytes = static_cast<const std::byte*>(data);
+    SnapshotHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    Expects(std::memcmp(header.magic, "DIFI", 4) == 0);
+    Expects(header.version == SNAPSHOT_VERSION);
+    Expects(header.littleEndian == static_cast<std::uint8_t>(details::isLittleEndian()));
+    Expects(header.payloadSize == size - sizeof(SnapshotHeader));
+    Expects(header.checksum == details::fnv1a(bytes + sizeof(SnapshotHeader), header.payloadSize));
+
+    details::SnapshotWriter measure;
+    filter.serialize(measure);
+    Expects(header.layout == measure.layout());
+
+    // Dry run: the sizes of the saved fields are compared to the filter before anything is written
+    details::SnapshotChecker checker(bytes + sizeof(SnapshotHeader), header.payloadSize);
+    filter.serialize(checker);
+    Expects(checker.atEnd());
+
+    details::SnapshotReader reader(bytes + sizeof(SnapshotHeader), header.payloadSize);
+    if constexpr (std::is_copy_constructible<Filter>::value) {
+        if (checker.isSameShape()) {
+            filter.serialize(reader);
+        } else {
+            Filter restored(filter);
+            restored.serialize(reader);
+            filter = std::move(restored);
+        }
+    } else {
+        Expects(checker.isSameShape());
+        filter.serialize(reader);
+    }
+}
+
+/*! \brief Restore a filter from a snapshot.
+ * \param filter Filter of the same kind as the saved one.
+ * \param snapshot Snapshot.
+ */
+template <typename Filter>
+void restoreSnapshot(Filter& filter, const std::vector<std::byte>& snapshot)
+{
+    restoreSnapshot(filter, snapshot.data(), snapshot.size());
+}
+
+} // namespace difi
@@ -0,0 +1,136 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+#pragma once
+
+#include "buffer.h"
+#include "gsl/gsl_assert.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+namespace difi {
+
+/*! \brief Lock-free single-producer single-consumer ring buffer.
+ *
+ * One thread pushes and one other thread pops, without lock nor allocation, so that a real-time producer is never blocked.
+ * The producer and the consumer indices live on different cache lines, and each side keeps a copy of the index of the other side
+ * so that the shared index is only read when the ring looks full (or empty).
+ * Batches are copied with at most two contiguous copies.
+ * \tparam T Type of the elements. It must be trivially copyable.
+ */
+template <typename T>
+class alignas(64) SpscRing {
+    static constexpr std::size_t CacheLine = 64;
+
+public:
+    /*! \brief Allocate the ring.
+     * \param capacity Minimum number of elements, rounded up to a power of two.
+     * \param resource Memory resource of the elements.
+     */
+    explicit SpscRing(std::size_t capacity, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_data(resource)
+    {
+        Expects(capacity > 0);
+        std::size_t size = 1;
+        while (size < capacity)
+            size *= 2;
+        m_mask = size - 1;
+        m_data.resize(static_cast<Eigen::Index>(size));
+    }
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /*! \brief Push an element (producer thread).
+     * \return False if the ring is full.
+     */
+    bool push(const T& value) noexcept { return push(&value, 1) == 1; }
+    /*! \brief Push as many elements as possible (producer thread).
+     * \return Number of pushed elements.
+     */
+    std::size_t push(const T* values, std::size_t n) noexcept
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (capacity() - (tail - m_cachedHead) < n)
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+        n = std::min(n, capacity() - (tail - m_cachedHead));
+        const std::size_t start = tail & m_mask;
+        const std::size_t first = std::min(n, capacity() - start);
+        std::copy_n(values, first, m_data.data() + start);
+        std::copy_n(values + first, n - first, m_data.data());
+        m_tail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+    /*! \brief Return the number of elements that can be pushed (producer thread). */
+    std::size_t freeSpace() noexcept
+    {
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        return capacity() - (m_tail.load(std::memory_order_relaxed) - m_cachedHead);
+    }
+
+    /*! \brief Pop an element (consumer thread).
+     * \return False if the ring is empty.
+     */
+    bool pop(T& value) noexcept { return pop(&value, 1) == 1; }
+    /*! \brief Pop as many elements as possible (consumer thread).
+     * \return Number of popped elements.
+     */
+    std::size_t pop(T* values, std::size_t n) noexcept
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (m_cachedTail - head < n)
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+        n = std::min(n, m_cachedTail - head);
+        const std::size_t start = head & m_mask;
+        const std::size_t first = std::min(n, capacity() - start);
+        std::copy_n(m_data.data() + start, first, values);
+        std::copy_n(m_data.data(), n - first, values + first);
+        m_head.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    /*! \brief Return the number of elements in the ring. It is only a snapshot when the other thread is running. */
+    std::size_t size() const noexcept
+    {
+        // Head is loaded first so that it can't overtake tail, a push between the loads can only exceed the capacity
+        const std::size_t head = m_head.load(std::memory_order_acquire);
+        const std::size_t tail = m_tail.load(std::memory_order_acquire);
+        return std::min(tail - head, capacity());
+    }
+    /*! \brief Return the maximum number of elements. */
+    std::size_t capacity() const noexcept { return m_mask + 1; }
+
+private:
+    std::size_t m_mask;
+    details::Buffer<T> m_data;
+    alignas(CacheLine) std::atomic<std::size_t> m_head{ 0 }; /*!< Next element to pop, written by the consumer */
+    std::size_t m_cachedTail = 0; /*!< Copy of m_tail owned by the consumer */
+    alignas(CacheLine) std::atomic<std::size_t> m_tail{ 0 }; /*!< Next element to push, written by the producer */
+    std::size_t m_cachedHead = 0; /*!< Copy of m_head owned by the producer */
+};
+
+} // namespace difi
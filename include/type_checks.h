@@ -28,6 +28,7 @@
 #pragma once
 
 #include <complex>
+#include <type_traits>
 
 namespace difi {
 
@@ -54,6 +55,19 @@ namespace internal {
     template <typename T>
     using complex_sub_type_t = typename sub_type<T, is_complex<T>::value>::type;
 
+    template <typename T>
+    struct non_deduced {
+        using type = T;
+    };
+
+    // Exclude a function parameter from template argument deduction
+    template <typename T>
+    using non_deduced_t = typename non_deduced<T>::type;
+
+    // Enable a function taking U&& only for rvalues of type Expected, without implicit conversions
+    template <typename U, typename Expected>
+    using enable_if_rvalue_t = std::enable_if_t<std::is_same<U, Expected>::value>;
+
 } // namespace internal
 
 } // namespace difi
\ No newline at end of file
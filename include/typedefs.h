@@ -28,6 +28,7 @@
 #pragma once
 
 #include <Eigen/Core>
+#include <cstdint>
 
 namespace difi {
 
@@ -43,7 +44,10 @@ using vectN_t = Eigen::Matrix<T, N, 1>; /*!< Fixed Eigen column-vector */
 template <typename T>
 using vectXc_t = vectX_t<std::complex<T>>; /*!< Eigen complex column-vector */
 
-enum class FilterType {
+template <typename T>
+using matX_t = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>; /*!< Eigen column-major matrix */
+
+enum class FilterType : std::uint8_t {
     Backward,
     Centered
 };
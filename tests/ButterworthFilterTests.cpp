@@ -32,6 +32,7 @@
 #include "doctest_helper.h"
 #include "test_functions.h"
 #include "warning_macro.h"
+#include <type_traits>
 
 DISABLE_CONVERSION_WARNING_BEGIN
 
@@ -111,3 +112,59 @@ TEST_CASE_TEMPLATE("Butterworth band-reject filter", T, float, double)
     test_coeffs(s.brACoeffRes, s.brBCoeffRes, bf, std::numeric_limits<T>::epsilon() * T(1e8));
     test_results(s.brResults, s.data, bf, std::numeric_limits<T>::epsilon() * T(1e8));
 }
+
+TEST_CASE_TEMPLATE("Butterworth mixed precision", Accumulator, double, difi::CompensatedSum)
+{
+    System<float> s;
+    auto bf = difi::Butterworth<float, Accumulator>(s.order, s.fc, s.fs);
+    test_results(s.lpResults, s.data, bf, std::numeric_limits<float>::epsilon() * 100);
+
+    // Long run against a double precision filter
+    auto bfRef = difi::Butterworthd(s.order, double(s.fc), double(s.fs));
+    auto bff = difi::Butterworthf(s.order, s.fc, s.fs);
+    bf.resetFilter();
+    double errMixed = 0.;
+    double errFloat = 0.;
+    for (int i = 0; i < 10000; ++i) {
+        const float x = std::sin(0.05f * static_cast<float>(i)) + 0.3f * std::sin(1.3f * static_cast<float>(i));
+        const double ref = bfRef.stepFilter(double(x));
+        errMixed = std::max(errMixed, std::abs(double(bf.stepFilter(x)) - ref));
+        errFloat = std::max(errFloat, std::abs(double(bff.stepFilter(x)) - ref));
+    }
+
+    // On this signal, the double accumulation is about 8 times more accurate than float.
+    // The compensated sum gains less as the recursive state is still stored in float.
+    const double gain = std::is_same<Accumulator, double>::value ? 4. : 1.2;
+    REQUIRE(errMixed * gain < errFloat);
+}
+
+TEST_CASE_TEMPLATE("Butterworth denormal protection", T, float, double)
+{
+    System<T> s;
+    auto bf = difi::Butterworth<T>(s.order, s.fc, s.fs);
+    bf.setFlushDenormals(true);
+    REQUIRE(bf.flushDenormals());
+
+    // An impulse followed by silence decays through the denormal range
+    bf.stepFilter(T(1));
+    for (int i = 0; i < 100000; ++i) {
+        const T y = bf.stepFilter(T(0));
+        REQUIRE((y == T(0) || std::abs(y) >= std::numeric_limits<T>::min()));
+    }
+    REQUIRE(bf.stepFilter(T(0)) == T(0));
+
+    // Batch filtering gives the same results as with stepFilter
+    bf.resetFilter();
+    test_results(s.lpResults, s.data, bf, std::numeric_limits<T>::epsilon() * 100);
+
+    if (difi::ScopedDenormalGuard::isSupported()) {
+        volatile T tiny = std::numeric_limits<T>::min();
+        {
+            difi::ScopedDenormalGuard guard;
+            volatile T half = tiny / T(4);
+            REQUIRE(half == T(0));
+        }
+        volatile T half = tiny / T(4);
+        REQUIRE(half != T(0));
+    }
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+#include "difi"
+#include "doctest/doctest.h"
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+TEST_CASE("Cascade matches sequential filtering")
+{
+    difi::MovingAveraged ma(5);
+    difi::Butterworthd bf(4, 50, 1000);
+    difi::CenteredDiffNoiseRobust2d<9> cd;
+    cd.setTimestep(0.001);
+
+    auto chain = ma | bf | cd;
+    static_assert(std::is_same<decltype(chain), difi::Cascade<double, difi::MovingAveraged, difi::Butterworthd, difi::CenteredDiffNoiseRobust2d<9>>>::value, "Cascades are flattened");
+    static_assert(std::is_same<decltype(chain), decltype(difi::cascade(ma, bf, cd))>::value, "cascade() and operator| build the same type");
+    static_assert(noexcept(chain.stepFilterUnchecked(0.)), "The unchecked step must be noexcept");
+    REQUIRE(chain.size() == 3);
+    REQUIRE(chain.isInitialized());
+    REQUIRE(chain.center() == ma.center() + bf.center() + cd.center());
+    REQUIRE(chain.stage<1>().coefficients() == bf.coefficients());
+
+    Eigen::VectorXd signal(200);
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        signal(i) = std::sin(0.05 * static_cast<double>(i));
+    const Eigen::VectorXd expected = cd.filter(bf.filter(ma.filter(signal)));
+
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        REQUIRE(chain.stepFilter(signal(i)) == expected(i));
+
+    chain.resetFilter();
+    REQUIRE(chain.filter(signal) == expected);
+
+    // Strided and in place
+    std::vector<double> interleaved(2 * 200, -1.);
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        interleaved[2 * i] = signal(i);
+    chain.resetFilter();
+    chain.filter(interleaved.data(), interleaved.data(), 200, 2, 2);
+    for (Eigen::Index i = 0; i < signal.size(); ++i) {
+        REQUIRE(interleaved[2 * i] == expected(i));
+        REQUIRE(interleaved[2 * i + 1] == -1.);
+    }
+}
+
+TEST_CASE("Cascade composition")
+{
+    difi::Butterworthd bf(2, 10, 100);
+    difi::DigitalFilterd df(Eigen::VectorXd::Ones(1), Eigen::Vector2d(0.5, 0.5));
+    auto single = difi::cascade(bf);
+    REQUIRE(single.size() == 1);
+
+    auto left = bf | df;
+    auto right = df | bf;
+    auto both = left | right;
+    static_assert(std::is_same<decltype(both), difi::Cascade<double, difi::Butterworthd, difi::DigitalFilterd, difi::DigitalFilterd, difi::Butterworthd>>::value, "Cascades are flattened");
+    auto prepended = df | left;
+    REQUIRE(prepended.size() == 3);
+    REQUIRE(both.stepFilter(1.) == right.stepFilter(left.stepFilter(1.)));
+
+    auto uninitialized = bf | difi::DigitalFilterd();
+    REQUIRE(!uninitialized.isInitialized());
+    REQUIRE_THROWS_AS(uninitialized.stepFilter(1.), std::logic_error);
+    REQUIRE_THROWS_AS(uninitialized.filter(Eigen::VectorXd::Ones(3)), std::logic_error);
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+
+#include "difi"
+#include "doctest/doctest.h"
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+TEST_CASE_TEMPLATE("Coefficient bank designs are used in place", T, float, double)
+{
+    const auto lp = difi::Butterworth<T>(4, T(10), T(100));
+    const auto bp = difi::Butterworth<T>(2, T(10), T(20), T(100));
+    const auto ma = difi::MovingAverage<T>(5);
+    difi::CoefficientBankWriter<T> writer;
+    REQUIRE(writer.add(lp) == 0);
+    REQUIRE(writer.add(bp) == 1);
+    REQUIRE(writer.add(ma.aCoeff() * T(2), ma.bCoeff() * T(2), difi::FilterType::Centered) == 2);
+    REQUIRE(writer.addSections(lp.secondOrderSections()) == 3);
+
+    const std::string path = (std::filesystem::temp_directory_path() / "difi_coefficient_bank_tests.bank").string();
+    writer.write(path);
+    auto bank = difi::CoefficientBank<T>::open(path);
+    REQUIRE(bank->size() == 4);
+    REQUIRE(bank->verify());
+    REQUIRE(bank->kind(0) == difi::BankEntryKind::TransferFunction);
+    REQUIRE(bank->kind(3) == difi::BankEntryKind::SecondOrderSections);
+    REQUIRE(bank->type(2) == difi::FilterType::Centered);
+
+    // Filters point to the mapped coefficients and keep the bank alive
+    auto coeffs = bank->coefficients(1);
+    REQUIRE(coeffs->isView());
+    difi::DigitalFilter<T> filter(std::move(coeffs), bank->type(1));
+    difi::DigitalFilter<T> centered(bank->coefficients(2), bank->type(2));
+    REQUIRE(centered.type() == difi::FilterType::Centered);
+    REQUIRE(centered.aCoeff()(0) == T(1));
+    bank.reset();
+
+    auto reference = bp;
+    for (int i = 0; i < 50; ++i)
+        REQUIRE(filter.stepFilter(T(i % 3)) == reference.stepFilter(T(i % 3)));
+    REQUIRE(centered.bCoeff() == ma.bCoeff());
+
+    // Sections are read in place too
+    bank = difi::CoefficientBank<T>::open(path);
+    const difi::matX_t<T> sos = bank->secondOrderSections(3);
+    REQUIRE(sos == lp.secondOrderSections());
+    REQUIRE_THROWS_AS(bank->coefficients(3), std::logic_error);
+    REQUIRE_THROWS_AS(bank->secondOrderSections(0), std::logic_error);
+    REQUIRE_THROWS_AS(bank->coefficients(4), std::logic_error);
+    bank.reset();
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Coefficient bank validation")
+{
+    difi::CoefficientBankWriterd writer;
+    writer.add(Eigen::Vector2d(1, -0.5), Eigen::Vector2d(0.25, 0.25));
+    auto bytes = writer.bytes();
+    REQUIRE(difi::CoefficientBankd::view(bytes.data(), bytes.size())->size() == 1);
+
+    // Wrong scalar type, truncated bank and wrong magic are refused
+    REQUIRE_THROWS_AS(difi::CoefficientBankf::view(bytes.data(), bytes.size()), std::logic_error);
+    REQUIRE_THROWS_AS(difi::CoefficientBankd::view(bytes.data(), bytes.size() - 8), std::logic_error);
+    auto magic = bytes;
+    magic[0] = std::byte{ 'X' };
+    REQUIRE_THROWS_AS(difi::CoefficientBankd::view(magic.data(), magic.size()), std::logic_error);
+
+    // Corrupted coefficients are only found by verify, so that opening stays cheap
+    bytes.back() ^= std::byte{ 1 };
+    const auto corrupted = difi::CoefficientBankd::view(bytes.data(), bytes.size());
+    REQUIRE(!corrupted->verify());
+
+    // Bad designs are refused by the writer
+    REQUIRE_THROWS_AS(writer.add(Eigen::Vector2d(0, 1), Eigen::Vector2d(1, 1)), std::logic_error);
+    REQUIRE_THROWS_AS(writer.add(Eigen::Vector2d(1, 1), Eigen::Vector2d(1, 1), difi::FilterType::Centered), std::logic_error);
+}
@@ -0,0 +1,167 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+// Heap allocations of Eigen assert inside a ScopedEigenNoMalloc
+#define EIGEN_RUNTIME_NO_MALLOC
+
+#include "counting_resource.h"
+#include "difi"
+#include "doctest/doctest.h"
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Coefficient slot keeps the filter state")
+{
+    difi::Butterworthd bf(3, 10, 100);
+    const auto next = difi::Butterworthd(3, 25, 100).coefficients();
+    difi::CoefficientSlotd slot(bf.coefficients());
+    REQUIRE(slot.aOrder() == bf.aOrder());
+    REQUIRE(slot.bOrder() == bf.bOrder());
+
+    std::vector<double> x;
+    std::vector<double> y;
+    for (int i = 0; i < 50; ++i) {
+        x.push_back(std::sin(0.3 * i));
+        y.push_back(bf.stepFilter(x.back()));
+    }
+
+    REQUIRE(!slot.update(bf));
+    REQUIRE(slot.tryPublish(next));
+    // The previous coefficients are not picked up yet
+    REQUIRE(!slot.tryPublish(next));
+    REQUIRE(slot.pending() != nullptr);
+    REQUIRE(slot.update(bf));
+    REQUIRE(slot.pending() == nullptr);
+    REQUIRE(bf.coefficients() == next);
+
+    // The new coefficients continue from the previous history
+    x.push_back(1.);
+    double expected = 0;
+    for (Eigen::Index k = 0; k < next->bOrder(); ++k)
+        expected += next->bCoeff()(k) * x[x.size() - 1 - static_cast<std::size_t>(k)];
+    for (Eigen::Index k = 1; k < next->aOrder(); ++k)
+        expected -= next->aCoeff()(k) * y[y.size() - static_cast<std::size_t>(k)];
+    REQUIRE(std::abs(bf.stepFilter(1.) - expected) < 1e-12);
+
+    REQUIRE(slot.tryPublish(bf.coefficients()));
+    REQUIRE_THROWS_AS(slot.tryPublish(difi::Butterworthd(4, 25, 100).coefficients()), std::logic_error);
+    REQUIRE_THROWS_AS(difi::CoefficientSlotd(nullptr), std::logic_error);
+    auto ma = difi::MovingAveraged(3);
+    REQUIRE_THROWS_AS(ma.swapCoeffs(next), std::logic_error);
+}
+
+TEST_CASE("Hot-swap filter cross-fade")
+{
+    difi::Butterworthd bf(2, 5, 100);
+    const auto next = difi::Butterworthd(2, 30, 100).coefficients();
+    constexpr std::size_t FADE = 10;
+    difi::HotSwapFilter<double, difi::Butterworthd> direct(bf);
+    difi::HotSwapFilter<double, difi::Butterworthd> fading(bf, FADE);
+    REQUIRE(fading.fadeLength() == FADE);
+
+    for (int i = 0; i < 20; ++i)
+        REQUIRE(direct.stepFilter(std::sin(0.5 * i)) == fading.stepFilter(std::sin(0.5 * i)));
+
+    direct.publish(next);
+    fading.publish(next);
+    auto old = bf;
+    for (int i = 0; i < 20; ++i)
+        old.stepFilter(std::sin(0.5 * i));
+
+    for (std::size_t i = 0; i < FADE; ++i) {
+        const double x = std::cos(0.5 * static_cast<double>(i));
+        const double yNew = direct.stepFilter(x);
+        const double yOld = old.stepFilter(x);
+        const double weight = static_cast<double>(FADE - i) / static_cast<double>(FADE + 1);
+        REQUIRE(std::abs(fading.stepFilter(x) - (yNew + weight * (yOld - yNew))) < 1e-12);
+        REQUIRE(fading.isFading() == (i + 1 < FADE));
+        // Publications wait for the end of the fade
+        if (fading.isFading())
+            REQUIRE(!fading.tryPublish(bf.coefficients()));
+    }
+    REQUIRE(fading.filter().coefficients() == next);
+    for (int i = 0; i < 20; ++i)
+        REQUIRE(direct.stepFilter(1.) == fading.stepFilter(1.));
+    REQUIRE(fading.tryPublish(bf.coefficients()));
+}
+
+TEST_CASE("Coefficient slot between two threads")
+{
+    difi::Butterworthd bf(4, 10, 1000);
+    std::vector<std::shared_ptr<const difi::FilterCoefficientsd>> designs;
+    for (int i = 0; i < 20; ++i)
+        designs.push_back(difi::Butterworthd(4, 10. + 10. * i, 1000).coefficients());
+
+    difi::HotSwapFilter<double, difi::Butterworthd> filter(bf, 8);
+    std::atomic<bool> tuning{ true };
+    std::thread tuner([&]() {
+        for (const auto& design : designs)
+            filter.publish(design);
+        tuning = false;
+    });
+
+    double y = 0;
+    for (int i = 0; tuning.load() || filter.isFading() || i < 1000; ++i) {
+        y = filter.stepFilter(std::sin(0.01 * i));
+        REQUIRE(std::isfinite(y));
+    }
+    tuner.join();
+    // Pick up the last publication
+    for (int i = 0; i < 10; ++i)
+        filter.stepFilter(0.);
+    REQUIRE(filter.filter().coefficients() == designs.back());
+}
+
+TEST_CASE("Coefficient hot-swaps do not allocate")
+{
+    difi::Butterworthd design(4, 10, 100);
+    const auto low = design.coefficients();
+    const auto high = difi::Butterworthd(4, 20, 100).coefficients();
+
+    CountingResource counter(std::pmr::new_delete_resource());
+    difi::ScopedMemoryResource scope(&counter);
+    difi::DigitalFilterd df(low, design.type());
+    difi::CoefficientSlotd slot(low);
+    difi::HotSwapFilterd fading(df, 10);
+    const int allocations = counter.allocations;
+
+    {
+        ScopedEigenNoMalloc noMalloc;
+        for (int i = 0; i < 100; ++i) {
+            if (i % 20 == 0) {
+                REQUIRE(slot.tryPublish(i % 40 == 0 ? high : low));
+                REQUIRE(fading.tryPublish(i % 40 == 0 ? high : low));
+            }
+            slot.update(df);
+            df.stepFilter(static_cast<double>(i));
+            fading.stepFilter(static_cast<double>(i));
+        }
+    }
+    REQUIRE(counter.allocations == allocations);
+}
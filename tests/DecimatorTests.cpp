@@ -0,0 +1,114 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#include "difi"
+#include "doctest/doctest.h"
+#include "doctest_helper.h"
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+template <typename T, typename Filter>
+void checkAgainstDownsampling(Filter& filter, int factor, T tolerance)
+{
+    difi::Decimator<T> decimator(filter, factor);
+    REQUIRE(decimator.coefficients() == filter.coefficients());
+    REQUIRE(decimator.factor() == factor);
+
+    difi::vectX_t<T> signal(1003);
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        signal(i) = std::sin(T(0.01) * static_cast<T>(i)) + T(0.5) * std::sin(T(2.5) * static_cast<T>(i));
+    const difi::vectX_t<T> full = filter.filter(signal);
+
+    // Sample by sample, the first output is kept
+    Eigen::Index nrOutputs = 0;
+    for (Eigen::Index i = 0; i < signal.size(); ++i) {
+        T output;
+        const bool isKept = decimator.stepFilter(signal(i), output);
+        REQUIRE(isKept == (i % factor == 0));
+        if (isKept) {
+            REQUIRE_SMALL(std::abs(output - full(i)), tolerance);
+            ++nrOutputs;
+        }
+    }
+
+    decimator.resetFilter();
+    const difi::vectX_t<T> res = decimator.filter(signal);
+    REQUIRE(res.size() == nrOutputs);
+    for (Eigen::Index i = 0; i < res.size(); ++i)
+        REQUIRE_SMALL(std::abs(res(i) - full(i * factor)), tolerance);
+}
+
+} // namespace
+
+TEST_CASE_TEMPLATE("Decimator matches filtering then downsampling", T, float, double)
+{
+    const T tolerance = std::numeric_limits<T>::epsilon() * 1000;
+    difi::MovingAverage<T> ma(20);
+    checkAgainstDownsampling<T>(ma, 10, tolerance);
+    ma.resetFilter();
+    checkAgainstDownsampling<T>(ma, 1, tolerance);
+
+    difi::Butterworth<T> bf(4, 40, 1000);
+    checkAgainstDownsampling<T>(bf, 10, tolerance);
+    bf.resetFilter();
+    checkAgainstDownsampling<T>(bf, 3, tolerance);
+
+    difi::DigitalFilter<T> recursive((difi::vectX_t<T>(3) << T(1), T(-0.5), T(0.25)).finished(), difi::vectX_t<T>::Constant(1, T(0.1)));
+    checkAgainstDownsampling<T>(recursive, 7, tolerance);
+}
+
+TEST_CASE("Decimator blocks")
+{
+    difi::Butterworthd bf(3, 10, 1000);
+    difi::Decimatord decimator(bf, 4);
+    const Eigen::VectorXd signal = Eigen::VectorXd::Random(101);
+    const Eigen::VectorXd full = bf.filter(signal);
+
+    // Blocks that do not end on an output carry the phase over
+    const Eigen::VectorXd first = decimator.filter(signal.head(10).eval());
+    REQUIRE(first.size() == 3);
+    REQUIRE(decimator.samplesBeforeOutput() == 2);
+    const Eigen::VectorXd second = decimator.filter(signal.tail(91).eval());
+    REQUIRE(second.size() == 23);
+    REQUIRE_SMALL(std::abs(second(0) - full(12)), 1e-12);
+    REQUIRE_SMALL(std::abs(second(22) - full(100)), 1e-12);
+
+    // Strided input, decimated in place
+    std::vector<double> interleaved(2 * 101, -1.);
+    for (size_t i = 0; i < 101; ++i)
+        interleaved[2 * i] = signal(static_cast<Eigen::Index>(i));
+    decimator.resetFilter();
+    REQUIRE(decimator.filter(interleaved.data(), interleaved.data(), 101, 2, 1) == 26);
+    for (Eigen::Index i = 0; i < 26; ++i)
+        REQUIRE_SMALL(std::abs(interleaved[static_cast<size_t>(i)] - full(4 * i)), 1e-12);
+
+    REQUIRE_THROWS_AS(difi::Decimatord(bf, 0), std::logic_error);
+    REQUIRE_THROWS_AS(difi::Decimatord(difi::DigitalFilterd(), 2), std::logic_error);
+}
@@ -29,6 +29,7 @@
 #include "doctest/doctest.h"
 #include "test_functions.h"
 #include "warning_macro.h"
+#include <utility>
 
 DISABLE_CONVERSION_WARNING_BEGIN
 
@@ -49,3 +50,88 @@ TEST_CASE_TEMPLATE("Digital filter", T, float, double)
     test_coeffs(s.aCoeff, s.bCoeff, df, std::numeric_limits<T>::epsilon() * 10);
     test_results(s.results, s.data, df, std::numeric_limits<T>::epsilon() * 10);
 }
+
+TEST_CASE_TEMPLATE("Digital filter coefficients keep their storage", T, float, double)
+{
+    System<T> s;
+    auto df = difi::DigitalFilter<T>(s.aCoeff, s.bCoeff);
+    const T* aData = df.aCoeff().data();
+    const T* bData = df.bCoeff().data();
+
+    // Same sizes, rvalues, lvalues and expressions are all written in place
+    difi::vectX_t<T> aCoeff = s.aCoeff;
+    difi::vectX_t<T> bCoeff = s.bCoeff;
+    df.setCoeffs(std::move(aCoeff), std::move(bCoeff));
+    REQUIRE(df.aCoeff().data() == aData);
+    REQUIRE(df.bCoeff().data() == bData);
+    test_results(s.results, s.data, df, std::numeric_limits<T>::epsilon() * 10);
+
+    df.setCoeffs(s.aCoeff, s.bCoeff * T(1));
+    REQUIRE(df.aCoeff().data() == aData);
+    REQUIRE(df.bCoeff().data() == bData);
+    test_results(s.results, s.data, df, std::numeric_limits<T>::epsilon() * 10);
+
+    // Wrong coefficients leave the filter unchanged
+    REQUIRE_THROWS_AS(df.setCoeffs(difi::vectX_t<T>::Zero(2), difi::vectX_t<T>::Ones(2)), std::logic_error);
+    REQUIRE(df.isInitialized());
+    test_coeffs(s.aCoeff, s.bCoeff, df, std::numeric_limits<T>::epsilon() * 10);
+
+    // New coefficients adopt the storage of rvalues, which are normalized in place
+    auto copy = df;
+    aCoeff = s.aCoeff * T(2);
+    bCoeff = s.bCoeff * T(2);
+    aData = aCoeff.data();
+    bData = bCoeff.data();
+    df.setCoeffs(std::move(aCoeff), std::move(bCoeff));
+    REQUIRE(df.coefficients()->isAdopted());
+    REQUIRE(df.aCoeff().data() == aData);
+    REQUIRE(df.bCoeff().data() == bData);
+    REQUIRE(copy.coefficients() != df.coefficients());
+    test_results(s.results, s.data, df, std::numeric_limits<T>::epsilon() * 10);
+
+    aCoeff = s.aCoeff;
+    bCoeff = s.bCoeff;
+    aData = aCoeff.data();
+    auto adopted = difi::DigitalFilter<T>(std::move(aCoeff), std::move(bCoeff));
+    REQUIRE(adopted.aCoeff().data() == aData);
+    test_results(s.results, s.data, adopted, std::numeric_limits<T>::epsilon() * 10);
+
+    // Copies of adopted coefficients own a copy, and writes in place keep the adopted storage
+    const difi::FilterCoefficients<T> coeffsCopy(*adopted.coefficients());
+    REQUIRE(coeffsCopy.isAdopted());
+    REQUIRE(coeffsCopy.aCoeff().data() != aData);
+    REQUIRE(coeffsCopy.bCoeff() == adopted.bCoeff());
+    adopted.setCoeffs(s.aCoeff, s.bCoeff * T(1));
+    REQUIRE(adopted.aCoeff().data() == aData);
+    test_results(s.results, s.data, adopted, std::numeric_limits<T>::epsilon() * 10);
+}
+
+TEST_CASE_TEMPLATE("Digital filters share their coefficients", T, float, double)
+{
+    System<T> s;
+    auto df = difi::DigitalFilter<T>(s.aCoeff, s.bCoeff);
+    auto copy = df;
+    auto shared = difi::DigitalFilter<T>(df.coefficients());
+    REQUIRE(copy.coefficients() == df.coefficients());
+    REQUIRE(shared.coefficients() == df.coefficients());
+    REQUIRE(shared.bCoeff().data() == df.bCoeff().data());
+    REQUIRE(df.coefficients().use_count() == 3);
+
+    // Each filter owns its data history
+    REQUIRE(df.stepFilter(s.data(0)) == copy.stepFilter(s.data(0)));
+    test_results(s.results, s.data, shared, std::numeric_limits<T>::epsilon() * 10);
+
+    // Redesigning a filter does not modify the others
+    copy.setCoeffs(s.aCoeff, s.bCoeff * T(2));
+    REQUIRE(copy.coefficients() != df.coefficients());
+    test_coeffs(s.aCoeff, s.bCoeff, df, std::numeric_limits<T>::epsilon() * 10);
+    test_coeffs(s.aCoeff, s.bCoeff, shared, std::numeric_limits<T>::epsilon() * 10);
+
+    // Coefficients created outside of a filter are normalized and never written
+    const auto coeffs = difi::FilterCoefficients<T>::create(s.aCoeff * T(2), s.bCoeff * T(2));
+    df.setCoeffs(coeffs);
+    df.setCoeffs(s.aCoeff, s.bCoeff);
+    REQUIRE(coeffs.use_count() == 1);
+    REQUIRE(std::abs(coeffs->aCoeff()(0) - T(1)) < std::numeric_limits<T>::epsilon());
+    REQUIRE_THROWS_AS(difi::FilterCoefficients<T>::create(difi::vectX_t<T>::Zero(2), s.bCoeff), std::logic_error);
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#include "difi"
+#include "doctest/doctest.h"
+#include "doctest_helper.h"
+#include <cmath>
+#include <limits>
+
+namespace {
+
+template <typename T>
+difi::vectX_t<T> sineSignal(Eigen::Index size)
+{
+    difi::vectX_t<T> signal(size);
+    for (Eigen::Index i = 0; i < size; ++i)
+        signal(i) = std::sin(T(0.05) * static_cast<T>(i)) + T(0.3) * std::sin(T(1.3) * static_cast<T>(i));
+    return signal;
+}
+
+} // namespace
+
+TEST_CASE_TEMPLATE("Merged filters match the cascade", T, float, double)
+{
+    difi::Butterworth<T> bf(4, 10, 100);
+    difi::MovingAverage<T> ma(5);
+    difi::DigitalFilter<T> merged = difi::merge(bf, ma);
+    REQUIRE(merged.aOrder() == bf.aOrder() + ma.aOrder() - 1);
+    REQUIRE(merged.bOrder() == bf.bOrder() + ma.bOrder() - 1);
+
+    const difi::vectX_t<T> signal = sineSignal<T>(200);
+    const difi::vectX_t<T> expected = ma.filter(bf.filter(signal));
+    const difi::vectX_t<T> res = merged.filter(signal);
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        REQUIRE_SMALL(std::abs(res(i) - expected(i)), std::numeric_limits<T>::epsilon() * 1000);
+
+    // Whole cascades are merged stage by stage
+    difi::DigitalFilter<T> mergedChain = difi::merge(bf | ma | ma);
+    ma.resetFilter();
+    const difi::vectX_t<T> chainExpected = ma.filter(expected);
+    const difi::vectX_t<T> chainRes = mergedChain.filter(signal);
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        REQUIRE_SMALL(std::abs(chainRes(i) - chainExpected(i)), std::numeric_limits<T>::epsilon() * 1000);
+}
+
+TEST_CASE("Merged FIR filters keep their center")
+{
+    difi::CenteredDiffNoiseRobust2d<9> cd;
+    cd.setTimestep(0.01);
+    difi::DigitalFilterd ma(Eigen::VectorXd::Ones(1), Eigen::VectorXd::Constant(101, 1. / 101.), difi::FilterType::Centered);
+    difi::DigitalFilterd merged = difi::merge(ma, cd);
+    REQUIRE(merged.type() == difi::FilterType::Centered);
+    REQUIRE(merged.center() == ma.center() + cd.center());
+    REQUIRE(merged.aOrder() == 1);
+
+    // The long FIR goes through the FFT multiplication
+    const Eigen::VectorXd signal = sineSignal<double>(300);
+    const Eigen::VectorXd expected = cd.filter(ma.filter(signal));
+    const Eigen::VectorXd res = merged.filter(signal);
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        REQUIRE_SMALL(std::abs(res(i) - expected(i)), 1e-10);
+
+    difi::Butterworthd bf(2, 10, 100);
+    REQUIRE(difi::merge(bf, ma).type() == difi::FilterType::Backward);
+}
+
+TEST_CASE_TEMPLATE("Filter factored into second-order sections", T, float, double)
+{
+    difi::Butterworth<T> bf(5, 10, 100);
+    const difi::matX_t<T> sos = difi::toSOS(bf);
+    const difi::matX_t<T> expected = bf.secondOrderSections();
+    REQUIRE(sos.rows() == expected.rows());
+    REQUIRE(sos.cols() == 6);
+    for (Eigen::Index i = 0; i < sos.rows(); ++i) {
+        // Poles are found again, the zeros at -1 are only approximate as they are multiple
+        REQUIRE_SMALL(std::abs(sos(i, 3) - T(1)), std::numeric_limits<T>::epsilon());
+        REQUIRE_SMALL(std::abs(sos(i, 4) - expected(i, 4)), std::numeric_limits<T>::epsilon() * 1000);
+        REQUIRE_SMALL(std::abs(sos(i, 5) - expected(i, 5)), std::numeric_limits<T>::epsilon() * 1000);
+    }
+
+    // Going back from the sections gives the same filter
+    difi::DigitalFilter<T> rebuilt = difi::fromSOS(sos);
+    const difi::vectX_t<T> signal = sineSignal<T>(200);
+    const difi::vectX_t<T> res = rebuilt.filter(signal);
+    const difi::vectX_t<T> ref = bf.filter(signal);
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        REQUIRE_SMALL(std::abs(res(i) - ref(i)), std::numeric_limits<T>::epsilon() * 1000);
+
+    difi::DigitalFilter<T> fir(difi::vectX_t<T>::Ones(1), (difi::vectX_t<T>(3) << T(0), T(1), T(1)).finished());
+    REQUIRE_THROWS_AS(difi::toSOS(fir), std::logic_error);
+}
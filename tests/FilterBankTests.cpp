@@ -0,0 +1,179 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+#include "counting_resource.h"
+#include "difi"
+#include "doctest/doctest.h"
+#include <cmath>
+#include <memory_resource>
+#include <set>
+#include <vector>
+
+namespace {
+
+// Filters of different orders and cut-off frequencies
+std::vector<difi::DigitalFilterd> makeFilters(std::size_t n)
+{
+    std::vector<difi::DigitalFilterd> filters;
+    filters.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        difi::Butterworthd bf(static_cast<int>(1 + i % 4), 5. + static_cast<double>(i % 7), 100.);
+        filters.emplace_back(bf.coefficients(), bf.type());
+    }
+    return filters;
+}
+
+} // namespace
+
+TEST_CASE("Filter bank matches sequential filtering")
+{
+    constexpr std::size_t NR_FILTERS = 1000;
+    constexpr int NR_TICKS = 50;
+    auto filters = makeFilters(NR_FILTERS);
+
+    difi::FilterBankOptions options;
+    options.nrThreads = 4;
+    options.chunkBytes = 1024;
+    options.minFiltersPerThread = 1;
+    options.pinThreads = true;
+    difi::FilterBankd bank(filters, options);
+    REQUIRE(bank.size() == NR_FILTERS);
+    REQUIRE(bank.nrThreads() == 4);
+    REQUIRE(bank.nrChunks() > bank.nrThreads());
+    REQUIRE(bank.nrChunks() == (NR_FILTERS + bank.chunkSize() - 1) / bank.chunkSize());
+
+    Eigen::VectorXd inputs(NR_FILTERS);
+    Eigen::VectorXd outputs(NR_FILTERS);
+    for (int t = 0; t < NR_TICKS; ++t) {
+        for (std::size_t i = 0; i < NR_FILTERS; ++i)
+            inputs(static_cast<Eigen::Index>(i)) = std::sin(0.1 * t + static_cast<double>(i));
+        bank.step(inputs, outputs);
+        // The output i comes from the filter i, bit for bit
+        for (std::size_t i = 0; i < NR_FILTERS; ++i)
+            REQUIRE(outputs(static_cast<Eigen::Index>(i)) == filters[i].stepFilter(inputs(static_cast<Eigen::Index>(i))));
+    }
+
+    // In place
+    bank.resetFilters();
+    for (auto& f : filters)
+        f.resetFilter();
+    inputs.setOnes();
+    bank.step(inputs.data(), inputs.data());
+    for (std::size_t i = 0; i < NR_FILTERS; ++i)
+        REQUIRE(inputs(static_cast<Eigen::Index>(i)) == filters[i].stepFilter(1.));
+    REQUIRE(bank.filter(NR_FILTERS - 1).stepFilter(0.) == filters.back().stepFilter(0.));
+
+    Eigen::VectorXd tooShort(NR_FILTERS - 1);
+    REQUIRE_THROWS_AS(bank.step(inputs, tooShort), std::logic_error);
+    REQUIRE_THROWS_AS(bank.filter(NR_FILTERS), std::logic_error);
+}
+
+TEST_CASE("Small filter banks run on the calling thread")
+{
+    difi::FilterBankOptions options;
+    options.nrThreads = 8;
+    difi::FilterBankd bank(makeFilters(100), options);
+    REQUIRE(bank.nrThreads() == 1);
+
+    Eigen::VectorXd outputs(100);
+    bank.step(Eigen::VectorXd::Ones(100), outputs);
+    REQUIRE(outputs(0) == makeFilters(1)[0].stepFilter(1.));
+
+    difi::FilterBankd empty(std::vector<difi::DigitalFilterd>{});
+    REQUIRE(empty.nrChunks() == 0);
+    REQUIRE_NOTHROW(empty.step(nullptr, nullptr));
+
+    // Differentiators
+    std::vector<difi::CenteredDiffNoiseRobust2d<7>> diffs(10);
+    difi::FilterBank<double, difi::CenteredDiffNoiseRobust2d<7>> diffBank(diffs);
+    REQUIRE(diffBank.nrThreads() == 1);
+
+    std::vector<difi::DigitalFilterd> uninitialized(3);
+    REQUIRE_THROWS_AS(difi::FilterBankd{ uninitialized }, std::logic_error);
+}
+
+TEST_CASE("Filter bank snapshot")
+{
+    constexpr std::size_t NR_FILTERS = 500;
+    difi::FilterBankOptions options;
+    options.nrThreads = 3;
+    options.chunkBytes = 1024;
+    options.minFiltersPerThread = 1;
+    difi::FilterBankd bank(makeFilters(NR_FILTERS), options);
+    REQUIRE(bank.nrThreads() == 3);
+    Eigen::VectorXd inputs(NR_FILTERS);
+    Eigen::VectorXd outputs(NR_FILTERS);
+    for (int t = 0; t < 20; ++t) {
+        for (std::size_t i = 0; i < NR_FILTERS; ++i)
+            inputs(static_cast<Eigen::Index>(i)) = std::sin(0.1 * t + static_cast<double>(i));
+        bank.step(inputs, outputs);
+    }
+
+    // Saved between two steps, restored into a bank of the same size whatever its threads
+    const auto snapshot = difi::saveSnapshot(bank);
+    difi::FilterBankd standby(makeFilters(NR_FILTERS));
+    difi::restoreSnapshot(standby, snapshot);
+    Eigen::VectorXd expected(NR_FILTERS);
+    for (int t = 20; t < 40; ++t) {
+        for (std::size_t i = 0; i < NR_FILTERS; ++i)
+            inputs(static_cast<Eigen::Index>(i)) = std::sin(0.1 * t + static_cast<double>(i));
+        bank.step(inputs, expected);
+        standby.step(inputs, outputs);
+        REQUIRE(outputs == expected);
+    }
+
+    difi::FilterBankd smaller(makeFilters(NR_FILTERS - 1));
+    REQUIRE_THROWS_AS(difi::restoreSnapshot(smaller, snapshot), std::logic_error);
+}
+
+TEST_CASE("Filter bank workers copy the filters into their own memory resource")
+{
+    constexpr std::size_t NR_FILTERS = 500;
+    const auto filters = makeFilters(NR_FILTERS);
+    difi::FilterBankOptions options;
+    options.nrThreads = 4;
+    options.chunkBytes = 1024;
+    options.minFiltersPerThread = 1;
+
+    // The default resource may be an arena that is not thread-safe: the workers don't use it
+    CountingResource counter(std::pmr::new_delete_resource());
+    std::set<std::pmr::memory_resource*> resources;
+    {
+        difi::ScopedMemoryResource scope(&counter);
+        difi::FilterBankd bank(filters, options);
+        REQUIRE(bank.nrThreads() == 4);
+        REQUIRE(counter.allocations == 0);
+        for (std::size_t i = 0; i < NR_FILTERS; ++i)
+            resources.insert(bank.filter(i).memoryResource());
+
+        Eigen::VectorXd outputs(NR_FILTERS);
+        bank.step(Eigen::VectorXd::Ones(NR_FILTERS), outputs);
+        REQUIRE(outputs(0) == makeFilters(1)[0].stepFilter(1.));
+    }
+    REQUIRE(resources.size() == 4);
+    REQUIRE(resources.count(&counter) == 0);
+    REQUIRE(resources.count(std::pmr::get_default_resource()) == 0);
+}
@@ -0,0 +1,161 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#include "difi"
+#include "doctest/doctest.h"
+#include "doctest_helper.h"
+#include "warning_macro.h"
+#include <cmath>
+#include <limits>
+
+DISABLE_CONVERSION_WARNING_BEGIN
+
+namespace {
+
+template <typename I>
+difi::vectX_t<I> generateSignal(Eigen::Index size, double amplitude)
+{
+    difi::vectX_t<I> signal(size);
+    for (Eigen::Index i = 0; i < size; ++i)
+        signal(i) = difi::toFixedPoint<I>(amplitude * (0.6 * std::sin(0.05 * i) + 0.4 * std::sin(1.3 * i)));
+    return signal;
+}
+
+template <typename I>
+double maxError(const difi::vectX_t<I>& results, const difi::vectX_t<double>& reference)
+{
+    double err = 0.;
+    for (Eigen::Index i = 0; i < results.size(); ++i)
+        err = std::max(err, std::abs(difi::fromFixedPoint<double>(results(i)) - reference(i)));
+    return err;
+}
+
+} // namespace
+
+TEST_CASE_TEMPLATE("Fixed-point conversions", I, difi::Q15, difi::Q31)
+{
+    REQUIRE_EQUAL(difi::toFixedPoint<I>(0.5), I(1) << (std::numeric_limits<I>::digits - 1));
+    REQUIRE_EQUAL(difi::toFixedPoint<I>(-1.), std::numeric_limits<I>::min());
+    REQUIRE_EQUAL(difi::toFixedPoint<I>(1.), std::numeric_limits<I>::max());
+    REQUIRE_EQUAL(difi::toFixedPoint<I>(-3.), std::numeric_limits<I>::min());
+    REQUIRE_EQUAL(difi::fromFixedPoint<double>(difi::toFixedPoint<I>(-0.25)), -0.25);
+}
+
+TEST_CASE("Fixed-point rounding modes")
+{
+    const difi::vectX_t<double> half = difi::vectX_t<double>::Constant(1, 0.5);
+    const difi::vectX_t<difi::Q15> data = (difi::vectX_t<difi::Q15>(4) << 3, 5, -3, -5).finished();
+    difi::FixedPointFIRFilter<difi::Q15, difi::Rounding::Truncate> trunc(half);
+    difi::FixedPointFIRFilter<difi::Q15, difi::Rounding::Nearest> nearest(half);
+    difi::FixedPointFIRFilter<difi::Q15, difi::Rounding::Convergent> convergent(half);
+
+    const difi::vectX_t<difi::Q15> truncRes = (difi::vectX_t<difi::Q15>(4) << 1, 2, -2, -3).finished();
+    const difi::vectX_t<difi::Q15> nearestRes = (difi::vectX_t<difi::Q15>(4) << 2, 3, -1, -2).finished();
+    const difi::vectX_t<difi::Q15> convergentRes = (difi::vectX_t<difi::Q15>(4) << 2, 2, -2, -2).finished();
+    REQUIRE(trunc.filter(data) == truncRes);
+    REQUIRE(nearest.filter(data) == nearestRes);
+    REQUIRE(convergent.filter(data) == convergentRes);
+}
+
+TEST_CASE("Fixed-point saturation")
+{
+    difi::FixedPointFIRFilterq15 gain(difi::vectX_t<double>(difi::vectX_t<double>::Constant(1, 1.5)));
+    REQUIRE_EQUAL(gain.stepFilter(difi::toFixedPoint<difi::Q15>(0.9)), std::numeric_limits<difi::Q15>::max());
+    REQUIRE_EQUAL(gain.stepFilter(difi::toFixedPoint<difi::Q15>(-0.9)), std::numeric_limits<difi::Q15>::min());
+    REQUIRE_EQUAL(gain.stepFilter(difi::toFixedPoint<difi::Q15>(0.5)), difi::toFixedPoint<difi::Q15>(0.75));
+}
+
+TEST_CASE_TEMPLATE("Fixed-point moving average", I, difi::Q15, difi::Q31)
+{
+    difi::MovingAverage<double> ma(50);
+    difi::FixedPointFIRFilter<I> fir(ma);
+    REQUIRE(fir.isInitialized());
+    REQUIRE_EQUAL(fir.bCoeff().size(), 50);
+
+    const difi::vectX_t<I> signal = generateSignal<I>(2000, 0.9);
+    difi::vectX_t<double> signald(signal.size());
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        signald(i) = difi::fromFixedPoint<double>(signal(i));
+
+    const double lsb = std::ldexp(1., -std::numeric_limits<I>::digits);
+    REQUIRE_SMALL(maxError(fir.filter(signal), ma.filter(signald)), 4 * lsb);
+}
+
+TEST_CASE_TEMPLATE("Butterworth second-order sections", T, float, double)
+{
+    const std::vector<difi::Butterworth<T>> filters{ difi::Butterworth<T>(5, 10, 100), difi::Butterworth<T>(4, 10, 100, difi::Butterworth<T>::Type::HighPass),
+        difi::Butterworth<T>(3, 5, 15, 100), difi::Butterworth<T>(3, 5, 15, 100, difi::Butterworth<T>::Type::BandReject) };
+    for (const auto& bf : filters) {
+        const difi::matX_t<T> sos = bf.secondOrderSections();
+        REQUIRE_EQUAL(sos.rows(), bf.aOrder() / 2);
+
+        // Expand back the sections
+        difi::vectX_t<T> a = difi::vectX_t<T>::Constant(1, T(1));
+        difi::vectX_t<T> b = difi::vectX_t<T>::Constant(1, T(1));
+        for (Eigen::Index i = 0; i < sos.rows(); ++i) {
+            difi::vectX_t<T> aNext = difi::vectX_t<T>::Zero(a.size() + 2);
+            difi::vectX_t<T> bNext = difi::vectX_t<T>::Zero(b.size() + 2);
+            for (Eigen::Index k = 0; k < 3; ++k) {
+                aNext.segment(k, a.size()) += sos(i, 3 + k) * a;
+                bNext.segment(k, b.size()) += sos(i, k) * b;
+            }
+            a = aNext;
+            b = bNext;
+        }
+
+        for (Eigen::Index i = 0; i < bf.aOrder(); ++i) {
+            REQUIRE_SMALL(std::abs(a(i) - bf.aCoeff()(i)), std::numeric_limits<T>::epsilon() * 1000);
+            REQUIRE_SMALL(std::abs(b(i) - bf.bCoeff()(i)), std::numeric_limits<T>::epsilon() * 1000);
+        }
+        for (Eigen::Index i = bf.aOrder(); i < a.size(); ++i) {
+            REQUIRE_SMALL(std::abs(a(i)), std::numeric_limits<T>::epsilon() * 1000);
+            REQUIRE_SMALL(std::abs(b(i)), std::numeric_limits<T>::epsilon() * 1000);
+        }
+    }
+}
+
+TEST_CASE_TEMPLATE("Fixed-point Butterworth", I, difi::Q15, difi::Q31)
+{
+    difi::Butterworthd bf(5, 10, 100);
+    difi::FixedPointBiquadFilter<I> biquad(bf.secondOrderSections());
+    REQUIRE_EQUAL(biquad.nrSections(), 3);
+
+    const difi::vectX_t<I> signal = generateSignal<I>(5000, 0.5);
+    difi::vectX_t<double> signald(signal.size());
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        signald(i) = difi::fromFixedPoint<double>(signal(i));
+
+    const double lsb = std::ldexp(1., -std::numeric_limits<I>::digits);
+    REQUIRE_SMALL(maxError(biquad.filter(signal), bf.filter(signald)), 16 * lsb);
+
+    // Reset gives the same results
+    biquad.resetFilter();
+    bf.resetFilter();
+    REQUIRE_SMALL(maxError(biquad.filter(signal), bf.filter(signald)), 16 * lsb);
+}
+
+DISABLE_CONVERSION_WARNING_END
@@ -0,0 +1,169 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#include "difi"
+#include "doctest/doctest.h"
+#include "doctest_helper.h"
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <vector>
+
+namespace {
+
+template <typename T>
+std::complex<T> scalarResponse(const difi::vectX_t<T>& bCoeff, const difi::vectX_t<T>& aCoeff, T w)
+{
+    std::complex<T> num(0);
+    std::complex<T> den(0);
+    for (Eigen::Index k = 0; k < bCoeff.size(); ++k)
+        num += bCoeff(k) * std::polar(T(1), -w * static_cast<T>(k));
+    for (Eigen::Index k = 0; k < aCoeff.size(); ++k)
+        den += aCoeff(k) * std::polar(T(1), -w * static_cast<T>(k));
+    return num / den;
+}
+
+} // namespace
+
+TEST_CASE_TEMPLATE("Frequency response", T, float, double)
+{
+    const T tol = std::numeric_limits<T>::epsilon() * 100;
+    difi::Butterworth<T> bf(4, 10, 100);
+    const difi::vectX_t<T> w = difi::vectX_t<T>::LinSpaced(200, T(0), difi::pi<T>);
+    difi::vectXc_t<T> h(w.size());
+    difi::freqz(bf, w, h);
+
+    difi::vectX_t<T> aCoeff, bCoeff;
+    bf.getCoeffs(aCoeff, bCoeff);
+    for (Eigen::Index i = 0; i < w.size(); ++i)
+        REQUIRE_SMALL(std::abs(h(i) - scalarResponse(bCoeff, aCoeff, w(i))), tol);
+    REQUIRE_SMALL(std::abs(h(0) - std::complex<T>(1)), tol);
+
+    // Cut-off frequency at -3dB
+    const difi::vectX_t<T> wc = difi::vectX_t<T>::Constant(1, T(2) * difi::pi<T> * T(10) / T(100));
+    difi::vectXc_t<T> hc(1);
+    difi::freqz(bf, wc, hc);
+    REQUIRE_SMALL(std::abs(std::abs(hc(0)) - T(1) / std::sqrt(T(2))), tol);
+
+    // Same response from the coefficients and from the second-order sections
+    difi::vectXc_t<T> hCoeffs(w.size());
+    difi::vectXc_t<T> hSOS(w.size());
+    difi::freqz(aCoeff, bCoeff, w, hCoeffs);
+    difi::freqz(bf.secondOrderSections(), w, hSOS);
+    for (Eigen::Index i = 0; i < w.size(); ++i) {
+        REQUIRE_SMALL(std::abs(hCoeffs(i) - h(i)), tol);
+        REQUIRE_SMALL(std::abs(hSOS(i) - h(i)), tol);
+    }
+
+    difi::vectXc_t<T> tooShort(w.size() - 1);
+    REQUIRE_THROWS_AS(difi::freqz(bf, w, tooShort), std::logic_error);
+}
+
+TEST_CASE("Frequency response on a uniform grid")
+{
+    difi::Butterworthd bf(6, 5, 100);
+    difi::DigitalFilterd fir(Eigen::VectorXd::Ones(1), Eigen::VectorXd::Random(300));
+    for (Eigen::Index n : { Eigen::Index(128), Eigen::Index(100) }) {
+        const Eigen::VectorXd w = Eigen::VectorXd::LinSpaced(n, 0., difi::pi<double> * static_cast<double>(n - 1) / static_cast<double>(n));
+        Eigen::VectorXcd uniform(n);
+        Eigen::VectorXcd grid(n);
+        difi::freqz(bf, uniform);
+        difi::freqz(bf, w, grid);
+        REQUIRE_SMALL((uniform - grid).cwiseAbs().maxCoeff(), 1e-10);
+
+        // The FIR is longer than the FFT and gets folded
+        difi::freqz(fir, uniform);
+        difi::freqz(fir, w, grid);
+        REQUIRE_SMALL((uniform - grid).cwiseAbs().maxCoeff(), 1e-10);
+    }
+}
+
+TEST_CASE("Batched frequency responses")
+{
+    std::vector<difi::Butterworthd> filters;
+    for (int i = 1; i <= 5; ++i)
+        filters.emplace_back(i, 5. * i, 100.);
+    const Eigen::VectorXd w = Eigen::VectorXd::LinSpaced(64, 0., difi::pi<double>);
+    Eigen::MatrixXcd h(w.size(), static_cast<Eigen::Index>(filters.size()));
+    difi::freqz(filters.data(), static_cast<Eigen::Index>(filters.size()), w, h);
+
+    Eigen::VectorXcd single(w.size());
+    for (size_t i = 0; i < filters.size(); ++i) {
+        difi::freqz(filters[i], w, single);
+        REQUIRE(h.col(static_cast<Eigen::Index>(i)) == single);
+    }
+
+    Eigen::MatrixXcd wrongSize(w.size(), 4);
+    REQUIRE_THROWS_AS(difi::freqz(filters.data(), 5, w, wrongSize), std::logic_error);
+}
+
+TEST_CASE_TEMPLATE("Phase and group delay", T, float, double)
+{
+    const T tol = std::numeric_limits<T>::epsilon() * 1000;
+    const difi::vectX_t<T> w = difi::vectX_t<T>::LinSpaced(500, T(0.01), T(3));
+    difi::vectX_t<T> phase(w.size());
+    difi::vectX_t<T> delay(w.size());
+
+    // Pure delay of 5 samples
+    difi::DigitalFilter<T> shift(difi::vectX_t<T>::Ones(1), (difi::vectX_t<T>(6) << T(0), T(0), T(0), T(0), T(0), T(1)).finished());
+    difi::phasez(shift, w, phase);
+    difi::grpdelay(shift, w, delay);
+    for (Eigen::Index i = 0; i < w.size(); ++i) {
+        REQUIRE_SMALL(std::abs(phase(i) + T(5) * w(i)), tol);
+        REQUIRE_SMALL(std::abs(delay(i) - T(5)), tol);
+    }
+
+    // Linear phase FIR
+    difi::CenteredDiffNoiseRobust2<T, 9> cd;
+    cd.setTimestep(T(1));
+    difi::grpdelay(cd, w, delay);
+    // The response of a differentiator vanishes at 0 and at pi, where digits are lost
+    for (Eigen::Index i = 0; i < w.size(); ++i) {
+        if (w(i) > T(0.1) && w(i) < T(2))
+            REQUIRE_SMALL(std::abs(delay(i) - T(cd.center())), std::sqrt(std::numeric_limits<T>::epsilon()));
+    }
+
+    // Group delay is minus the derivative of the phase
+    difi::Butterworth<T> bf(3, 10, 100);
+    difi::phasez(bf, w, phase);
+    difi::grpdelay(bf, w, delay);
+    for (Eigen::Index i = 1; i + 1 < w.size(); ++i) {
+        const T derivative = (phase(i + 1) - phase(i - 1)) / (w(i + 1) - w(i - 1));
+        REQUIRE_SMALL(std::abs(delay(i) + derivative), T(1e-2));
+    }
+
+    difi::vectX_t<T> sosPhase(w.size());
+    difi::vectX_t<T> sosDelay(w.size());
+    difi::phasez(bf.secondOrderSections(), w, sosPhase);
+    difi::grpdelay(bf.secondOrderSections(), w, sosDelay);
+    for (Eigen::Index i = 0; i < w.size(); ++i) {
+        REQUIRE_SMALL(std::abs(sosPhase(i) - phase(i)), tol);
+        // The multiple zero at pi is better conditioned in the sections
+        if (w(i) < T(2))
+            REQUIRE_SMALL(std::abs(sosDelay(i) - delay(i)), tol);
+    }
+}
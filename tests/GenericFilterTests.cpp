@@ -25,9 +25,16 @@
 // of the authors and should not be interpreted as representing official policies,
 // either expressed or implied, of the FreeBSD Project.
 
+// Heap allocations of Eigen assert inside a ScopedEigenNoMalloc
+#define EIGEN_RUNTIME_NO_MALLOC
+
+#include "counting_resource.h"
 #include "difi"
 #include "doctest/doctest.h"
+#include <cmath>
 #include <exception>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 TEST_CASE("Filter failures")
@@ -74,3 +81,174 @@ TEST_CASE("Filter failures")
     // Bad type. Need odd number of bCoeffs
     REQUIRE_THROWS_AS(difi::DigitalFilterd(Eigen::VectorXd::Constant(2, 1), Eigen::VectorXd::Constant(2, 0), difi::FilterType::Centered), std::logic_error);
 }
+
+TEST_CASE("Unchecked step filter")
+{
+    static_assert(noexcept(std::declval<difi::DigitalFilterd&>().stepFilterUnchecked(0.)), "The unchecked step must be noexcept");
+    static_assert(noexcept(std::declval<difi::TVCenteredDiffNoiseRobust2d<5>&>().stepFilterUnchecked(0., 0.)), "The unchecked step must be noexcept");
+    static_assert(noexcept(std::declval<difi::VectorDigitalFilterd&>().stepFilterUnchecked(std::declval<const Eigen::Ref<const Eigen::VectorXd>&>())), "The unchecked step must be noexcept");
+    static_assert(noexcept(std::declval<difi::FixedPointFIRFilterq15&>().stepFilterUnchecked(0)), "The unchecked step must be noexcept");
+
+    auto checked = difi::Butterworthd(3, 10, 100);
+    auto unchecked = difi::Butterworthd(3, 10, 100);
+    for (int i = 0; i < 100; ++i)
+        REQUIRE(checked.stepFilter(std::sin(0.1 * i)) == unchecked.stepFilterUnchecked(std::sin(0.1 * i)));
+
+    // Entry points still check the filter state
+    auto df = difi::DigitalFilterd();
+    REQUIRE_THROWS_AS(df.filter(Eigen::VectorXd::Ones(3)), std::logic_error);
+    auto vdf = difi::VectorDigitalFilterd(Eigen::VectorXd::Constant(1, 1), Eigen::VectorXd::Constant(2, 0.5));
+    REQUIRE_NOTHROW(vdf.filter(Eigen::MatrixXd::Ones(2, 4)));
+    REQUIRE_THROWS_AS(vdf.filter(Eigen::MatrixXd::Ones(3, 4)), std::logic_error);
+}
+
+TEST_CASE("Filter layout")
+{
+    static_assert(!std::is_polymorphic<difi::DigitalFilterd>::value, "Filters must not have a vtable");
+    static_assert(!std::is_polymorphic<difi::Butterworthd>::value, "Filters must not have a vtable");
+    static_assert(sizeof(difi::FilterType) == 1, "FilterType must be compact");
+
+    // History is kept in a single block which is reused by a reset
+    auto df = difi::DigitalFilterd(Eigen::VectorXd::Constant(3, 1), Eigen::VectorXd::Constant(4, 0.25));
+    for (int i = 0; i < 10; ++i)
+        df.stepFilter(1.);
+    df.resetFilter();
+    REQUIRE(df.stepFilter(1.) == 0.25);
+}
+
+TEST_CASE("Strided filter")
+{
+    constexpr int CHANNELS = 3;
+    constexpr int FRAMES = 50;
+    Eigen::VectorXd signal(FRAMES);
+    for (int i = 0; i < FRAMES; ++i)
+        signal(i) = std::sin(0.1 * i);
+    auto bf = difi::Butterworthd(3, 10, 100);
+    const Eigen::VectorXd expected = bf.filter(signal);
+
+    // Second channel of an interleaved buffer, filtered in place
+    std::vector<double> interleaved(CHANNELS * FRAMES, -1.);
+    for (int i = 0; i < FRAMES; ++i)
+        interleaved[CHANNELS * i + 1] = signal(i);
+    bf.resetFilter();
+    bf.filter(interleaved.data() + 1, interleaved.data() + 1, FRAMES, CHANNELS, CHANNELS);
+    for (int i = 0; i < FRAMES; ++i) {
+        REQUIRE(interleaved[CHANNELS * i] == -1.);
+        REQUIRE(interleaved[CHANNELS * i + 1] == expected(i));
+        REQUIRE(interleaved[CHANNELS * i + 2] == -1.);
+    }
+
+    // Strided input to a contiguous output
+    for (int i = 0; i < FRAMES; ++i)
+        interleaved[CHANNELS * i + 1] = signal(i);
+    Eigen::Map<const Eigen::VectorXd, 0, Eigen::InnerStride<>> channel(interleaved.data() + 1, FRAMES, Eigen::InnerStride<>(CHANNELS));
+    Eigen::VectorXd results(FRAMES);
+    bf.resetFilter();
+    bf.filter(channel, results);
+    REQUIRE(results == expected);
+
+    Eigen::VectorXd tooShort(FRAMES - 1);
+    REQUIRE_THROWS_AS(bf.filter(signal, tooShort), std::logic_error);
+    REQUIRE_THROWS_AS(bf.filter(signal.data(), results.data(), FRAMES, 0, 1), std::logic_error);
+    REQUIRE_THROWS_AS(difi::DigitalFilterd().filter(signal, results), std::logic_error);
+}
+
+TEST_CASE("FFT filter of long FIR filters")
+{
+    constexpr Eigen::Index TAPS = 200;
+    constexpr Eigen::Index SIZE = 5000;
+    static_assert(TAPS >= difi::DigitalFilterd::FFT_MIN_TAPS, "The filter must take the FFT path");
+    const Eigen::VectorXd bCoeff = Eigen::VectorXd::Random(TAPS) / static_cast<double>(TAPS);
+    const Eigen::VectorXd signal = Eigen::VectorXd::Random(SIZE);
+    difi::DigitalFilterd fir(Eigen::VectorXd::Ones(1), bCoeff);
+    difi::DigitalFilterd direct(Eigen::VectorXd::Ones(1), bCoeff);
+    Eigen::VectorXd expected(SIZE);
+    for (Eigen::Index i = 0; i < SIZE; ++i)
+        expected(i) = direct.stepFilter(signal(i));
+
+    // Split in calls to check that the state is carried over, from the direct form (shorter than a transform) and between transforms
+    const Eigen::VectorXd head = fir.filter(signal.head(3 * TAPS / 2).eval());
+    const Eigen::VectorXd middle = fir.filter(signal.segment(head.size(), SIZE / 2 - head.size()).eval());
+    const Eigen::VectorXd tail = fir.filter(signal.tail(SIZE / 2).eval());
+    for (Eigen::Index i = 0; i < head.size(); ++i)
+        REQUIRE(std::abs(head(i) - expected(i)) < 1e-12);
+    for (Eigen::Index i = 0; i < middle.size(); ++i)
+        REQUIRE(std::abs(middle(i) - expected(head.size() + i)) < 1e-12);
+    for (Eigen::Index i = 0; i < tail.size(); ++i)
+        REQUIRE(std::abs(tail(i) - expected(SIZE / 2 + i)) < 1e-12);
+
+    // The direct form takes over seamlessly
+    REQUIRE(std::abs(fir.stepFilter(1.) - direct.stepFilter(1.)) < 1e-12);
+
+    // Strided and in place
+    std::vector<double> interleaved(2 * SIZE, -1.);
+    for (Eigen::Index i = 0; i < SIZE; ++i)
+        interleaved[2 * i] = signal(i);
+    fir.resetFilter();
+    fir.filter(interleaved.data(), interleaved.data(), SIZE, 2, 2);
+    for (Eigen::Index i = 0; i < SIZE; ++i) {
+        REQUIRE(std::abs(interleaved[2 * i] - expected(i)) < 1e-12);
+        REQUIRE(interleaved[2 * i + 1] == -1.);
+    }
+
+    // The spectrum is computed once with the coefficients and shared by the filters using them
+    const auto& coeffs = *fir.coefficients();
+    REQUIRE(coeffs.fftSize() == 1024);
+    difi::DigitalFilterd copy = fir;
+    difi::DigitalFilterd shared(fir.coefficients());
+    REQUIRE(copy.coefficients()->fftKernel() == coeffs.fftKernel());
+    REQUIRE(shared.coefficients()->fftKernel() == coeffs.fftKernel());
+    copy.resetFilter();
+    REQUIRE((copy.filter(signal) - expected).cwiseAbs().maxCoeff() < 1e-12);
+
+    // Short FIR and IIR filters hold no spectrum
+    REQUIRE(difi::DigitalFilterd(Eigen::VectorXd::Ones(1), bCoeff.head(difi::DigitalFilterd::FFT_MIN_TAPS - 1)).coefficients()->fftSize() == 0);
+    REQUIRE(difi::DigitalFilterd(Eigen::VectorXd::Constant(2, 1.), bCoeff).coefficients()->fftSize() == 0);
+}
+
+TEST_CASE("FFT filter of long moving average")
+{
+    constexpr int WINDOW = 500;
+    Eigen::VectorXf signal(3000);
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        signal(i) = std::sin(0.01f * static_cast<float>(i)) + 0.2f * std::sin(1.7f * static_cast<float>(i));
+    difi::MovingAveragef ma(WINDOW);
+    difi::MovingAveragef direct(WINDOW);
+    const Eigen::VectorXf res = ma.filter(signal);
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        REQUIRE(std::abs(res(i) - direct.stepFilter(signal(i))) < 1e-5f);
+}
+
+TEST_CASE("FFT filtering of long FIR filters does not allocate")
+{
+    constexpr int TAPS = 128;
+    constexpr int BATCH = 1024;
+    const Eigen::VectorXd other = Eigen::VectorXd::Constant(TAPS, 0.5 / TAPS);
+    const auto otherCoeffs = difi::DigitalFilterd(Eigen::VectorXd::Ones(1), other).coefficients();
+    std::vector<double> samples(BATCH, 1.);
+
+    CountingResource counter(std::pmr::new_delete_resource());
+    difi::ScopedMemoryResource scope(&counter);
+    difi::StreamingFilterStaged stage(difi::DigitalFilterd(Eigen::VectorXd::Ones(1), Eigen::VectorXd::Constant(TAPS, 1. / TAPS)), 4 * BATCH, BATCH);
+    REQUIRE(stage.filter().coefficients()->fftSize() == 4 * TAPS);
+
+    // The first batch allocates the workspace of the FFT convolution
+    REQUIRE(stage.push(samples.data(), samples.size()) == samples.size());
+    REQUIRE(stage.process() == samples.size());
+    REQUIRE(stage.pop(samples.data(), samples.size()) == samples.size());
+    const int allocations = counter.allocations;
+
+    // The spectra are held by the coefficients, so swapping them computes nothing
+    {
+        ScopedEigenNoMalloc noMalloc;
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(stage.push(samples.data(), samples.size()) == samples.size());
+            REQUIRE(stage.process() == samples.size());
+            REQUIRE(stage.pop(samples.data(), samples.size()) == samples.size());
+        }
+        stage.filter().swapCoeffs(otherCoeffs);
+        stage.filter().filter(samples.data(), samples.data(), BATCH);
+    }
+    REQUIRE(counter.allocations == allocations);
+    REQUIRE(std::abs(samples.back() - 0.5) < 1e-12);
+}
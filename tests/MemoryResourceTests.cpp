@@ -0,0 +1,158 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+// Dedicated to the memory resource tests: the allocations of Eigen are counted instead of aborting on them
+#include <atomic>
+static std::atomic<int> eigenMallocs{ 0 };
+#define EIGEN_RUNTIME_NO_MALLOC
+#define eigen_assert(x)      \
+    do {                     \
+        if (!(x))            \
+            ++eigenMallocs;  \
+    } while (false)
+
+#include "counting_resource.h"
+#include "difi"
+#include "doctest/doctest.h"
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+
+namespace {
+
+/*! \brief Run f with Eigen allocations forbidden and return the number of allocations Eigen tried. */
+template <typename F>
+int eigenMallocsIn(F&& f)
+{
+    eigenMallocs = 0;
+    Eigen::internal::set_is_malloc_allowed(false);
+    f();
+    Eigen::internal::set_is_malloc_allowed(true);
+    return eigenMallocs;
+}
+
+} // namespace
+
+TEST_CASE("Filters allocate from the default memory resource at construction")
+{
+    alignas(std::max_align_t) std::array<std::byte, 1 << 16> memory;
+    std::pmr::monotonic_buffer_resource arena(memory.data(), memory.size(), std::pmr::null_memory_resource());
+    CountingResource counter(&arena);
+
+    difi::ScopedMemoryResource scope(&counter);
+    difi::Butterworthd bf(4, 10, 20, 100);
+    difi::MovingAveraged ma(5);
+    difi::VectorDigitalFilterd vf(Eigen::VectorXd::Constant(1, 1), Eigen::VectorXd::Constant(3, 1. / 3.));
+    vf.setDimension(3);
+    difi::TVBackwardSavitzkyGolayd<7, 2> sg;
+    difi::FixedPointBiquadFilterq15 biquad(bf.secondOrderSections());
+    difi::FixedPointFIRFilterq15 fir(ma);
+
+    REQUIRE(bf.memoryResource() == &counter);
+    REQUIRE(bf.coefficients()->memoryResource() == &counter);
+    REQUIRE(!bf.coefficients()->isAdopted());
+    REQUIRE(ma.memoryResource() == &counter);
+    REQUIRE(vf.memoryResource() == &counter);
+    REQUIRE(sg.memoryResource() == &counter);
+    REQUIRE(biquad.memoryResource() == &counter);
+    REQUIRE(fir.memoryResource() == &counter);
+    const int allocations = counter.allocations;
+    REQUIRE(allocations > 0);
+
+    // Running and resetting the pipeline neither touches the arena nor the heap
+    Eigen::Vector3d x(1, 2, 3);
+    const int mallocs = eigenMallocsIn([&] {
+        for (int i = 0; i < 100; ++i) {
+            bf.stepFilter(static_cast<double>(i));
+            ma.stepFilter(static_cast<double>(i));
+            vf.stepFilter(x);
+            sg.stepFilter(0.01 * i, static_cast<double>(i));
+            biquad.stepFilter(static_cast<difi::Q15>(i));
+            fir.stepFilter(static_cast<difi::Q15>(i));
+        }
+        bf.resetFilter();
+        vf.resetFilter();
+        sg.resetFilter();
+    });
+    REQUIRE(mallocs == 0);
+    REQUIRE(counter.allocations == allocations);
+
+    // Redesigning with the same size reuses the storage
+    bf.setFilterParameters(4, 15, 25, 100);
+    REQUIRE(counter.allocations == allocations);
+}
+
+TEST_CASE("Filter copies use the current default memory resource")
+{
+    CountingResource counter(std::pmr::new_delete_resource());
+    difi::DigitalFilterd df(Eigen::Vector2d(1, -0.5), Eigen::Vector2d(0.5, 0.5));
+    REQUIRE(df.memoryResource() == std::pmr::get_default_resource());
+
+    {
+        difi::ScopedMemoryResource scope(&counter);
+        difi::DigitalFilterd copy = df;
+        REQUIRE(copy.memoryResource() == &counter);
+        REQUIRE(copy.aCoeff() == df.aCoeff());
+        REQUIRE(copy.bCoeff() == df.bCoeff());
+        REQUIRE(counter.allocations > 0);
+    }
+    REQUIRE(counter.allocations == counter.deallocations);
+    REQUIRE(std::pmr::get_default_resource() != &counter);
+}
+
+TEST_CASE("Filters allocate from the memory resource given to their constructor")
+{
+    CountingResource counter(std::pmr::new_delete_resource());
+    const Eigen::VectorXd bCoeff = Eigen::VectorXd::Constant(100, 0.01);
+    {
+        difi::Butterworthd bf(4, 10, 100, difi::Butterworthd::Type::LowPass, &counter);
+        difi::MovingAveraged ma(5, difi::FilterType::Backward, &counter);
+        difi::DigitalFilterd df(bf.coefficients(), bf.type(), &counter);
+        difi::VectorDigitalFilterd vf(Eigen::VectorXd::Ones(1), Eigen::VectorXd::Constant(3, 1. / 3.), difi::FilterType::Backward, &counter);
+        difi::PartitionedConvolverd convolver(Eigen::VectorXd::Ones(1), bCoeff, 32, difi::FilterType::Backward, &counter);
+        REQUIRE(std::pmr::get_default_resource() != &counter);
+        REQUIRE(bf.memoryResource() == &counter);
+        REQUIRE(bf.coefficients()->memoryResource() == &counter);
+        REQUIRE(ma.memoryResource() == &counter);
+        REQUIRE(df.memoryResource() == &counter);
+        REQUIRE(df.coefficients() == bf.coefficients());
+        REQUIRE(vf.memoryResource() == &counter);
+        REQUIRE(vf.coefficients()->memoryResource() == &counter);
+        REQUIRE(convolver.memoryResource() == &counter);
+        REQUIRE(convolver.coefficients()->memoryResource() == &counter);
+        const int allocations = counter.allocations;
+
+        // New coefficients come from the resource of the filter, or from the given one
+        df.setCoeffs(Eigen::Vector2d(1, -0.5), Eigen::Vector2d(0.5, 0.5));
+        REQUIRE(df.coefficients()->memoryResource() == &counter);
+        REQUIRE(counter.allocations > allocations);
+        df.setCoeffs(Eigen::Vector2d(1, -0.25), Eigen::Vector2d(0.5, 0.5), std::pmr::new_delete_resource());
+        REQUIRE(df.coefficients()->memoryResource() == std::pmr::new_delete_resource());
+        REQUIRE(df.memoryResource() == &counter);
+    }
+    REQUIRE(counter.allocations == counter.deallocations);
+}
@@ -0,0 +1,167 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#include "difi"
+#include "doctest/doctest.h"
+#include <cmath>
+#include <vector>
+
+namespace {
+
+template <typename T>
+void checkAgainstDirectForm(Eigen::Index taps, Eigen::Index blockSize, T tolerance)
+{
+    const difi::vectX_t<T> bCoeff = difi::vectX_t<T>::Random(taps) / static_cast<T>(std::sqrt(static_cast<T>(taps)));
+    difi::DigitalFilter<T> direct(difi::vectX_t<T>::Ones(1), bCoeff);
+    difi::PartitionedConvolver<T> convolver(direct, blockSize);
+    REQUIRE(convolver.coefficients() == direct.coefficients());
+    REQUIRE(convolver.nrPartitions() == (taps - 1) / blockSize);
+
+    const difi::vectX_t<T> signal = difi::vectX_t<T>::Random(5 * taps + 3 * blockSize + 7);
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        REQUIRE(std::abs(convolver.stepFilter(signal(i)) - direct.stepFilter(signal(i))) < tolerance);
+
+    convolver.resetFilter();
+    direct.resetFilter();
+    const difi::vectX_t<T> res = convolver.filter(signal);
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        REQUIRE(std::abs(res(i) - direct.stepFilter(signal(i))) < tolerance);
+}
+
+} // namespace
+
+TEST_CASE_TEMPLATE("Partitioned convolution matches the direct form", T, float, double)
+{
+    const T tolerance = std::is_same<T, float>::value ? T(1e-4) : T(1e-12);
+    checkAgainstDirectForm<T>(1000, 64, tolerance);
+    checkAgainstDirectForm<T>(1000, 16, tolerance);
+    checkAgainstDirectForm<T>(129, 64, tolerance);
+    checkAgainstDirectForm<T>(65, 64, tolerance);
+    // Only the time-domain partition
+    checkAgainstDirectForm<T>(64, 64, tolerance);
+    checkAgainstDirectForm<T>(5, 64, tolerance);
+}
+
+TEST_CASE("Partitioned convolution has no latency")
+{
+    difi::MovingAveraged ma(300);
+    difi::PartitionedConvolverd convolver(ma, 32);
+    REQUIRE(convolver.blockSize() == 32);
+    REQUIRE(convolver.nrPartitions() == 9);
+
+    // The impulse response starts at the first sample
+    for (int i = 0; i < 400; ++i) {
+        const double y = convolver.stepFilter(i == 0 ? 1. : 0.);
+        REQUIRE(std::abs(y - (i < 300 ? 1. / 300. : 0.)) < 1e-12);
+    }
+
+    // Strided and in place
+    std::vector<double> interleaved(2 * 1000, -1.);
+    for (size_t i = 0; i < 1000; ++i)
+        interleaved[2 * i] = std::sin(0.01 * static_cast<double>(i));
+    const std::vector<double> input = interleaved;
+    convolver.resetFilter();
+    convolver.filter(interleaved.data(), interleaved.data(), 1000, 2, 2);
+    for (size_t i = 0; i < 1000; ++i) {
+        REQUIRE(std::abs(interleaved[2 * i] - ma.stepFilter(input[2 * i])) < 1e-12);
+        REQUIRE(interleaved[2 * i + 1] == -1.);
+    }
+}
+
+TEST_CASE("Partitioned convolution spreads the partitions over the block")
+{
+    // More partitions than samples per block, hot-swapped in the middle of a block
+    const Eigen::VectorXd bCoeff = Eigen::VectorXd::Random(300) / 300.;
+    const Eigen::VectorXd signal = Eigen::VectorXd::Random(200);
+    difi::DigitalFilterd direct(Eigen::VectorXd::Ones(1), bCoeff);
+    difi::PartitionedConvolverd convolver(direct, 8);
+    REQUIRE(convolver.nrPartitions() == 37);
+    for (Eigen::Index i = 0; i < 100; ++i)
+        REQUIRE(std::abs(convolver.stepFilter(signal(i)) - direct.stepFilter(signal(i))) < 1e-12);
+    const auto swapped = difi::DigitalFilterd(Eigen::VectorXd::Ones(1), Eigen::VectorXd(-bCoeff)).coefficients();
+    convolver.swapCoeffs(swapped);
+    direct.swapCoeffs(swapped);
+    for (Eigen::Index i = 100; i < signal.size(); ++i)
+        REQUIRE(std::abs(convolver.stepFilter(signal(i)) - direct.stepFilter(signal(i))) < 1e-12);
+}
+
+TEST_CASE("Partitioned convolution failures")
+{
+    difi::Butterworthd bf(2, 10, 100);
+    REQUIRE_THROWS_AS(difi::PartitionedConvolverd{ bf }, std::logic_error);
+    difi::MovingAveraged ma(300);
+    REQUIRE_THROWS_AS((difi::PartitionedConvolverd{ ma, 48 }), std::logic_error);
+    REQUIRE_THROWS_AS((difi::PartitionedConvolverd{ ma, 0 }), std::logic_error);
+    REQUIRE_THROWS_AS(difi::PartitionedConvolverd{ difi::DigitalFilterd() }, std::logic_error);
+}
+
+TEST_CASE("Partitioned convolver is a filter")
+{
+    static_assert(difi::details::is_filter<difi::PartitionedConvolverd>::value, "The convolver must be usable wherever a filter is");
+    const Eigen::VectorXd bCoeff = Eigen::VectorXd::Random(300) / 300.;
+    const Eigen::VectorXd signal = Eigen::VectorXd::Random(500);
+    difi::DigitalFilterd direct(Eigen::VectorXd::Ones(1), bCoeff);
+    difi::PartitionedConvolverd convolver(Eigen::VectorXd::Ones(1), bCoeff, 32);
+    REQUIRE(convolver.isInitialized());
+    REQUIRE(convolver.aOrder() == 1);
+    REQUIRE(convolver.bOrder() == 300);
+
+    // Chained, merged and banked like the direct form
+    difi::Butterworthd bf(2, 10, 100);
+    auto chain = bf | convolver;
+    auto reference = bf | direct;
+    for (Eigen::Index i = 0; i < signal.size(); ++i)
+        REQUIRE(std::abs(chain.stepFilter(signal(i)) - reference.stepFilter(signal(i))) < 1e-12);
+    REQUIRE(difi::merge(bf, convolver).bCoeff().isApprox(difi::merge(bf, direct).bCoeff()));
+    difi::FilterBank<double, difi::PartitionedConvolverd> bank(std::vector<difi::PartitionedConvolverd>(3, convolver));
+    Eigen::VectorXd outputs(3);
+    bank.step(Eigen::VectorXd::Constant(3, 1.), outputs);
+    REQUIRE(std::abs(outputs(2) - bCoeff(0)) < 1e-12);
+
+    // Hot-swapped coefficients keep the history, new coefficients reset it
+    for (Eigen::Index i = 0; i < 100; ++i)
+        REQUIRE(std::abs(convolver.stepFilter(signal(i)) - direct.stepFilter(signal(i))) < 1e-12);
+    const auto swapped = difi::DigitalFilterd(Eigen::VectorXd::Ones(1), Eigen::VectorXd(2 * bCoeff)).coefficients();
+    convolver.swapCoeffs(swapped);
+    direct.swapCoeffs(swapped);
+    for (Eigen::Index i = 100; i < 200; ++i)
+        REQUIRE(std::abs(convolver.stepFilter(signal(i)) - direct.stepFilter(signal(i))) < 1e-12);
+    convolver.setCoeffs(Eigen::VectorXd::Ones(1), bCoeff.head(100));
+    REQUIRE(convolver.nrPartitions() == 3);
+    direct.setCoeffs(Eigen::VectorXd::Ones(1), bCoeff.head(100));
+    for (Eigen::Index i = 0; i < 100; ++i)
+        REQUIRE(std::abs(convolver.stepFilter(signal(i)) - direct.stepFilter(signal(i))) < 1e-12);
+    REQUIRE_THROWS_AS(convolver.setCoeffs(bf.aCoeff(), bf.bCoeff()), std::logic_error);
+    REQUIRE(convolver.bOrder() == 100);
+
+    // A snapshot taken in the middle of a block restarts where it stopped, even with another block size
+    difi::PartitionedConvolverd standby(8);
+    difi::restoreSnapshot(standby, difi::saveSnapshot(convolver));
+    REQUIRE(standby.blockSize() == 32);
+    for (Eigen::Index i = 100; i < signal.size(); ++i)
+        REQUIRE(standby.stepFilter(signal(i)) == convolver.stepFilter(signal(i)));
+}
@@ -0,0 +1,287 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+
+#include "difi"
+#include "doctest/doctest.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+namespace {
+
+template <typename T>
+difi::vectX_t<T> signal(Eigen::Index size)
+{
+    difi::vectX_t<T> s(size);
+    for (Eigen::Index i = 0; i < size; ++i)
+        s(i) = static_cast<T>(std::sin(0.3 * static_cast<double>(i)) + 0.1 * static_cast<double>(i % 7));
+    return s;
+}
+
+} // namespace
+
+TEST_CASE_TEMPLATE("Snapshot restores a running filter", T, float, double)
+{
+    const auto data = signal<T>(200);
+    auto bf = difi::Butterworth<T>(4, T(5), T(20), T(100));
+    for (Eigen::Index i = 0; i < 100; ++i)
+        bf.stepFilter(data(i));
+    const auto snapshot = difi::saveSnapshot(bf);
+    REQUIRE(snapshot.size() == difi::snapshotSize(bf));
+
+    // A standby restarts exactly where the active filter stopped
+    difi::Butterworth<T> standby;
+    difi::restoreSnapshot(standby, snapshot);
+    REQUIRE(standby.isInitialized());
+    REQUIRE(standby.secondOrderSections() == bf.secondOrderSections());
+    for (Eigen::Index i = 100; i < data.size(); ++i)
+        REQUIRE(standby.stepFilter(data(i)) == bf.stepFilter(data(i)));
+}
+
+TEST_CASE("Snapshot restores in place")
+{
+    const auto data = signal<double>(50);
+    auto design = difi::Butterworthd(3, 10, 100);
+    auto active = design;
+    auto standby = design;
+    for (Eigen::Index i = 0; i < data.size(); ++i)
+        active.stepFilter(data(i));
+
+    // The storage is preallocated by the design, and the design stays shared
+    std::vector<std::byte> snapshot(difi::snapshotSize(active));
+    REQUIRE(difi::saveSnapshot(active, snapshot.data(), snapshot.size()) == snapshot.size());
+    difi::restoreSnapshot(standby, snapshot);
+    REQUIRE(standby.coefficients() == design.coefficients());
+    REQUIRE(standby.stepFilter(1.) == active.stepFilter(1.));
+
+    // A wrong buffer size is refused
+    REQUIRE_THROWS_AS(difi::saveSnapshot(active, snapshot.data(), snapshot.size() - 1), std::logic_error);
+}
+
+TEST_CASE("Snapshot of time-varying and vector filters")
+{
+    const auto data = signal<double>(60);
+    {
+        difi::TVCenteredDiffNoiseRobust2d<7> tv;
+        for (Eigen::Index i = 0; i < 30; ++i)
+            tv.stepFilter(0.01 * i + 0.001 * (i % 3), data(i));
+        difi::TVCenteredDiffNoiseRobust2d<7> standby;
+        difi::restoreSnapshot(standby, difi::saveSnapshot(tv));
+        for (Eigen::Index i = 30; i < data.size(); ++i)
+            REQUIRE(standby.stepFilter(0.01 * i, data(i)) == tv.stepFilter(0.01 * i, data(i)));
+    }
+    {
+        difi::TVCenteredSavitzkyGolayd<7, 2> sg;
+        for (Eigen::Index i = 0; i < 30; ++i)
+            sg.stepFilter(0.01 * i + 0.001 * (i % 3), data(i));
+        difi::TVCenteredSavitzkyGolayd<7, 2> standby;
+        difi::restoreSnapshot(standby, difi::saveSnapshot(sg));
+        for (Eigen::Index i = 30; i < data.size(); ++i)
+            REQUIRE(standby.stepFilter(0.01 * i, data(i)) == sg.stepFilter(0.01 * i, data(i)));
+    }
+    {
+        auto vf = difi::VectorDigitalFilterd(Eigen::Vector2d(1, -0.5), Eigen::Vector3d(0.2, 0.3, 0.5));
+        for (Eigen::Index i = 0; i < 30; ++i)
+            vf.stepFilter(Eigen::Vector2d(data(i), -data(i)));
+        difi::VectorDigitalFilterd standby;
+        difi::restoreSnapshot(standby, difi::saveSnapshot(vf));
+        REQUIRE(standby.dimension() == 2);
+        for (Eigen::Index i = 30; i < data.size(); ++i) {
+            const Eigen::Vector2d x(data(i), -data(i));
+            const Eigen::Vector2d expected = vf.stepFilter(x);
+            REQUIRE(standby.stepFilter(x) == expected);
+        }
+    }
+    {
+        difi::FixedPointBiquadFilterq15 biquad(difi::Butterworthd(4, 10, 100).secondOrderSections());
+        for (Eigen::Index i = 0; i < 30; ++i)
+            biquad.stepFilter(difi::toFixedPoint<difi::Q15>(0.5 * data(i) / 2.));
+        difi::FixedPointBiquadFilterq15 standby;
+        difi::restoreSnapshot(standby, difi::saveSnapshot(biquad));
+        for (Eigen::Index i = 30; i < data.size(); ++i) {
+            const auto x = difi::toFixedPoint<difi::Q15>(0.5 * data(i) / 2.);
+            REQUIRE(standby.stepFilter(x) == biquad.stepFilter(x));
+        }
+    }
+}
+
+TEST_CASE("Snapshot validation")
+{
+    auto ma = difi::MovingAveraged(5);
+    for (int i = 0; i < 3; ++i)
+        ma.stepFilter(1.);
+    const auto snapshot = difi::saveSnapshot(ma);
+
+    auto target = difi::MovingAveraged(5);
+    const double expected = target.stepFilter(2.);
+
+    // Corrupted or truncated snapshots leave the filter unchanged
+    auto corrupted = snapshot;
+    corrupted.back() ^= std::byte{ 1 };
+    REQUIRE_THROWS_AS(difi::restoreSnapshot(target, corrupted), std::logic_error);
+    auto truncated = snapshot;
+    truncated.pop_back();
+    REQUIRE_THROWS_AS(difi::restoreSnapshot(target, truncated), std::logic_error);
+    auto version = snapshot;
+    version[4] = std::byte{ 0xFF };
+    REQUIRE_THROWS_AS(difi::restoreSnapshot(target, version), std::logic_error);
+
+    // A snapshot can only be restored into a filter of the same kind
+    difi::TVCenteredDiffNoiseRobust2d<5> tv;
+    REQUIRE_THROWS_AS(difi::restoreSnapshot(tv, snapshot), std::logic_error);
+    difi::MovingAveragef single;
+    REQUIRE_THROWS_AS(difi::restoreSnapshot(single, snapshot), std::logic_error);
+
+    target.resetFilter();
+    REQUIRE(target.stepFilter(2.) == expected);
+
+    // Snapshots of different designs are compatible
+    auto other = difi::MovingAveraged(3);
+    difi::restoreSnapshot(other, snapshot);
+    REQUIRE(other.windowSize() == 5);
+    REQUIRE(other.stepFilter(1.) == ma.stepFilter(1.));
+}
+
+TEST_CASE("Failed snapshot restoration leaves the filter unchanged")
+{
+    const auto data = signal<double>(60);
+    difi::TVCenteredSavitzkyGolayd<7, 2> saved;
+    for (Eigen::Index i = 0; i < 30; ++i)
+        saved.stepFilter(0.01 * i, data(i));
+    const auto snapshot = difi::saveSnapshot(saved);
+
+    // Same layout, but the timers of a 5-point filter can't hold 7 samples
+    difi::TVCenteredSavitzkyGolayd<5, 2> target;
+    difi::TVCenteredSavitzkyGolayd<5, 2> reference;
+    for (Eigen::Index i = 0; i < 30; ++i) {
+        target.stepFilter(0.01 * i, data(i));
+        reference.stepFilter(0.01 * i, data(i));
+    }
+    REQUIRE_THROWS_AS(difi::restoreSnapshot(target, snapshot), std::logic_error);
+    REQUIRE(target.bOrder() == 5);
+    for (Eigen::Index i = 30; i < data.size(); ++i)
+        REQUIRE(target.stepFilter(0.01 * i, data(i)) == reference.stepFilter(0.01 * i, data(i)));
+}
+
+TEST_CASE("Rejected convolver snapshot leaves the convolver unchanged")
+{
+    const auto data = signal<double>(300);
+    const Eigen::VectorXd bCoeff = Eigen::VectorXd::Random(200) / 200.;
+    difi::PartitionedConvolverd saved(Eigen::VectorXd::Ones(1), bCoeff, 32);
+    difi::PartitionedConvolverd target(Eigen::VectorXd::Ones(1), bCoeff, 32);
+    difi::PartitionedConvolverd reference(Eigen::VectorXd::Ones(1), bCoeff, 32);
+    for (Eigen::Index i = 0; i < 100; ++i) {
+        saved.stepFilter(data(i));
+        target.stepFilter(data(i));
+        reference.stepFilter(data(i));
+    }
+
+    // Same layout and a valid checksum, but a block size that is not a power of 2
+    auto snapshot = difi::saveSnapshot(saved);
+    const std::int64_t blockSize = 24;
+    std::memcpy(snapshot.data() + sizeof(difi::SnapshotHeader), &blockSize, sizeof(blockSize));
+    const std::uint64_t checksum = difi::details::fnv1a(snapshot.data() + sizeof(difi::SnapshotHeader), snapshot.size() - sizeof(difi::SnapshotHeader));
+    std::memcpy(snapshot.data() + offsetof(difi::SnapshotHeader, checksum), &checksum, sizeof(checksum));
+    REQUIRE_THROWS_AS(difi::restoreSnapshot(target, snapshot), std::logic_error);
+    REQUIRE(target.blockSize() == 32);
+    for (Eigen::Index i = 100; i < data.size(); ++i)
+        REQUIRE(target.stepFilter(data(i)) == reference.stepFilter(data(i)));
+}
+
+TEST_CASE("Snapshot of composite filters")
+{
+    const auto data = signal<double>(120);
+    const auto bf = difi::Butterworthd(2, 10, 100);
+    {
+        difi::Decimatord decimator(bf, 3);
+        double y;
+        for (Eigen::Index i = 0; i < 61; ++i)
+            decimator.stepFilter(data(i), y);
+        // Another design and factor
+        difi::Decimatord standby(difi::MovingAveraged(4), 2);
+        difi::restoreSnapshot(standby, difi::saveSnapshot(decimator));
+        REQUIRE(standby.factor() == 3);
+        REQUIRE(standby.samplesBeforeOutput() == decimator.samplesBeforeOutput());
+        for (Eigen::Index i = 61; i < data.size(); ++i) {
+            double expected;
+            double output;
+            const bool isKept = decimator.stepFilter(data(i), expected);
+            REQUIRE(standby.stepFilter(data(i), output) == isKept);
+            if (isKept)
+                REQUIRE(output == expected);
+        }
+    }
+    {
+        auto chain = difi::MovingAveraged(5) | bf;
+        for (Eigen::Index i = 0; i < 60; ++i)
+            chain.stepFilter(data(i));
+        auto standby = difi::MovingAveraged(3) | difi::Butterworthd(2, 20, 100);
+        difi::restoreSnapshot(standby, difi::saveSnapshot(chain));
+        REQUIRE(standby.stage<0>().windowSize() == 5);
+        for (Eigen::Index i = 60; i < data.size(); ++i)
+            REQUIRE(standby.stepFilter(data(i)) == chain.stepFilter(data(i)));
+    }
+    {
+        difi::HotSwapFilter<double, difi::Butterworthd> swapped(bf, 10);
+        difi::HotSwapFilter<double, difi::Butterworthd> standby(bf, 10);
+        for (Eigen::Index i = 0; i < 60; ++i)
+            swapped.stepFilter(data(i));
+        // Restoring ends the cross-fade of the standby
+        standby.publish(difi::Butterworthd(2, 20, 100).coefficients());
+        standby.stepFilter(0.);
+        REQUIRE(standby.isFading());
+        difi::restoreSnapshot(standby, difi::saveSnapshot(swapped));
+        REQUIRE(!standby.isFading());
+        REQUIRE(standby.filter().coefficients() == bf.coefficients());
+        for (Eigen::Index i = 60; i < data.size(); ++i)
+            REQUIRE(standby.stepFilter(data(i)) == swapped.stepFilter(data(i)));
+        // The orders of the slot can't change
+        REQUIRE_THROWS_AS(difi::restoreSnapshot(standby, difi::saveSnapshot(difi::Butterworthd(3, 10, 100))), std::logic_error);
+    }
+    {
+        difi::DigitalFilterd reference(bf.coefficients(), bf.type());
+        difi::StreamingFilterStaged stage(reference);
+        difi::StreamingFilterStaged standby(reference);
+        for (Eigen::Index i = 0; i < 60; ++i) {
+            stage.push(data(i));
+            reference.stepFilter(data(i));
+        }
+        stage.process();
+        difi::restoreSnapshot(standby, difi::saveSnapshot(stage));
+        for (Eigen::Index i = 60; i < data.size(); ++i) {
+            double y;
+            REQUIRE(standby.push(data(i)));
+            REQUIRE(standby.process() == 1);
+            REQUIRE(standby.pop(y));
+            REQUIRE(y == reference.stepFilter(data(i)));
+        }
+    }
+}
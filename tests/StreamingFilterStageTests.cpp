@@ -0,0 +1,125 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+#include "difi"
+#include "doctest/doctest.h"
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+TEST_CASE("SPSC ring")
+{
+    difi::SpscRing<int> ring(5);
+    REQUIRE(ring.capacity() == 8);
+    REQUIRE(ring.freeSpace() == 8);
+
+    int value = 0;
+    REQUIRE(!ring.pop(value));
+    for (int i = 0; i < 8; ++i)
+        REQUIRE(ring.push(i));
+    REQUIRE(!ring.push(8));
+    REQUIRE(ring.size() == 8);
+
+    // Batches wrap around the end of the storage
+    int values[8];
+    REQUIRE(ring.pop(values, 5) == 5);
+    const int more[] = { 8, 9, 10, 11, 12, 13 };
+    REQUIRE(ring.push(more, 6) == 5);
+    REQUIRE(ring.pop(values, 8) == 8);
+    for (int i = 0; i < 8; ++i)
+        REQUIRE(values[i] == i + 5);
+    REQUIRE(ring.size() == 0);
+
+    REQUIRE_THROWS_AS(difi::SpscRing<int>(0), std::logic_error);
+}
+
+TEST_CASE("Streaming filter stage")
+{
+    constexpr int NR_SAMPLES = 100000;
+    difi::Butterworthd bf(4, 10, 1000);
+    std::vector<double> signal(NR_SAMPLES);
+    for (int i = 0; i < NR_SAMPLES; ++i)
+        signal[i] = std::sin(0.01 * i) + 0.1 * std::sin(0.9 * i);
+    std::vector<double> expected(NR_SAMPLES);
+    for (int i = 0; i < NR_SAMPLES; ++i)
+        expected[i] = bf.stepFilter(signal[i]);
+
+    SUBCASE("Single thread")
+    {
+        difi::StreamingFilterStaged stage(difi::DigitalFilterd(bf.coefficients(), bf.type()), 16, 4);
+        REQUIRE(stage.capacity() == 16);
+        REQUIRE(stage.batchSize() == 4);
+        REQUIRE(stage.push(signal.data(), 20) == 16);
+        // The output ring is full after 4 batches
+        std::size_t processed = 0;
+        while (stage.process() > 0)
+            ++processed;
+        REQUIRE(processed == 4);
+        double result = 0;
+        for (int i = 0; i < 16; ++i) {
+            REQUIRE(stage.pop(result));
+            REQUIRE(result == expected[i]);
+        }
+        REQUIRE(!stage.pop(result));
+        REQUIRE(stage.process() == 0);
+    }
+
+    SUBCASE("Three threads")
+    {
+        difi::StreamingFilterStaged stage(difi::DigitalFilterd(bf.coefficients(), bf.type()), 256, 32);
+        std::atomic<bool> running{ true };
+        std::thread producer([&]() {
+            for (int i = 0; i < NR_SAMPLES;) {
+                if (stage.push(signal[i]))
+                    ++i;
+                else
+                    std::this_thread::yield();
+            }
+        });
+        std::thread filtering([&]() {
+            while (running.load())
+                if (stage.process() == 0)
+                    std::this_thread::yield();
+        });
+
+        std::vector<double> results;
+        results.reserve(NR_SAMPLES);
+        double buffer[64];
+        while (results.size() < NR_SAMPLES) {
+            const std::size_t n = stage.pop(buffer, 64);
+            if (n == 0)
+                std::this_thread::yield();
+            results.insert(results.end(), buffer, buffer + n);
+        }
+        running = false;
+        producer.join();
+        filtering.join();
+        REQUIRE(results == expected);
+    }
+
+    REQUIRE_THROWS_AS(difi::StreamingFilterStaged(difi::DigitalFilterd()), std::logic_error);
+}
@@ -0,0 +1,155 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#include "difi"
+#include "doctest/doctest.h"
+#include "doctest_helper.h"
+#include "noisy_function_generator.h"
+#include <limits>
+#include <vector>
+
+constexpr const int STEPS = 200;
+constexpr const int DIM = 4;
+
+// Each row is a sinus of different amplitude
+template <typename T>
+difi::matX_t<T> generateSignal(const difi::vectX_t<T>& f)
+{
+    difi::matX_t<T> signal(DIM, f.size());
+    for (int i = 0; i < DIM; ++i)
+        signal.row(i) = static_cast<T>(i + 1) * f.transpose();
+    return signal;
+}
+
+TEST_CASE_TEMPLATE("Vector digital filter", T, float, double)
+{
+    auto sg = sinGenerator<T>(STEPS, T(1), T(1), T(0.01));
+    difi::matX_t<T> signal = generateSignal<T>(std::get<0>(sg));
+
+    difi::Butterworth<T> bf(3, T(10), T(100));
+    difi::VectorDigitalFilter<T> vf(bf.aCoeff(), bf.bCoeff());
+    REQUIRE_EQUAL(vf.dimension(), 0);
+    difi::matX_t<T> vResults = vf.filter(signal);
+    REQUIRE_EQUAL(vf.dimension(), DIM);
+
+    for (int i = 0; i < DIM; ++i) {
+        bf.resetFilter();
+        difi::vectX_t<T> results = bf.filter(signal.row(i).transpose());
+        for (Eigen::Index j = 0; j < results.size(); ++j)
+            REQUIRE_SMALL(std::abs(results(j) - vResults(i, j)), std::numeric_limits<T>::epsilon() * 100);
+    }
+
+    // Step by step
+    vf.resetFilter();
+    for (Eigen::Index j = 0; j < signal.cols(); ++j) {
+        auto value = vf.stepFilter(signal.col(j));
+        REQUIRE_SMALL((value - vResults.col(j)).norm(), std::numeric_limits<T>::epsilon() * 100);
+    }
+
+    // Bad dimension
+    REQUIRE_THROWS_AS(vf.stepFilter(difi::vectX_t<T>::Zero(DIM + 1)), std::logic_error);
+    vf.setDimension(DIM + 1);
+    REQUIRE_NOTHROW(vf.stepFilter(difi::vectX_t<T>::Zero(DIM + 1)));
+}
+
+TEST_CASE("Vector differentiators")
+{
+    double dt = 0.001;
+    auto sg = sinGenerator<double>(STEPS, 1., 1., dt);
+    difi::matX_t<double> signal = generateSignal<double>(std::get<0>(sg));
+
+    difi::CenteredDiffNoiseRobust2d<9> cd;
+    difi::VectorCenteredDiffNoiseRobust2d<9> vcd;
+    cd.setTimestep(dt);
+    vcd.setTimestep(dt);
+    REQUIRE_EQUAL(vcd.center(), cd.center());
+
+    difi::matX_t<double> vResults = vcd.filter(signal);
+    for (int i = 0; i < DIM; ++i) {
+        cd.resetFilter();
+        difi::vectX_t<double> results = cd.filter(signal.row(i).transpose());
+        REQUIRE_SMALL((results.transpose() - vResults.row(i)).norm(), 1e-9);
+    }
+}
+
+TEST_CASE("Vector time-varying differentiators")
+{
+    auto sg = tvSinGenerator<double>(STEPS, 1., 1., 0.001);
+    difi::matX_t<double> signal = generateSignal<double>(std::get<1>(sg));
+    const difi::vectX_t<double>& time = std::get<0>(sg);
+
+    difi::TVCenteredDiffNoiseRobust2d<7> cd;
+    difi::TVVectorCenteredDiffNoiseRobust2d<7> vcd;
+
+    difi::matX_t<double> vResults = vcd.filter(signal, time);
+    for (int i = 0; i < DIM; ++i) {
+        cd.resetFilter();
+        difi::vectX_t<double> results = cd.filter(signal.row(i).transpose(), time);
+        // Skip the initialization where both produce inf/nan values
+        for (Eigen::Index j = 10; j < results.size(); ++j)
+            REQUIRE_SMALL(std::abs(results(j) - vResults(i, j)), 1e-9);
+    }
+}
+
+TEST_CASE_TEMPLATE("Interleaved vector filter", T, float, double)
+{
+    auto sg = sinGenerator<T>(STEPS, T(1), T(1), T(0.01));
+    difi::matX_t<T> signal = generateSignal<T>(std::get<0>(sg));
+
+    difi::Butterworth<T> bf(3, T(10), T(100));
+    difi::VectorDigitalFilter<T> vf(bf.coefficients());
+    difi::matX_t<T> expected = vf.filter(signal);
+
+    // Frames of DIM channels and a timestamp, filtered in place
+    constexpr int FRAME = DIM + 1;
+    std::vector<T> frames(FRAME * STEPS, T(-1));
+    for (int j = 0; j < STEPS; ++j)
+        for (int i = 0; i < DIM; ++i)
+            frames[FRAME * j + i] = signal(i, j);
+    vf.resetFilter();
+    vf.filter(frames.data(), frames.data(), STEPS, FRAME, FRAME);
+    for (int j = 0; j < STEPS; ++j) {
+        for (int i = 0; i < DIM; ++i)
+            REQUIRE(frames[FRAME * j + i] == expected(i, j));
+        REQUIRE(frames[FRAME * j + DIM] == T(-1));
+    }
+
+    // Strided maps, e.g. every other frame of the transposed signal
+    difi::matX_t<T> transposed = signal.transpose();
+    using Stride = Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>;
+    Eigen::Map<const difi::matX_t<T>, 0, Stride> data(transposed.data(), DIM, STEPS / 2, Stride(2, STEPS));
+    difi::matX_t<T> results(DIM, STEPS / 2);
+    vf.resetFilter();
+    vf.filter(data, results);
+    difi::matX_t<T> everyOther = signal(Eigen::all, Eigen::seq(0, STEPS - 1, 2));
+    vf.resetFilter();
+    REQUIRE(results == vf.filter(everyOther));
+
+    difi::matX_t<T> tooLong(DIM, STEPS);
+    REQUIRE_THROWS_AS(vf.filter(data, tooLong), std::logic_error);
+    REQUIRE_THROWS_AS(vf.filter(frames.data(), frames.data(), STEPS, DIM - 1, FRAME), std::logic_error);
+}
@@ -0,0 +1,96 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+#include "difi"
+#include "doctest/doctest.h"
+#include "doctest_helper.h"
+
+TEST_CASE("Differentiator candidates")
+{
+    for (int order = 1; order <= 2; ++order) {
+        auto designs = difi::differentiatorCandidates<double>(order);
+        REQUIRE(!designs.empty());
+        for (const auto& d : designs) {
+            REQUIRE_EQUAL(d.N, d.bCoeff.size());
+            // A differentiator does not let DC pass through
+            REQUIRE_SMALL(std::abs(d.bCoeff.sum()), 1e-12);
+        }
+    }
+
+    REQUIRE_THROWS_AS(difi::differentiatorCandidates<double>(3), std::logic_error);
+}
+
+TEST_CASE("Differentiator selection")
+{
+    difi::DifferentiatorSpecification<double> spec;
+    spec.samplingFrequency = 1000.;
+    spec.bandwidth = 10.;
+    spec.noiseStd = 1e-5;
+    spec.maxNoiseStd = 0.1;
+    spec.maxDelay = 0.005;
+
+    auto designs = difi::evaluateDifferentiators(spec);
+    auto best = difi::selectDifferentiator(spec);
+    REQUIRE(best.has_value());
+    REQUIRE(best->meets(spec));
+    for (const auto& d : designs) {
+        if (d.N < best->N)
+            REQUIRE(!d.meets(spec));
+    }
+
+    // Noisier signal needs a longer filter
+    spec.noiseStd = 1e-4;
+    auto noisyBest = difi::selectDifferentiator(spec);
+    REQUIRE(noisyBest.has_value());
+    REQUIRE(noisyBest->N > best->N);
+
+    // A backward filter is mandatory when no delay is allowed
+    spec.maxDelay = 0.;
+    auto backwardBest = difi::selectDifferentiator(spec);
+    REQUIRE(backwardBest.has_value());
+    REQUIRE(backwardBest->type == difi::FilterType::Backward);
+
+    // Impossible specifications
+    spec.noiseStd = 1.;
+    REQUIRE(!difi::selectDifferentiator(spec).has_value());
+}
+
+TEST_CASE("Second order differentiator selection")
+{
+    difi::DifferentiatorSpecification<double> spec;
+    spec.samplingFrequency = 1000.;
+    spec.bandwidth = 5.;
+    spec.noiseStd = 1e-6;
+    spec.maxNoiseStd = 10.;
+    spec.maxDelay = 0.01;
+    spec.order = 2;
+
+    auto best = difi::selectDifferentiator(spec);
+    REQUIRE(best.has_value());
+    REQUIRE(best->meets(spec));
+    REQUIRE_EQUAL(best->order, 2);
+}
@@ -78,6 +78,20 @@ TEST_CASE("Coefficient calculation") // Some coeffs are computed, the rest are g
     checkCoeffs<11>(details::GetFNRCoeffs<double, 11>{}(), (vectN_t<double, 11>() << 1., 8., 27., 48., 42., 0., -42., -48., -27., -8., -1.).finished() / 512.);
 }
 
+TEST_CASE("Savitzky-Golay coefficient calculation")
+{
+    // Smoothers
+    checkCoeffs<5>(details::GetCSGCoeffs<double, 5, 2, 0>{}(), (vectN_t<double, 5>() << -3., 12., 17., 12., -3.).finished() / 35.);
+    checkCoeffs<7>(details::GetCSGCoeffs<double, 7, 3, 0>{}(), (vectN_t<double, 7>() << -2., 3., 6., 7., 6., 3., -2.).finished() / 21.);
+    // First derivative of a 2nd order polynome is the low-noise Lanczos differentiator
+    checkCoeffs<5>(details::GetCSGCoeffs<double, 5, 2, 1>{}(), generateLNLCoeffs<5>() / 10.);
+    checkCoeffs<7>(details::GetCSGCoeffs<double, 7, 2, 1>{}(), generateLNLCoeffs<7>() / 28.);
+    // Second derivative
+    checkCoeffs<5>(details::GetCSGCoeffs<double, 5, 2, 2>{}(), (vectN_t<double, 5>() << 2., -1., -2., -1., 2.).finished() / 7.);
+    // Backward first derivative with a line fitting
+    checkCoeffs<3>(details::GetBSGCoeffs<double, 3, 1, 1>{}(), (vectN_t<double, 3>() << 1., 0., -1.).finished() / 2.);
+}
+
 TEST_CASE("Sinus time-fixed central derivative")
 {
     double dt = 0.001;
@@ -148,6 +162,25 @@ TEST_CASE("2nd order sinus time-fixed center derivative")
     tester::run_tests(ct11, std::get<0>(sg), std::get<2>(sg), eps);
 }
 
+TEST_CASE("Polynome time-fixed Savitzky-Golay derivative")
+{
+    double dt = 0.001;
+    auto pg = polyGenerator<double>(STEPS, POLY_4<double>, dt);
+    // A 4th order polynome fitting is exact on POLY_4
+    auto sg = std::tuple<BackwardSavitzkyGolayd<7, 4>, BackwardSavitzkyGolayd<9, 4>, CenteredSavitzkyGolayd<7, 4>, CenteredSavitzkyGolayd<9, 4>>{};
+    tester::set_time_steps(sg, dt);
+
+    difi::vectX_t<double> eps{ 4 };
+    eps << 1e-7, 1e-7, 1e-7, 1e-7;
+    tester::run_tests(sg, std::get<0>(pg), std::get<1>(pg), eps);
+
+    auto sg2 = std::tuple<BackwardSavitzkyGolayd<9, 4, 2>, CenteredSavitzkyGolayd<9, 4, 2>>{};
+    tester::set_time_steps(sg2, dt);
+    eps.resize(2);
+    eps << 1e-3, 1e-3;
+    tester::run_tests(sg2, std::get<0>(pg), std::get<2>(pg), eps);
+}
+
 TEST_CASE("Sinus time-varying central derivative")
 {
     double dt = 0.001;
@@ -189,6 +222,17 @@ TEST_CASE("Polynome time-varying central derivative")
     }
 }
 
+TEST_CASE("Polynome time-varying Savitzky-Golay derivative")
+{
+    double dt = 0.001;
+    auto pg = tvPolyGenerator<double>(STEPS, POLY_4<double>, dt);
+    auto sg = std::tuple<TVBackwardSavitzkyGolayd<7, 4>, TVCenteredSavitzkyGolayd<7, 4>, TVCenteredSavitzkyGolayd<9, 4>>{};
+
+    difi::vectX_t<double> eps{ 3 };
+    eps << 1e-7, 1e-7, 1e-7;
+    tester::run_tests(sg, std::get<0>(pg), std::get<1>(pg), std::get<2>(pg), eps);
+}
+
 // TEST_CASE("2nd order sinus time-varying center derivative", "[tv][sin][center][2nd]")
 // {
 //     // Test not passing.
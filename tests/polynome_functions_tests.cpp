@@ -94,3 +94,119 @@ TEST_CASE_TEMPLATE("Polynome function for complex floating point", T, float, dou
     for (Eigen::Index i = 0; i < res.size(); ++i)
         REQUIRE_SMALL(std::abs(res(i) - s.results(i)), std::numeric_limits<T>::epsilon() * 1000);
 }
+
+TEST_CASE_TEMPLATE("Polynome multiplication", T, float, double, c_t<double>)
+{
+    using real_t = difi::internal::complex_sub_type_t<T>;
+    const difi::vectX_t<T> p = (difi::vectX_t<T>(3) << T(1), T(2), T(3)).finished();
+    const difi::vectX_t<T> q = (difi::vectX_t<T>(2) << T(1), T(-1)).finished();
+    const difi::vectX_t<T> expected = (difi::vectX_t<T>(4) << T(1), T(1), T(1), T(-3)).finished();
+    const difi::vectX_t<T> res = difi::polyMultiply(p, q);
+    REQUIRE(res.size() == expected.size());
+    for (Eigen::Index i = 0; i < res.size(); ++i)
+        REQUIRE_SMALL(std::abs(res(i) - expected(i)), std::numeric_limits<real_t>::epsilon() * 10);
+
+    // The FFT path matches the direct convolution
+    const difi::vectX_t<T> longP = difi::vectX_t<T>::Random(100);
+    const difi::vectX_t<T> longQ = difi::vectX_t<T>::Random(70);
+    const difi::vectX_t<T> fast = difi::polyMultiply(longP, longQ);
+    difi::vectX_t<T> direct = difi::vectX_t<T>::Zero(169);
+    for (Eigen::Index i = 0; i < longP.size(); ++i)
+        direct.segment(i, longQ.size()) += longP(i) * longQ;
+    for (Eigen::Index i = 0; i < direct.size(); ++i)
+        REQUIRE_SMALL(std::abs(fast(i) - direct(i)), std::numeric_limits<real_t>::epsilon() * 1000);
+}
+
+TEST_CASE_TEMPLATE("Polynome division", T, float, double)
+{
+    // x^3 - 2x^2 - 4 = (x - 3)(x^2 + x + 3) + 5
+    const difi::vectX_t<T> num = (difi::vectX_t<T>(4) << T(1), T(-2), T(0), T(-4)).finished();
+    const difi::vectX_t<T> den = (difi::vectX_t<T>(2) << T(1), T(-3)).finished();
+    difi::vectX_t<T> quotient, remainder;
+    difi::polyDivide(num, den, quotient, remainder);
+    REQUIRE(quotient.size() == 3);
+    REQUIRE(remainder.size() == 1);
+    REQUIRE_SMALL(std::abs(quotient(0) - T(1)), std::numeric_limits<T>::epsilon() * 10);
+    REQUIRE_SMALL(std::abs(quotient(1) - T(1)), std::numeric_limits<T>::epsilon() * 10);
+    REQUIRE_SMALL(std::abs(quotient(2) - T(3)), std::numeric_limits<T>::epsilon() * 10);
+    REQUIRE_SMALL(std::abs(remainder(0) - T(5)), std::numeric_limits<T>::epsilon() * 10);
+
+    // num = quotient * den + remainder
+    const difi::vectX_t<T> product = difi::polyMultiply(quotient, den);
+    for (Eigen::Index i = 0; i < num.size() - 1; ++i)
+        REQUIRE_SMALL(std::abs(product(i) - num(i)), std::numeric_limits<T>::epsilon() * 10);
+
+    REQUIRE_THROWS_AS(difi::polyDivide(num, difi::vectX_t<T>::Zero(2).eval(), quotient, remainder), std::logic_error);
+}
+
+TEST_CASE_TEMPLATE("Polynome roots", T, float, double)
+{
+    SystemFloat<T> s;
+    const difi::vectXc_t<T> roots = difi::polyRoots(s.results);
+    REQUIRE(roots.size() == s.data.size());
+    for (Eigen::Index i = 0; i < roots.size(); ++i) {
+        REQUIRE_SMALL(std::abs(roots(i).imag()), std::numeric_limits<T>::epsilon() * 1000);
+        REQUIRE_SMALL((s.data.array() - roots(i).real()).abs().minCoeff(), std::numeric_limits<T>::epsilon() * 1000);
+    }
+
+    // Complex roots come in conjugate pairs, trailing zeros give roots at 0
+    const difi::vectX_t<T> coeffs = (difi::vectX_t<T>(5) << T(1), T(-2), T(2), T(0), T(0)).finished();
+    const difi::vectXc_t<T> complexRoots = difi::polyRoots(coeffs);
+    REQUIRE(complexRoots.size() == 4);
+    REQUIRE(complexRoots(0) == std::conj(complexRoots(1)));
+    REQUIRE_SMALL(std::abs(std::abs(complexRoots(0).imag()) - T(1)), std::numeric_limits<T>::epsilon() * 10);
+    REQUIRE_SMALL(std::abs(complexRoots(0).real() - T(1)), std::numeric_limits<T>::epsilon() * 10);
+    REQUIRE(complexRoots(2) == c_t<T>(0));
+    REQUIRE(complexRoots(3) == c_t<T>(0));
+}
+
+TEST_CASE_TEMPLATE("Polynome from conjugate roots", T, float, double)
+{
+    // Conjugate pairs, a double real root, a root at 0 and an odd number of roots
+    difi::vectXc_t<T> roots(10);
+    roots << c_t<T>(T(-1)), c_t<T>(T(0.5), T(0.3)), c_t<T>(T(0.5), T(-0.3)), c_t<T>(T(0.9)), c_t<T>(T(-0.2), T(-0.7)),
+        c_t<T>(T(-0.2), T(0.7)), c_t<T>(T(-1)), c_t<T>(T(0)), c_t<T>(T(0.1), T(0.95)), c_t<T>(T(0.1), T(-0.95));
+    for (Eigen::Index size : { Eigen::Index(0), Eigen::Index(1), Eigen::Index(4), Eigen::Index(7), Eigen::Index(10) }) {
+        const difi::vectXc_t<T> r = roots.head(size);
+        const difi::vectX_t<T> res = difi::polyCoeffFromConjugateRoots(r);
+        const difi::vectXc_t<T> expected = difi::VietaAlgo<c_t<T>>::polyCoeffFromRoot(r);
+        REQUIRE(res.size() == size + 1);
+        for (Eigen::Index i = 0; i < res.size(); ++i)
+            REQUIRE_SMALL(std::abs(res(i) - expected(i).real()), std::numeric_limits<T>::epsilon() * 100);
+    }
+
+    difi::vectXc_t<T> unpaired(1);
+    unpaired << c_t<T>(T(0.5), T(0.3));
+    REQUIRE_THROWS_AS(difi::polyCoeffFromConjugateRoots(unpaired), std::logic_error);
+}
+
+TEST_CASE_TEMPLATE("Polynome from many conjugate roots", T, float, double)
+{
+    // Poles close to the unit circle, as for high-order filters. The rounding error of each coefficient is
+    // bounded by n eps times the coefficient of the polynome with roots -|r|, computed in long double.
+    using ld_t = std::complex<long double>;
+    for (Eigen::Index n : { Eigen::Index(9), Eigen::Index(64), Eigen::Index(129) }) {
+        difi::vectXc_t<T> roots(n);
+        for (Eigen::Index k = 0; k + 1 < n; k += 2) {
+            roots(k) = std::polar(T(0.98), difi::pi<T> * static_cast<T>(k + 1 + n / 2) / static_cast<T>(2 * n));
+            roots(k + 1) = std::conj(roots(k));
+        }
+        if (n % 2 == 1)
+            roots(n - 1) = c_t<T>(T(-0.98));
+
+        difi::vectXc_t<long double> exact(n);
+        difi::vectXc_t<long double> magnitudes(n);
+        for (Eigen::Index i = 0; i < n; ++i) {
+            exact(i) = ld_t(roots(i).real(), roots(i).imag());
+            magnitudes(i) = ld_t(-std::abs(exact(i)));
+        }
+        const difi::vectXc_t<long double> expected = difi::VietaAlgo<ld_t>::polyCoeffFromRoot(exact);
+        const difi::vectXc_t<long double> bound = difi::VietaAlgo<ld_t>::polyCoeffFromRoot(magnitudes);
+
+        const difi::vectX_t<T> res = difi::polyCoeffFromConjugateRoots(roots);
+        REQUIRE(res.size() == n + 1);
+        const long double eps = static_cast<long double>(n) * std::numeric_limits<T>::epsilon();
+        for (Eigen::Index i = 0; i <= n; ++i)
+            REQUIRE(std::abs(static_cast<long double>(res(i)) - expected(i).real()) <= eps * bound(i).real());
+    }
+}
@@ -32,8 +32,8 @@
 #include "doctest_helper.h"
 #include <limits>
 
-template <typename T>
-void test_coeffs(const difi::vectX_t<T>& aCoeff, const difi::vectX_t<T>& bCoeff, const difi::GenericFilter<T>& filter, T prec)
+template <typename T, typename Accumulator>
+void test_coeffs(const difi::vectX_t<T>& aCoeff, const difi::vectX_t<T>& bCoeff, const difi::GenericFilter<T, Accumulator>& filter, T prec)
 {
     REQUIRE_EQUAL(aCoeff.size(), filter.aOrder());
     REQUIRE_EQUAL(bCoeff.size(), filter.bOrder());
@@ -45,8 +45,8 @@ void test_coeffs(const difi::vectX_t<T>& aCoeff, const difi::vectX_t<T>& bCoeff,
         REQUIRE_SMALL(std::abs(bCoeff(i) - fbCoeff(i)), prec);
 }
 
-template <typename T>
-void test_results(const difi::vectX_t<T>& results, const difi::vectX_t<T>& data, difi::GenericFilter<T>& filter, T prec)
+template <typename T, typename Accumulator>
+void test_results(const difi::vectX_t<T>& results, const difi::vectX_t<T>& data, difi::GenericFilter<T, Accumulator>& filter, T prec)
 {
     difi::vectX_t<T> filteredData(results.size());
 
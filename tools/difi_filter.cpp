@@ -0,0 +1,461 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+// Stream raw binary or CSV signals through a chain of filters.
+// Binary files are memory-mapped and filtered block by block, directly from the input mapping to the output mapping.
+
+#include "difi"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+enum class Format {
+    F32,
+    F64,
+    Csv
+};
+
+struct Options {
+    Format format = Format::F64;
+    int channels = 0; // 0: 1 for binary files, number of columns for CSV files
+    double fs = 1;
+    std::size_t blockFrames = 4096;
+    std::string chain;
+    std::string input;
+    std::string output;
+};
+
+void printUsage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " [options] chain input output\n"
+              << "  chain   Filters separated by '|', e.g. \"butter:lp:4:50:1000 | cnr2:9\"\n"
+              << "  input   Input file, or - for the standard input\n"
+              << "  output  Output file, or - for the standard output\n"
+              << "Options:\n"
+              << "  -f, --format f32|f64|csv  Raw interleaved float32/float64 samples or CSV (default f64)\n"
+              << "  -c, --channels N          Number of interleaved channels (default 1, or the CSV columns)\n"
+              << "  --fs F                    Sampling frequency of the differentiators (default 1)\n"
+              << "  --block N                 Number of frames filtered at once (default 4096)\n"
+              << "Filters:\n"
+              << "  butter:lp|hp:order:fc:fs           Butterworth low-pass or high-pass filter\n"
+              << "  butter:bp|br:order:fLow:fHigh:fs   Butterworth band-pass or band-reject filter\n"
+              << "  ma:window                          Moving average\n"
+              << "  digital:a0,a1,...:b0,b1,...        Digital filter\n"
+              << "  bank:path:index                    Design of a coefficient bank\n"
+              << "  name:N                             Differentiator of N taps, name being one of\n"
+              << "    bnr, bhnr, bsg1, bsg2, cd, lnl, slnl, cnr2, cnr4, csg4 (first order)\n"
+              << "    bso, bsg22, cso, csg22 (second order)\n";
+}
+
+std::vector<std::string> split(const std::string& s, char sep)
+{
+    std::vector<std::string> fields;
+    std::size_t start = 0;
+    while (true) {
+        const std::size_t end = s.find(sep, start);
+        fields.push_back(s.substr(start, end - start));
+        if (end == std::string::npos)
+            return fields;
+        start = end + 1;
+    }
+}
+
+std::string trim(const std::string& s)
+{
+    const std::size_t first = s.find_first_not_of(" \t");
+    if (first == std::string::npos)
+        return {};
+    return s.substr(first, s.find_last_not_of(" \t") - first + 1);
+}
+
+template <typename T>
+difi::vectX_t<T> parseVector(const std::string& s)
+{
+    const auto fields = split(s, ',');
+    difi::vectX_t<T> v(static_cast<Eigen::Index>(fields.size()));
+    for (std::size_t i = 0; i < fields.size(); ++i)
+        v(static_cast<Eigen::Index>(i)) = static_cast<T>(std::stod(fields[i]));
+    return v;
+}
+
+struct DifferentiatorAlias {
+    const char* alias;
+    const char* name; // Name given by differentiatorCandidates
+    int order;
+};
+
+const DifferentiatorAlias DIFFERENTIATORS[] = {
+    { "bnr", "BackwardDiffNoiseRobust<T, N>", 1 },
+    { "bhnr", "BackwardDiffHybridNoiseRobust<T, N>", 1 },
+    { "bsg1", "BackwardSavitzkyGolay<T, N, 1>", 1 },
+    { "bsg2", "BackwardSavitzkyGolay<T, N, 2>", 1 },
+    { "cd", "CenteredDiffBasic<T, N>", 1 },
+    { "lnl", "CenteredDiffLowNoiseLanczos<T, N>", 1 },
+    { "slnl", "CenteredDiffSuperLowNoiseLanczos<T, N>", 1 },
+    { "cnr2", "CenteredDiffNoiseRobust2<T, N>", 1 },
+    { "cnr4", "CenteredDiffNoiseRobust4<T, N>", 1 },
+    { "csg4", "CenteredSavitzkyGolay<T, N, 4>", 1 },
+    { "bso", "BackwardDiffSecondOrder<T, N>", 2 },
+    { "bsg22", "BackwardSavitzkyGolay<T, N, 2, 2>", 2 },
+    { "cso", "CenteredDiffSecondOrder<T, N>", 2 },
+    { "csg22", "CenteredSavitzkyGolay<T, N, 2, 2>", 2 },
+};
+
+void expectFields(const std::vector<std::string>& f, std::size_t size, const std::string& stage)
+{
+    if (f.size() != size)
+        throw std::invalid_argument("Wrong number of parameters for filter '" + stage + "'");
+}
+
+/*! \brief Build one stage of the chain. All stages are digital filters sharing the coefficients of their design. */
+template <typename T>
+difi::DigitalFilter<T> makeStage(const std::string& stage, T fs)
+{
+    const auto f = split(stage, ':');
+    const std::string& kind = f[0];
+    if (kind == "butter") {
+        using Type = typename difi::Butterworth<T>::Type;
+        if (f.size() > 1 && (f[1] == "lp" || f[1] == "hp")) {
+            expectFields(f, 5, stage);
+            const difi::Butterworth<T> bf(std::stoi(f[2]), static_cast<T>(std::stod(f[3])), static_cast<T>(std::stod(f[4])), f[1] == "lp" ? Type::LowPass : Type::HighPass);
+            return difi::DigitalFilter<T>(bf.coefficients(), bf.type());
+        } else if (f.size() > 1 && (f[1] == "bp" || f[1] == "br")) {
+            expectFields(f, 6, stage);
+            const difi::Butterworth<T> bf(std::stoi(f[2]), static_cast<T>(std::stod(f[3])), static_cast<T>(std::stod(f[4])), static_cast<T>(std::stod(f[5])), f[1] == "bp" ? Type::BandPass : Type::BandReject);
+            return difi::DigitalFilter<T>(bf.coefficients(), bf.type());
+        }
+    } else if (kind == "ma") {
+        expectFields(f, 2, stage);
+        const difi::MovingAverage<T> ma(std::stoi(f[1]));
+        return difi::DigitalFilter<T>(ma.coefficients(), ma.type());
+    } else if (kind == "digital") {
+        expectFields(f, 3, stage);
+        return difi::DigitalFilter<T>(parseVector<T>(f[1]), parseVector<T>(f[2]));
+    } else if (kind == "bank") {
+        expectFields(f, 3, stage);
+        const auto bank = difi::CoefficientBank<T>::open(f[1]);
+        const std::size_t index = std::stoul(f[2]);
+        return difi::DigitalFilter<T>(bank->coefficients(index), bank->type(index));
+    } else {
+        for (const auto& d : DIFFERENTIATORS) {
+            if (kind != d.alias)
+                continue;
+            expectFields(f, 2, stage);
+            const int N = std::stoi(f[1]);
+            std::string name = d.name;
+            name.replace(name.find(", N"), 3, ", " + std::to_string(N));
+            for (const auto& design : difi::differentiatorCandidates<T>(d.order)) {
+                if (design.name == name)
+                    return difi::DigitalFilter<T>(difi::vectX_t<T>::Ones(1), design.bCoeff * std::pow(fs, d.order), design.type);
+            }
+            throw std::invalid_argument("No " + std::to_string(N) + "-tap version of differentiator '" + kind + "'");
+        }
+    }
+    throw std::invalid_argument("Unknown filter '" + stage + "'");
+}
+
+/*! \brief Independent copies of the chain for each channel of an interleaved signal. */
+template <typename T>
+class Pipeline {
+public:
+    Pipeline(const std::string& chain, int channels, T fs)
+        : m_channels(channels)
+    {
+        std::vector<difi::DigitalFilter<T>> stages;
+        for (const auto& stage : split(chain, '|'))
+            stages.push_back(makeStage<T>(trim(stage), fs));
+        m_stages.assign(static_cast<std::size_t>(channels), stages);
+    }
+
+    /*! \brief Filter interleaved frames. The input and the output can be the same. */
+    void process(const T* in, T* out, std::size_t frames)
+    {
+        const auto C = static_cast<Eigen::Index>(m_channels);
+        const auto n = static_cast<Eigen::Index>(frames);
+        // Each channel is filtered in place in the output, through its stride
+        for (Eigen::Index c = 0; c < C; ++c) {
+            const T* src = in + c;
+            for (auto& stage : m_stages[static_cast<std::size_t>(c)]) {
+                stage.filter(src, out + c, n, C, C);
+                src = out + c;
+            }
+        }
+    }
+
+    int channels() const noexcept { return m_channels; }
+
+private:
+    int m_channels;
+    std::vector<std::vector<difi::DigitalFilter<T>>> m_stages;
+};
+
+struct FileCloser {
+    void operator()(std::FILE* file) const noexcept
+    {
+        if (file != stdin && file != stdout)
+            std::fclose(file);
+    }
+};
+
+using File = std::unique_ptr<std::FILE, FileCloser>;
+
+/*! \brief Return true if both paths name the same existing file.
+ *
+ * The output is truncated before the input is read, so filtering a file into itself would erase it.
+ */
+bool isSameFile(const std::string& input, const std::string& output)
+{
+    if (input == "-" || output == "-")
+        return false;
+#if DIFI_HAS_MMAP
+    struct stat inStat;
+    struct stat outStat;
+    return ::stat(input.c_str(), &inStat) == 0 && ::stat(output.c_str(), &outStat) == 0
+        && inStat.st_dev == outStat.st_dev && inStat.st_ino == outStat.st_ino;
+#else
+    return input == output;
+#endif
+}
+
+File openFile(const std::string& path, bool isOutput)
+{
+    if (path == "-")
+        return File(isOutput ? stdout : stdin);
+    File file(std::fopen(path.c_str(), isOutput ? "wb" : "rb"));
+    if (!file)
+        throw std::runtime_error("Can't open '" + path + "'");
+    return file;
+}
+
+template <typename T>
+void runBinary(const Options& opt)
+{
+    const int channels = opt.channels > 0 ? opt.channels : 1;
+    Pipeline<T> pipeline(opt.chain, channels, static_cast<T>(opt.fs));
+    const std::size_t frameSize = sizeof(T) * static_cast<std::size_t>(channels);
+    const std::size_t block = opt.blockFrames;
+
+    if (opt.input != "-") {
+        const difi::details::MappedFile in(opt.input);
+        if (in.size() % frameSize != 0)
+            throw std::runtime_error("The input size is not a multiple of the frame size");
+        const std::size_t frames = in.size() / frameSize;
+        const T* src = reinterpret_cast<const T*>(in.data());
+        if (opt.output != "-") {
+            // Zero-copy: from the input mapping to the output mapping
+            difi::details::MappedOutputFile out(opt.output, in.size());
+            T* dst = reinterpret_cast<T*>(out.data());
+            for (std::size_t f = 0; f < frames; f += block)
+                pipeline.process(src + f * channels, dst + f * channels, std::min(block, frames - f));
+            return;
+        }
+        std::vector<T> buffer(block * channels);
+        for (std::size_t f = 0; f < frames; f += block) {
+            const std::size_t n = std::min(block, frames - f);
+            pipeline.process(src + f * channels, buffer.data(), n);
+            if (std::fwrite(buffer.data(), frameSize, n, stdout) != n)
+                throw std::runtime_error("Can't write the output");
+        }
+        return;
+    }
+
+    // Streamed input, read and written by large blocks
+    File in = openFile(opt.input, false);
+    File out = openFile(opt.output, true);
+    std::vector<T> buffer(block * channels);
+    std::size_t n;
+    while ((n = std::fread(buffer.data(), frameSize, block, in.get())) > 0) {
+        pipeline.process(buffer.data(), buffer.data(), n);
+        if (std::fwrite(buffer.data(), frameSize, n, out.get()) != n)
+            throw std::runtime_error("Can't write the output");
+    }
+}
+
+/*! \brief Parse a CSV line. Return false if a field is not a number. */
+bool parseLine(const char* line, std::vector<double>& values)
+{
+    values.clear();
+    const char* p = line;
+    while (true) {
+        char* end;
+        const double v = std::strtod(p, &end);
+        if (end == p)
+            return false;
+        values.push_back(v);
+        while (*end == ' ' || *end == '\t' || *end == '\r')
+            ++end;
+        if (*end == '\0')
+            return true;
+        if (*end != ',' && *end != ';')
+            return false;
+        p = end + 1;
+    }
+}
+
+void runCsv(const Options& opt)
+{
+    File in = openFile(opt.input, false);
+    File out = openFile(opt.output, true);
+    std::vector<char> inBuffer(1 << 20);
+    std::vector<char> outBuffer(1 << 20);
+    std::setvbuf(in.get(), inBuffer.data(), _IOFBF, inBuffer.size());
+    std::setvbuf(out.get(), outBuffer.data(), _IOFBF, outBuffer.size());
+
+    std::unique_ptr<Pipeline<double>> pipeline;
+    std::vector<double> block;
+    std::vector<double> values;
+    std::size_t channels = 0;
+    const auto flush = [&]() {
+        const std::size_t frames = block.size() / channels;
+        pipeline->process(block.data(), block.data(), frames);
+        for (std::size_t f = 0; f < frames; ++f) {
+            for (std::size_t c = 0; c < channels; ++c)
+                std::fprintf(out.get(), c + 1 < channels ? "%.17g," : "%.17g\n", block[f * channels + c]);
+        }
+        block.clear();
+    };
+
+    std::string line;
+    std::size_t lineNumber = 0;
+    int ch;
+    while (true) {
+        line.clear();
+        while ((ch = std::fgetc(in.get())) != EOF && ch != '\n')
+            line.push_back(static_cast<char>(ch));
+        if (ch == EOF && line.empty())
+            break;
+        ++lineNumber;
+        if (trim(line).empty())
+            continue;
+
+        if (!parseLine(line.c_str(), values)) {
+            // A header is copied
+            if (pipeline)
+                throw std::runtime_error("Invalid number at line " + std::to_string(lineNumber));
+            std::fprintf(out.get(), "%s\n", line.c_str());
+            continue;
+        }
+        if (!pipeline) {
+            channels = opt.channels > 0 ? static_cast<std::size_t>(opt.channels) : values.size();
+            pipeline = std::make_unique<Pipeline<double>>(opt.chain, static_cast<int>(channels), opt.fs);
+            block.reserve(opt.blockFrames * channels);
+        }
+        if (values.size() != channels)
+            throw std::runtime_error("Wrong number of columns at line " + std::to_string(lineNumber));
+        block.insert(block.end(), values.begin(), values.end());
+        if (block.size() == opt.blockFrames * channels)
+            flush();
+    }
+    if (pipeline && !block.empty())
+        flush();
+    std::fflush(out.get());
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    std::vector<std::string> args;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const auto value = [&]() -> std::string {
+                if (i + 1 >= argc)
+                    throw std::invalid_argument("Missing value of " + arg);
+                return argv[++i];
+            };
+            if (arg == "-h" || arg == "--help") {
+                printUsage(argv[0]);
+                return EXIT_SUCCESS;
+            } else if (arg == "-f" || arg == "--format") {
+                const std::string format = value();
+                if (format == "f32")
+                    opt.format = Format::F32;
+                else if (format == "f64")
+                    opt.format = Format::F64;
+                else if (format == "csv")
+                    opt.format = Format::Csv;
+                else
+                    throw std::invalid_argument("Unknown format '" + format + "'");
+            } else if (arg == "-c" || arg == "--channels") {
+                opt.channels = std::stoi(value());
+                if (opt.channels <= 0)
+                    throw std::invalid_argument("The number of channels must be positive");
+            } else if (arg == "--fs") {
+                opt.fs = std::stod(value());
+            } else if (arg == "--block") {
+                opt.blockFrames = std::stoul(value());
+                if (opt.blockFrames == 0)
+                    throw std::invalid_argument("The block size must be positive");
+            } else
+                args.push_back(arg);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid options: " << e.what() << "\n";
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (args.size() != 3) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    opt.chain = args[0];
+    opt.input = args[1];
+    opt.output = args[2];
+
+    try {
+        if (isSameFile(opt.input, opt.output))
+            throw std::invalid_argument("The input and output must be different files");
+        switch (opt.format) {
+        case Format::F32:
+            runBinary<float>(opt);
+            break;
+        case Format::F64:
+            runBinary<double>(opt);
+            break;
+        case Format::Csv:
+            runCsv(opt);
+            break;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
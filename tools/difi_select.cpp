@@ -0,0 +1,111 @@
+// Copyright (c) 2019, Vincent SAMY
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The views and conclusions contained in the software and documentation are those
+// of the authors and should not be interpreted as representing official policies,
+// either expressed or implied, of the FreeBSD Project.
+
+// Select the cheapest fixed time-step differentiator meeting a noise/bandwidth specification.
+
+#include "difi"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void printUsage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " fs bandwidth noiseStd maxNoiseStd maxDelay [maxBandError=0.05] [order=1] [--all]\n"
+              << "  fs           Sampling frequency (Hz)\n"
+              << "  bandwidth    Highest frequency of interest of the signal (Hz)\n"
+              << "  noiseStd     Standard deviation of the noise on the signal\n"
+              << "  maxNoiseStd  Maximum standard deviation of the noise on the derivative\n"
+              << "  maxDelay     Maximum delay of the derivative (s)\n"
+              << "  maxBandError Maximum relative error of the derivative within the bandwidth\n"
+              << "  order        Derivative order (1 or 2)\n"
+              << "  --all        Print the evaluation of all the differentiators\n";
+}
+
+void printDesign(const difi::DifferentiatorDesign<double>& d)
+{
+    std::cout << d.name << ": taps=" << d.N << ", delay=" << d.delay << "s, noiseStd=" << d.noiseStd << ", bandError=" << d.bandError << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bool printAll = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--all")
+            printAll = true;
+        else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return EXIT_SUCCESS;
+        } else
+            args.push_back(arg);
+    }
+
+    if (args.size() < 5 || args.size() > 7) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    difi::DifferentiatorSpecification<double> spec;
+    try {
+        spec.samplingFrequency = std::stod(args[0]);
+        spec.bandwidth = std::stod(args[1]);
+        spec.noiseStd = std::stod(args[2]);
+        spec.maxNoiseStd = std::stod(args[3]);
+        spec.maxDelay = std::stod(args[4]);
+        if (args.size() > 5)
+            spec.maxBandError = std::stod(args[5]);
+        if (args.size() > 6)
+            spec.order = std::stoi(args[6]);
+
+        if (printAll) {
+            for (const auto& d : difi::evaluateDifferentiators(spec)) {
+                std::cout << (d.meets(spec) ? "[ok] " : "[--] ");
+                printDesign(d);
+            }
+            std::cout << "\n";
+        }
+
+        auto best = difi::selectDifferentiator(spec);
+        if (!best) {
+            std::cerr << "No differentiator meets the specifications.\n";
+            return EXIT_FAILURE;
+        }
+        printDesign(*best);
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid specifications: " << e.what() << "\n";
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}